@@ -12,3 +12,19 @@ ${CXX} -Iinclude/ -nostdinc++ -Ilibcxx-variant/include/   -std=c++1z ${FLAGS} st
 ${CXX} -Iinclude/ -I../include/                           -std=c++11 ${FLAGS} strict_variant.cpp
 ${CXX} -Iinclude/ -I/usr/include/                         -std=c++11 ${FLAGS} boost_variant.cpp
 ${CXX} -Iinclude/ -Impark_variant/include/                -std=c++14 ${FLAGS} exp_variant.cpp
+
+# Optimizer hints: the version with STRICT_VARIANT_OPTIMIZER_HINTS should have
+# no bounds checks on `which`, and `get_unchecked` should never branch.
+
+HINT_FLAGS="-O3 -S -fno-asynchronous-unwind-tables"
+
+${CXX} -Iinclude/ -I../include/ -std=c++11 ${HINT_FLAGS} optimizer_hints.cpp -o optimizer_hints.s
+${CXX} -Iinclude/ -I../include/ -std=c++11 ${HINT_FLAGS} -DSTRICT_VARIANT_OPTIMIZER_HINTS optimizer_hints.cpp -o optimizer_hints_on.s
+
+count_branches() {
+  grep -E '^\s+j[a-z]+\s' "$1" | grep -vc 'jmp'
+}
+
+echo "conditional branches without hints: " $(count_branches optimizer_hints.s)
+echo "conditional branches with hints:    " $(count_branches optimizer_hints_on.s)
+diff optimizer_hints.s optimizer_hints_on.s
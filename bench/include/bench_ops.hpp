@@ -0,0 +1,48 @@
+#pragma once
+
+#include "bench_api.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+
+namespace benchmark {
+
+/***
+ * To make benchmarks of particular operations, such as comparison or hashing,
+ * over a batch of variants.
+ */
+
+// Calls `task()` `repeat_num` times, where each call processes
+// `items_per_call` items, and reports the average time per item.
+// Returns the average nanoseconds per item.
+template <typename Task, typename ClockType = std::chrono::high_resolution_clock>
+double
+run_operation(const char * name, uint32_t items_per_call, uint32_t repeat_num, Task && task) {
+  std::fprintf(stdout, "%s:\n  items = %u\n  repeat_num = %u\n\n", name, items_per_call,
+               repeat_num);
+
+  benchmark::ClobberMemory();
+
+  auto const start = ClockType::now();
+
+  for (uint32_t count{repeat_num}; count; --count) {
+    benchmark::DoNotOptimize(std::forward<Task>(task)());
+    benchmark::ClobberMemory();
+  }
+
+  auto const end = ClockType::now();
+
+  benchmark::ClobberMemory();
+
+  unsigned long us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  double ns_per_item =
+    (static_cast<double>(us) / (static_cast<double>(items_per_call) * repeat_num)) * 1000;
+
+  std::fprintf(stdout, "took %lu microseconds\n", us);
+  std::fprintf(stdout, "average nanoseconds per item: %f\n\n\n", ns_per_item);
+  return ns_per_item;
+}
+
+} // end namespace benchmark
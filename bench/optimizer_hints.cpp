@@ -0,0 +1,41 @@
+#include <strict_variant/variant.hpp>
+
+#include <cstdint>
+
+/***
+ * Small functions used to compare the code generated with and without
+ * STRICT_VARIANT_OPTIMIZER_HINTS. See `generate_asm.sh`.
+ */
+
+using var_t = strict_variant::variant<int32_t, uint32_t, float, double>;
+
+struct to_double {
+  double operator()(int32_t i) const { return i; }
+  double operator()(uint32_t u) const { return u; }
+  double operator()(float f) const { return f; }
+  double operator()(double d) const { return d; }
+};
+
+double
+visit_to_double(const var_t & v) {
+  return strict_variant::apply_visitor(to_double{}, v);
+}
+
+// The bounds check should disappear when hints are on
+const char *
+type_name(const var_t & v) {
+  static const char * const names[] = {"int32_t", "uint32_t", "float", "double"};
+  return static_cast<unsigned>(v.which()) < 4 ? names[v.which()] : "unknown";
+}
+
+// The null check of `get` should be absent from the unchecked version
+double
+get_checked(const var_t & v) {
+  const double * d = strict_variant::get<double>(&v);
+  return d ? *d : 0;
+}
+
+double
+get_unchecked(const var_t & v) {
+  return strict_variant::get_unchecked<double>(v);
+}
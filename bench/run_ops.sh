@@ -0,0 +1,23 @@
+#!/bin/bash
+
+set -e
+
+rm -rf bin
+rm -rf stage_ops
+
+if hash b2 2>/dev/null; then
+  b2 install-ops-bin "$@"
+elif hash bjam 2>/dev/null; then
+  bjam install-ops-bin "$@"
+else
+  echo >&2 "Require b2 or bjam but it was not found. Aborting."
+  exit 1
+fi
+
+set +e
+
+for file in stage_ops/*
+do
+  echo ${file} "..."
+  ${file}
+done
@@ -0,0 +1,114 @@
+#include "bench_ops.hpp"
+#include <strict_variant/alloc_wrapper.hpp>
+#include <strict_variant/arena_wrapper.hpp>
+#include <strict_variant/pool_allocator.hpp>
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/***
+ * Parses expressions from prefix notation into trees of variants, evaluates
+ * them, and frees them, with nodes in `recursive_wrapper`, in `alloc_wrapper`
+ * with `pool_allocator`, and in `arena_wrapper`, for which the arena is
+ * released after each tree.
+ */
+
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t num_ops{1u << 16};
+static constexpr int32_t op_token{-1};
+
+// A random expression in prefix notation, in which `op_token` is an operator
+// with two operands, and other tokens are numbers
+std::vector<int32_t>
+make_tokens() {
+  std::mt19937 rng{RNG_SEED};
+  std::vector<int32_t> tokens;
+  uint32_t pending = 1;
+  uint32_t ops = 0;
+  while (pending) {
+    if (ops < num_ops && (rng() % 2 || pending < 2)) {
+      tokens.push_back(op_token);
+      ++ops;
+      ++pending;
+    } else {
+      tokens.push_back(static_cast<int32_t>(rng() % 100));
+      --pending;
+    }
+  }
+  return tokens;
+}
+
+template <template <typename> class Wrapper>
+struct ast {
+  struct node;
+  using expr_t = strict_variant::variant<int32_t, Wrapper<node>>;
+
+  struct node {
+    expr_t lhs;
+    expr_t rhs;
+  };
+
+  // Moving a variant moves the value in the wrapper, so nodes are parsed
+  // into place
+  static const int32_t * parse(const int32_t * token, expr_t & out) {
+    if (*token != op_token) {
+      out = *token;
+      return token + 1;
+    }
+    out.template emplace<node>(node{expr_t{0}, expr_t{0}});
+    node * n = strict_variant::get<node>(&out);
+    return parse(parse(token + 1, n->lhs), n->rhs);
+  }
+
+  struct eval {
+    int64_t operator()(int32_t i) const { return i; }
+    int64_t operator()(const node & n) const {
+      return strict_variant::apply_visitor(*this, n.lhs)
+             - strict_variant::apply_visitor(*this, n.rhs);
+    }
+  };
+};
+
+template <typename T>
+using pool_wrapper = strict_variant::alloc_wrapper<T, strict_variant::pool_allocator<T>>;
+
+template <typename T>
+using thread_arena_wrapper = strict_variant::arena_wrapper<T>;
+
+template <template <typename> class Wrapper, typename Release>
+void
+bench(const char * label, const std::vector<int32_t> & tokens, Release && release) {
+  using ast_t = ast<Wrapper>;
+  int64_t sum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t r = 0; r < repeat_num; ++r) {
+    {
+      typename ast_t::expr_t tree{0};
+      ast_t::parse(tokens.data(), tree);
+      sum += strict_variant::apply_visitor(typename ast_t::eval{}, tree);
+    }
+    release();
+  }
+  const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+  benchmark::DoNotOptimize(sum);
+
+  const uint64_t items = uint64_t{num_ops} * repeat_num;
+  std::fprintf(stdout, "%s:\n  items = %lu\n\naverage nanoseconds per item: %f\n\n\n", label,
+               static_cast<unsigned long>(items),
+               static_cast<double>(elapsed.count()) / static_cast<double>(items));
+}
+
+int
+main() {
+  const std::vector<int32_t> tokens = make_tokens();
+
+  bench<strict_variant::recursive_wrapper>("recursive_wrapper", tokens, []() {});
+  bench<pool_wrapper>("alloc_wrapper with pool_allocator", tokens, []() {});
+  bench<thread_arena_wrapper>("arena_wrapper", tokens,
+                              []() { strict_variant::thread_arena::get().release(); });
+}
@@ -0,0 +1,116 @@
+#include "bench_ops.hpp"
+#include <strict_variant/atomic_variant.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***
+ * Reading a shared variant from several threads while one thread keeps
+ * replacing it, through `atomic_variant`, and through a variant guarded by a
+ * `std::mutex`. Measured for a variant which fits in a word, and so is
+ * lock-free, and one which needs a seqlock.
+ *
+ * Reports the wall time per load, over all of the readers, and the number of
+ * stores the writer completed meanwhile.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint64_t loads_per_reader{uint64_t{seq_length} * repeat_num / 4};
+
+enum class Mode : uint8_t { off, on, automatic };
+
+struct limits {
+  int64_t low;
+  int64_t high;
+  int64_t step;
+};
+
+using small_t = strict_variant::variant<int32_t, float, Mode>;
+using large_t = strict_variant::variant<int32_t, limits>;
+
+small_t
+make_value(small_t *, uint64_t i) {
+  return i % 2 ? small_t{static_cast<int32_t>(i)} : small_t{static_cast<float>(i)};
+}
+
+large_t
+make_value(large_t *, uint64_t i) {
+  const int64_t x = static_cast<int64_t>(i);
+  return i % 2 ? large_t{static_cast<int32_t>(i)} : large_t{limits{x, x + 1, x + 2}};
+}
+
+template <typename V>
+class locked {
+  mutable std::mutex m_mutex;
+  V m_value;
+
+public:
+  explicit locked(const V & v)
+    : m_value(v) {}
+
+  V load() const {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    return m_value;
+  }
+
+  void store(const V & v) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_value = v;
+  }
+};
+
+template <typename Cell, typename V>
+void
+bench(const char * label, unsigned num_readers) {
+  Cell cell{make_value(static_cast<V *>(nullptr), 0)};
+  std::atomic<unsigned> reading{num_readers};
+  uint64_t stores = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> readers;
+  for (unsigned t = 0; t < num_readers; ++t) {
+    readers.emplace_back([&]() {
+      unsigned which = 0;
+      for (uint64_t i = 0; i < loads_per_reader; ++i) {
+        which += static_cast<unsigned>(cell.load().which());
+      }
+      benchmark::DoNotOptimize(which);
+      --reading;
+    });
+  }
+  while (reading.load()) {
+    cell.store(make_value(static_cast<V *>(nullptr), ++stores));
+  }
+  for (std::thread & t : readers) {
+    t.join();
+  }
+  const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+
+  const uint64_t loads = loads_per_reader * num_readers;
+  std::fprintf(stdout,
+               "%s, %u readers:\n  items = %lu\n  stores = %lu\n\naverage nanoseconds per item: "
+               "%f\n\n\n",
+               label, num_readers, static_cast<unsigned long>(loads),
+               static_cast<unsigned long>(stores),
+               static_cast<double>(elapsed.count()) / static_cast<double>(loads));
+}
+
+int
+main() {
+  for (unsigned readers : {1u, 2u, 4u}) {
+    bench<strict_variant::atomic_variant<int32_t, float, Mode>, small_t>("atomic_variant, small",
+                                                                          readers);
+    bench<locked<small_t>, small_t>("mutex, small", readers);
+    bench<strict_variant::atomic_variant<int32_t, limits>, large_t>("atomic_variant, seqlock",
+                                                                    readers);
+    bench<locked<large_t>, large_t>("mutex, large", readers);
+  }
+}
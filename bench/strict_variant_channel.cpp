@@ -0,0 +1,189 @@
+#include "bench_ops.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_channel.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***
+ * Passing messages from several producer threads to one consumer thread,
+ * through a `channel` drained with `drain` and with `drain_grouped`, and
+ * through a `std::deque` guarded by a `std::mutex`, which the consumer swaps
+ * out and then visits.
+ *
+ * Reports the wall time per message, and the latency from sending a message
+ * to handling it, for a sample of the messages.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint64_t num_messages{uint64_t{seq_length} * repeat_num};
+
+using clock_type = std::chrono::steady_clock;
+
+int64_t
+now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch())
+    .count();
+}
+
+struct new_order {
+  int64_t sent;
+  uint64_t id;
+  double price;
+  uint32_t quantity;
+};
+
+struct cancel {
+  int64_t sent;
+  uint64_t id;
+};
+
+struct heartbeat {
+  int64_t sent;
+};
+
+using msg_t = strict_variant::variant<new_order, cancel, heartbeat>;
+
+// Sums the messages, and samples the latency of one in 16
+struct handler {
+  uint64_t sum = 0;
+  uint64_t count = 0;
+  std::vector<int64_t> latencies;
+
+  void sample(int64_t sent) {
+    if (!(count++ & 15)) { latencies.push_back(now() - sent); }
+  }
+
+  void operator()(const new_order & o) {
+    sum += o.id + o.quantity;
+    this->sample(o.sent);
+  }
+  void operator()(const cancel & c) {
+    sum += c.id;
+    this->sample(c.sent);
+  }
+  void operator()(const heartbeat & h) { this->sample(h.sent); }
+};
+
+struct channel_sender {
+  strict_variant::channel<msg_t> & c;
+
+  template <typename T>
+  void operator()(const T & t) const {
+    c.emplace<T>(t);
+  }
+};
+
+struct deque_sender {
+  std::mutex & mutex;
+  std::deque<msg_t> & queue;
+
+  template <typename T>
+  void operator()(const T & t) const {
+    std::lock_guard<std::mutex> lock{mutex};
+    queue.emplace_back(t);
+  }
+};
+
+// Producer `p` sends messages p, p + n, p + 2n, ...
+template <typename Send>
+void
+produce(unsigned p, unsigned n, Send && send) {
+  for (uint64_t i = p; i < num_messages; i += n) {
+    switch (i % 8) {
+      case 0:
+        send(cancel{now(), i});
+        break;
+      case 1:
+        send(heartbeat{now()});
+        break;
+      default:
+        send(new_order{now(), i, 1.5, static_cast<uint32_t>(i & 127)});
+        break;
+    }
+  }
+}
+
+void
+report(const char * label, unsigned producers, clock_type::time_point start, handler & h) {
+  const std::chrono::nanoseconds elapsed = clock_type::now() - start;
+  std::sort(h.latencies.begin(), h.latencies.end());
+  const std::size_t n = h.latencies.size();
+  std::fprintf(stdout,
+               "%s, %u producers:\n  items = %lu\n  latency p50 = %ld ns, p99 = %ld ns\n\n"
+               "average nanoseconds per item: %f\n\n\n",
+               label, producers, static_cast<unsigned long>(h.count),
+               static_cast<long>(h.latencies[n / 2]), static_cast<long>(h.latencies[n * 99 / 100]),
+               static_cast<double>(elapsed.count()) / static_cast<double>(h.count));
+}
+
+void
+bench_channel(bool grouped, unsigned producers) {
+  strict_variant::channel<msg_t> c{1024};
+  handler h;
+  h.latencies.reserve(num_messages / 16 + 1);
+
+  const auto start = clock_type::now();
+  std::vector<std::thread> threads;
+  for (unsigned p = 0; p < producers; ++p) {
+    threads.emplace_back([&c, p, producers]() { produce(p, producers, channel_sender{c}); });
+  }
+  unsigned spins = 0;
+  while (h.count < num_messages) {
+    const std::size_t n = grouped ? c.drain_grouped(h) : c.drain(h);
+    if (!n) { strict_variant::detail::spin_wait(spins); }
+  }
+  for (std::thread & t : threads) {
+    t.join();
+  }
+  report(grouped ? "channel, drain_grouped" : "channel, drain", producers, start, h);
+}
+
+void
+bench_deque(unsigned producers) {
+  std::mutex mutex;
+  std::deque<msg_t> queue;
+  handler h;
+  h.latencies.reserve(num_messages / 16 + 1);
+
+  const auto start = clock_type::now();
+  std::vector<std::thread> threads;
+  for (unsigned p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p]() { produce(p, producers, deque_sender{mutex, queue}); });
+  }
+  std::deque<msg_t> local;
+  unsigned spins = 0;
+  while (h.count < num_messages) {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      local.swap(queue);
+    }
+    if (local.empty()) { strict_variant::detail::spin_wait(spins); }
+    for (const msg_t & m : local) {
+      strict_variant::apply_visitor(h, m);
+    }
+    local.clear();
+  }
+  for (std::thread & t : threads) {
+    t.join();
+  }
+  report("mutex + deque", producers, start, h);
+}
+
+int
+main() {
+  for (unsigned producers : {1u, 2u, 4u, 8u, 16u}) {
+    bench_channel(false, producers);
+    bench_channel(true, producers);
+    bench_deque(producers);
+  }
+}
@@ -0,0 +1,104 @@
+#include "bench_ops.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_chars.hpp>
+#include <strict_variant/variant_stream_ops.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/***
+ * Formatting and parsing a sequence of variants as text, with `to_chars` and
+ * `from_chars`, compared with `operator<<` and `std::ostringstream`, and with
+ * reading the same text using `std::istringstream`.
+ *
+ * Built as C++11 (`chars_ops`) and C++17 (`chars_ops17`), which uses
+ * `std::to_chars` and `std::from_chars`.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+using var_t = strict_variant::variant<bool, int, long long, double, std::string>;
+
+var_t
+make_value(std::mt19937 & rng) {
+  const uint32_t x = static_cast<uint32_t>(rng());
+  switch (x % 5) {
+    case 0:
+      return var_t{(x & 8) != 0};
+    case 1:
+      return var_t{static_cast<int>(x % 100000) - 50000};
+    case 2:
+      return var_t{static_cast<long long>(x) << 24};
+    case 3:
+      return var_t{static_cast<double>(x) / 1024};
+    default:
+      return var_t{std::string("field-") + std::to_string(x % 1000)};
+  }
+}
+
+int
+main() {
+  std::mt19937 rng{rng_seed};
+  std::vector<var_t> values;
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    values.push_back(make_value(rng));
+  }
+
+  // The formatted values, one after another, with their ends
+  std::vector<char> text(seq_length * 32);
+  std::vector<const char *> ends(seq_length);
+
+  benchmark::run_operation("format, to_chars", seq_length, repeat_num, [&]() {
+    char * p = text.data();
+    char * const last = text.data() + text.size();
+    for (uint32_t i = 0; i < seq_length; ++i) {
+      p = strict_variant::to_chars(p, last, values[i]).ptr;
+      ends[i] = p;
+    }
+    return p;
+  });
+
+  std::ostringstream os;
+  os << std::boolalpha;
+  benchmark::run_operation("format, ostream", seq_length, repeat_num, [&]() {
+    os.str(std::string());
+    for (const var_t & v : values) {
+      os << v << ' ';
+    }
+    return os.tellp();
+  });
+
+  var_t result{false};
+  benchmark::run_operation("parse, from_chars", seq_length, repeat_num, [&]() {
+    const char * p = text.data();
+    std::size_t ok = 0;
+    for (uint32_t i = 0; i < seq_length; ++i) {
+      ok += strict_variant::from_chars(p, ends[i], result).ec == std::errc{};
+      p = ends[i];
+    }
+    return ok;
+  });
+
+  // For comparison, read every value as a token, then as a double if it is
+  // one. The stream does not know the variant's rules, so this is a baseline.
+  const std::string spaced = os.str();
+  std::istringstream is;
+  std::string token;
+  benchmark::run_operation("parse, istringstream", seq_length, repeat_num, [&]() {
+    is.clear();
+    is.str(spaced);
+    std::size_t ok = 0;
+    while (is >> token) {
+      std::istringstream field{token};
+      double d;
+      ok += static_cast<bool>(field >> d);
+    }
+    return ok;
+  });
+}
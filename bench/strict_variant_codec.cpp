@@ -0,0 +1,159 @@
+#include "bench_ops.hpp"
+#include <strict_variant/alloc_wrapper.hpp>
+#include <strict_variant/pool_allocator.hpp>
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_cbor.hpp>
+#include <strict_variant/variant_codec.hpp>
+#include <strict_variant/variant_msgpack.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+/***
+ * Throughput of MessagePack and CBOR encoding and decoding, in MB/s of encoded
+ * data, for a stream of JSON-like messages such as
+ *
+ *   {"id": 17, "name": "item-17", "active": true, "score": 0.25,
+ *    "tags": ["a", "bb"], "meta": {"created": 1500000000, "parent": null}}
+ *
+ * Each message is decoded into the same variant, replacing the last one.
+ * Decoding is measured with arrays and objects in `recursive_wrapper`, and with
+ * `pool_allocator` for the wrappers and the map nodes.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+struct json;
+using json_base = strict_variant::variant<std::nullptr_t, bool, int64_t, double, std::string,
+                                          strict_variant::recursive_wrapper<std::vector<json>>,
+                                          strict_variant::recursive_wrapper<std::map<std::string, json>>>;
+
+struct json : json_base {
+  using json_base::json_base;
+};
+
+struct pooled_json;
+using pooled_array = std::vector<pooled_json>;
+using pooled_object = std::map<std::string, pooled_json, std::less<std::string>,
+                               strict_variant::pool_allocator<std::pair<const std::string, pooled_json>>>;
+using pooled_json_base = strict_variant::variant<
+  std::nullptr_t, bool, int64_t, double, std::string,
+  strict_variant::alloc_wrapper<pooled_array, strict_variant::pool_allocator<pooled_array>>,
+  strict_variant::alloc_wrapper<pooled_object, strict_variant::pool_allocator<pooled_object>>>;
+
+struct pooled_json : pooled_json_base {
+  using pooled_json_base::pooled_json_base;
+};
+
+namespace strict_variant {
+
+template <>
+struct codec_traits<json> : codec_traits<json_base> {};
+
+template <>
+struct codec_traits<pooled_json> : codec_traits<pooled_json_base> {};
+
+} // end namespace strict_variant
+
+json
+make_record(std::mt19937 & rng, uint32_t id) {
+  const uint32_t x = static_cast<uint32_t>(rng());
+
+  std::vector<json> tags;
+  for (uint32_t i = 0; i < x % 4; ++i) {
+    tags.emplace_back(std::string(1 + (x >> (i * 4)) % 8, static_cast<char>('a' + i)));
+  }
+
+  std::map<std::string, json> meta;
+  meta.emplace("created", json{int64_t{1500000000} + x % 100000});
+  meta.emplace("parent", (x & 1) ? json{nullptr} : json{static_cast<int64_t>(x % id + 1)});
+
+  std::map<std::string, json> record;
+  record.emplace("id", json{static_cast<int64_t>(id)});
+  record.emplace("name", json{"item-" + std::to_string(id)});
+  record.emplace("active", json{(x & 2) != 0});
+  record.emplace("score", json{static_cast<double>(x % 1000) / 8});
+  record.emplace("tags", json{std::move(tags)});
+  record.emplace("meta", json{std::move(meta)});
+  return json{std::move(record)};
+}
+
+void
+report_throughput(double ns_per_item, std::size_t bytes) {
+  const double bytes_per_item = static_cast<double>(bytes) / seq_length;
+  std::fprintf(stdout, "  bytes per item = %f\n  throughput = %f MB/s\n\n\n", bytes_per_item,
+               bytes_per_item * 1000.0 / ns_per_item);
+}
+
+template <typename J, typename Decode>
+void
+bench_decode(const std::string & name, const std::vector<unsigned char> & buffer, Decode decode) {
+  J result{nullptr};
+  const double ns = benchmark::run_operation(name.c_str(), seq_length, repeat_num, [&]() {
+    strict_variant::byte_source src{buffer.data(), buffer.size()};
+    std::size_t ok = 0;
+    while (src.remaining()) {
+      ok += decode(src, result);
+    }
+    return ok;
+  });
+  report_throughput(ns, buffer.size());
+}
+
+template <typename Encode>
+std::vector<unsigned char>
+bench_encode(const std::string & name, const std::vector<json> & messages, Encode encode) {
+  std::vector<unsigned char> buffer;
+  const double ns = benchmark::run_operation(name.c_str(), seq_length, repeat_num, [&]() {
+    buffer.clear();
+    for (const json & m : messages) {
+      encode(m, buffer);
+    }
+    return buffer.size();
+  });
+  report_throughput(ns, buffer.size());
+  return buffer;
+}
+
+int
+main() {
+  std::mt19937 rng{rng_seed};
+  std::vector<json> messages;
+  for (uint32_t i = 1; i <= seq_length; ++i) {
+    messages.push_back(make_record(rng, i));
+  }
+
+  using buffer_t = std::vector<unsigned char>;
+  const buffer_t msgpack =
+    bench_encode("encode, msgpack", messages,
+                 [](const json & m, buffer_t & b) { strict_variant::encode_msgpack(m, b); });
+  const buffer_t cbor =
+    bench_encode("encode, cbor", messages,
+                 [](const json & m, buffer_t & b) { strict_variant::encode_cbor(m, b); });
+
+  bench_decode<json>("decode, msgpack, recursive_wrapper", msgpack,
+                     [](strict_variant::byte_source & src, json & j) {
+                       return strict_variant::decode_msgpack(src, j);
+                     });
+  bench_decode<json>("decode, cbor, recursive_wrapper", cbor,
+                     [](strict_variant::byte_source & src, json & j) {
+                       return strict_variant::decode_cbor(src, j);
+                     });
+  bench_decode<pooled_json>("decode, msgpack, pool_allocator", msgpack,
+                            [](strict_variant::byte_source & src, pooled_json & j) {
+                              return strict_variant::decode_msgpack(src, j);
+                            });
+  bench_decode<pooled_json>("decode, cbor, pool_allocator", cbor,
+                            [](strict_variant::byte_source & src, pooled_json & j) {
+                              return strict_variant::decode_cbor(src, j);
+                            });
+}
@@ -0,0 +1,143 @@
+#include "bench_ops.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_columnar.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+/***
+ * Compares the columnar format with writing the array of variants with
+ * `fwrite`, for a sequence of analytics-like events: runs of increasing
+ * timestamps, prices, and small counts.
+ *
+ * Reports the size of each file, and the time to read it back with `fread`
+ * and sum its values: in order, for both, and by column, for the columnar
+ * format. Reads are from the page cache.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+using var_t = strict_variant::variant<int64_t, double, int32_t>;
+
+std::vector<var_t>
+make_values(std::mt19937 & rng) {
+  std::vector<var_t> values;
+  int64_t timestamp = 1500000000000;
+  double price = 100;
+  while (values.size() < seq_length) {
+    const uint32_t x = static_cast<uint32_t>(rng());
+    const uint32_t run = 1 + (x >> 8) % 32;
+    for (uint32_t i = 0; i < run && values.size() < seq_length; ++i) {
+      const uint32_t y = static_cast<uint32_t>(rng());
+      switch (x % 3) {
+        case 0:
+          timestamp += y % 1000;
+          values.emplace_back(timestamp);
+          break;
+        case 1:
+          price += static_cast<double>(static_cast<int>(y % 201) - 100) / 100;
+          values.emplace_back(price);
+          break;
+        default:
+          values.emplace_back(static_cast<int32_t>(y % 500));
+      }
+    }
+  }
+  return values;
+}
+
+struct sum_visitor {
+  double & sum;
+
+  void operator()(int64_t i) const { sum += static_cast<double>(i); }
+  void operator()(double d) const { sum += d; }
+  void operator()(int32_t i) const { sum += i; }
+};
+
+void
+write_file(const std::string & path, const void * data, std::size_t size) {
+  std::FILE * f = std::fopen(path.c_str(), "wb");
+  std::fwrite(data, 1, size, f);
+  std::fclose(f);
+}
+
+std::vector<unsigned char>
+read_file(const std::string & path) {
+  std::vector<unsigned char> result;
+  std::FILE * f = std::fopen(path.c_str(), "rb");
+  std::fseek(f, 0, SEEK_END);
+  result.resize(static_cast<std::size_t>(std::ftell(f)));
+  std::fseek(f, 0, SEEK_SET);
+  if (std::fread(result.data(), 1, result.size(), f) != result.size()) { result.clear(); }
+  std::fclose(f);
+  return result;
+}
+
+int
+main() {
+  std::mt19937 rng{rng_seed};
+  const std::vector<var_t> values = make_values(rng);
+
+  char dir[] = "/tmp/strict_variant_columnar_XXXXXX";
+  if (!::mkdtemp(dir)) { return 1; }
+  const std::string raw_path = std::string(dir) + "/raw.bin";
+  const std::string columnar_path = std::string(dir) + "/columnar.bin";
+
+  write_file(raw_path, values.data(), values.size() * sizeof(var_t));
+
+  strict_variant::columnar_writer<var_t> writer;
+  std::vector<unsigned char> buffer;
+  benchmark::run_operation("columnar_writer", seq_length, repeat_num, [&]() {
+    writer.clear();
+    for (const var_t & v : values) {
+      writer.push_back(v);
+    }
+    buffer.clear();
+    writer.write(buffer);
+    return buffer.size();
+  });
+  write_file(columnar_path, buffer.data(), buffer.size());
+
+  std::fprintf(stdout, "file size:\n  fwrite = %lu bytes\n  columnar = %lu bytes\n\n\n",
+               static_cast<unsigned long>(values.size() * sizeof(var_t)),
+               static_cast<unsigned long>(buffer.size()));
+
+  benchmark::run_operation("read and visit, fwrite", seq_length, repeat_num, [&]() {
+    const std::vector<unsigned char> data = read_file(raw_path);
+    const var_t * p = reinterpret_cast<const var_t *>(data.data());
+    double sum = 0;
+    for (std::size_t i = 0; i < data.size() / sizeof(var_t); ++i) {
+      strict_variant::apply_visitor(sum_visitor{sum}, p[i]);
+    }
+    return sum;
+  });
+
+  benchmark::run_operation("read and visit, columnar in order", seq_length, repeat_num, [&]() {
+    const std::vector<unsigned char> data = read_file(columnar_path);
+    strict_variant::columnar_reader<var_t> reader;
+    reader.assign(data.data(), data.size());
+    double sum = 0;
+    reader.for_each(sum_visitor{sum});
+    return sum;
+  });
+
+  benchmark::run_operation("read and visit, columnar by column", seq_length, repeat_num, [&]() {
+    const std::vector<unsigned char> data = read_file(columnar_path);
+    strict_variant::columnar_reader<var_t> reader;
+    reader.assign(data.data(), data.size());
+    double sum = 0;
+    reader.scan(sum_visitor{sum});
+    return sum;
+  });
+
+  ::unlink(raw_path.c_str());
+  ::unlink(columnar_path.c_str());
+  ::rmdir(dir);
+}
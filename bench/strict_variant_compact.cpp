@@ -0,0 +1,123 @@
+#include "bench_ops.hpp"
+#include <strict_variant/arena_wrapper.hpp>
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_compact.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+/***
+ * Sums the leaves of balanced trees of a million nodes, whose nodes were
+ * allocated in a random order, before and after compaction.
+ *
+ * With `arena_wrapper`, the tree is compacted by `compact`, into one block.
+ * With `recursive_wrapper`, for comparison, it is copied, which allocates the
+ * nodes again in depth-first order.
+ */
+
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr int depth{20};
+
+template <template <typename> class Wrapper>
+struct ast {
+  struct node;
+  using tree_t = strict_variant::variant<uint32_t, Wrapper<node>>;
+
+  struct node {
+    tree_t lhs;
+    tree_t rhs;
+  };
+
+  // Nodes are created in a random order. They are never moved, so the
+  // pointers to pending children stay valid.
+  static void make_scattered(tree_t & t) {
+    std::mt19937 rng{RNG_SEED};
+    std::vector<std::pair<tree_t *, int>> pending{{&t, depth}};
+    while (!pending.empty()) {
+      std::swap(pending[rng() % pending.size()], pending.back());
+      const std::pair<tree_t *, int> p = pending.back();
+      pending.pop_back();
+      if (!p.second) {
+        *p.first = static_cast<uint32_t>(rng() % 100);
+        continue;
+      }
+      p.first->template emplace<node>(node{0u, 0u});
+      node * n = strict_variant::get<node>(p.first);
+      pending.emplace_back(&n->lhs, p.second - 1);
+      pending.emplace_back(&n->rhs, p.second - 1);
+    }
+  }
+
+  struct sum {
+    uint64_t operator()(uint32_t i) const { return i; }
+    uint64_t operator()(const node & n) const {
+      return strict_variant::apply_visitor(*this, n.lhs)
+             + strict_variant::apply_visitor(*this, n.rhs);
+    }
+  };
+};
+
+template <typename Ast>
+void
+bench(const char * label, const typename Ast::tree_t & tree) {
+  uint64_t result = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t r = 0; r < repeat_num; ++r) {
+    result += strict_variant::apply_visitor(typename Ast::sum{}, tree);
+    benchmark::ClobberMemory();
+  }
+  const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+  benchmark::DoNotOptimize(result);
+
+  const uint64_t items = ((uint64_t{1} << depth) - 1) * repeat_num;
+  std::fprintf(stdout, "%s:\n  items = %lu\n\naverage nanoseconds per item: %f\n\n\n", label,
+               static_cast<unsigned long>(items),
+               static_cast<double>(elapsed.count()) / static_cast<double>(items));
+}
+
+template <typename F>
+void
+time_once(const char * label, F && f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+  std::fprintf(stdout, "%s: %f ms\n\n", label, static_cast<double>(elapsed.count()) / 1e6);
+}
+
+template <typename T>
+using pointer_wrapper = strict_variant::recursive_wrapper<T>;
+
+template <typename T>
+using thread_arena_wrapper = strict_variant::arena_wrapper<T>;
+
+int
+main() {
+  {
+    using ast_t = ast<pointer_wrapper>;
+    ast_t::tree_t tree{0u};
+    ast_t::make_scattered(tree);
+    bench<ast_t>("recursive_wrapper, scattered", tree);
+
+    std::unique_ptr<ast_t::tree_t> copy;
+    time_once("copy", [&]() { copy.reset(new ast_t::tree_t{tree}); });
+    bench<ast_t>("recursive_wrapper, copied", *copy);
+  }
+  {
+    using ast_t = ast<thread_arena_wrapper>;
+    strict_variant::bump_arena arena;
+    strict_variant::arena_scope scope{arena};
+    ast_t::tree_t tree{0u};
+    ast_t::make_scattered(tree);
+    bench<ast_t>("arena_wrapper, scattered", tree);
+
+    std::unique_ptr<strict_variant::compact_tree<ast_t::tree_t>> c;
+    time_once("compact", [&]() { c.reset(new auto(strict_variant::compact(tree))); });
+    bench<ast_t>("arena_wrapper, compacted", c->get());
+  }
+}
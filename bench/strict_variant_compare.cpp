@@ -0,0 +1,135 @@
+#include "bench_ops.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_compare.hpp>
+#include <strict_variant/variant_hash.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/***
+ * Benchmarks of sorting and hash-set probing, which are dominated by variant
+ * comparisons. The "double dispatch" versions reproduce the earlier
+ * implementations of `operator ==` and `variant_comparator`, which visit the
+ * second variant again, or test its type using `get`.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+using var_t = strict_variant::variant<int32_t, uint64_t, double, std::string>;
+
+var_t
+make_value(std::mt19937 & rng) {
+  const uint32_t x = static_cast<uint32_t>(rng());
+  switch (x % 4) {
+    case 0:
+      return var_t{static_cast<int32_t>(x % 1000)};
+    case 1:
+      return var_t{static_cast<uint64_t>(x % 1000)};
+    case 2:
+      return var_t{static_cast<double>(x % 1000) / 7};
+    default:
+      return var_t{std::to_string(x % 1000)};
+  }
+}
+
+// Earlier implementation of variant_comparator
+struct double_dispatch_less {
+  struct helper {
+    const var_t & first;
+    const var_t & other;
+
+    template <typename T>
+    bool operator()(const T & t) const {
+      if (const T * o = strict_variant::get<T>(&other)) {
+        return t < *o;
+      } else {
+        return first.which() < other.which();
+      }
+    }
+  };
+
+  bool operator()(const var_t & v1, const var_t & v2) const {
+    return strict_variant::apply_visitor(helper{v1, v2}, v1);
+  }
+};
+
+// Earlier implementation of operator ==
+struct double_dispatch_equal {
+  template <typename T>
+  struct second_visitor {
+    const T & r;
+
+    bool operator()(const T & l) const { return l == r; }
+    template <typename U>
+    bool operator()(const U &) const {
+      return false;
+    }
+  };
+
+  struct first_visitor {
+    const var_t & lhs;
+
+    template <typename T>
+    bool operator()(const T & t) const {
+      return strict_variant::apply_visitor(second_visitor<T>{t}, lhs);
+    }
+  };
+
+  bool operator()(const var_t & lhs, const var_t & rhs) const {
+    if (lhs.which() != rhs.which()) { return false; }
+    return strict_variant::apply_visitor(first_visitor{lhs}, rhs);
+  }
+};
+
+struct single_dispatch_equal {
+  bool operator()(const var_t & lhs, const var_t & rhs) const { return lhs == rhs; }
+};
+
+template <typename Comparator>
+void
+bench_sort(const char * name, const std::vector<var_t> & input) {
+  std::vector<var_t> vec;
+  benchmark::run_operation(name, seq_length, repeat_num, [&]() {
+    vec = input;
+    std::sort(vec.begin(), vec.end(), Comparator{});
+    return vec.size();
+  });
+}
+
+template <typename Equal>
+void
+bench_probe(const char * name, const std::vector<var_t> & input,
+            const std::vector<var_t> & probes) {
+  std::unordered_set<var_t, std::hash<var_t>, Equal> set(input.begin(), input.end());
+  benchmark::run_operation(name, seq_length, repeat_num, [&]() {
+    std::size_t found = 0;
+    for (const var_t & p : probes) {
+      found += set.count(p);
+    }
+    return found;
+  });
+}
+
+int
+main() {
+  std::mt19937 rng{rng_seed};
+
+  std::vector<var_t> input;
+  std::vector<var_t> probes;
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    input.emplace_back(make_value(rng));
+    probes.emplace_back(make_value(rng));
+  }
+
+  bench_sort<double_dispatch_less>("std::sort, double dispatch comparator", input);
+  bench_sort<strict_variant::variant_comparator<var_t>>("std::sort, variant_comparator", input);
+
+  bench_probe<double_dispatch_equal>("unordered_set probe, double dispatch ==", input, probes);
+  bench_probe<single_dispatch_equal>("unordered_set probe, operator ==", input, probes);
+}
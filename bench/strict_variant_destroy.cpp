@@ -0,0 +1,92 @@
+#include "bench_ops.hpp"
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+/***
+ * Times the destruction of lists and balanced trees of recursive variants,
+ * with the default, recursive destruction of `recursive_wrapper`, and with
+ * `destroy_iteratively`. Building the trees is not timed.
+ *
+ * The lists are kept short enough to be destroyed recursively.
+ */
+
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+
+template <bool iterative>
+struct node;
+
+template <bool iterative>
+using tree_t = strict_variant::variant<uint32_t, strict_variant::recursive_wrapper<node<iterative>>>;
+
+template <bool iterative>
+struct node {
+  tree_t<iterative> lhs;
+  tree_t<iterative> rhs;
+};
+
+namespace strict_variant {
+namespace detail {
+
+template <>
+struct destroy_iteratively<node<true>> : std::true_type {};
+
+} // end namespace detail
+} // end namespace strict_variant
+
+template <bool iterative>
+void
+make_balanced(tree_t<iterative> & t, uint32_t first, int depth) {
+  if (!depth) { return; }
+  t.template emplace<node<iterative>>(node<iterative>{first, first});
+  node<iterative> * n = strict_variant::get<node<iterative>>(&t);
+  make_balanced(n->lhs, first, depth - 1);
+  make_balanced(n->rhs, first + (1u << (depth - 1)), depth - 1);
+}
+
+template <bool iterative>
+void
+make_list(tree_t<iterative> & t, uint32_t length) {
+  tree_t<iterative> * tail = &t;
+  for (uint32_t i = 0; i < length; ++i) {
+    tail->template emplace<node<iterative>>(node<iterative>{i, 0u});
+    tail = &strict_variant::get<node<iterative>>(tail)->rhs;
+  }
+}
+
+template <bool iterative, typename Build>
+void
+bench(const char * label, const char * tree_label, uint64_t nodes, Build && build) {
+  std::chrono::nanoseconds elapsed{0};
+  for (uint32_t r = 0; r < repeat_num; ++r) {
+    std::unique_ptr<tree_t<iterative>> tree{new tree_t<iterative>{0u}};
+    build(*tree);
+    const auto start = std::chrono::steady_clock::now();
+    tree.reset();
+    elapsed += std::chrono::steady_clock::now() - start;
+  }
+
+  const uint64_t items = nodes * repeat_num;
+  std::fprintf(stdout, "%s, %s:\n  items = %lu\n\naverage nanoseconds per item: %f\n\n\n", label,
+               tree_label, static_cast<unsigned long>(items),
+               static_cast<double>(elapsed.count()) / static_cast<double>(items));
+}
+
+int
+main() {
+  constexpr int depth = 18;
+  constexpr uint32_t length = 10000;
+  const uint64_t tree_nodes = (uint64_t{1} << depth) - 1;
+
+  bench<false>("recursive", "balanced tree", tree_nodes,
+               [](tree_t<false> & t) { make_balanced(t, 0, depth); });
+  bench<true>("destroy_iteratively", "balanced tree", tree_nodes,
+              [](tree_t<true> & t) { make_balanced(t, 0, depth); });
+  bench<false>("recursive", "list", length, [](tree_t<false> & t) { make_list(t, length); });
+  bench<true>("destroy_iteratively", "list", length,
+              [](tree_t<true> & t) { make_list(t, length); });
+}
@@ -0,0 +1,151 @@
+#include "bench_ops.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_event_log.hpp>
+#include <strict_variant/variant_view.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+/***
+ * Write and replay throughput of `event_log_writer` and `replay_event_log`, in
+ * MB/s of log data, in a temporary directory under /tmp.
+ *
+ * Writing is measured without syncing, and with a commit every 1000 records,
+ * using `msync` or `fdatasync`. The results depend on the file system.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+struct order_placed {
+  uint64_t id;
+  uint32_t quantity;
+  double price;
+};
+
+struct order_cancelled {
+  uint64_t id;
+};
+
+using event_t = strict_variant::variant<order_placed, order_cancelled, std::string>;
+
+event_t
+make_event(std::mt19937 & rng, uint64_t id) {
+  const uint32_t x = static_cast<uint32_t>(rng());
+  switch (x % 4) {
+    case 0:
+    case 1:
+      return event_t{order_placed{id, x % 100, static_cast<double>(x % 10000) / 100}};
+    case 2:
+      return event_t{order_cancelled{id - x % 10}};
+    default:
+      return event_t{std::string("note ") + std::to_string(x % 100000)};
+  }
+}
+
+// Sums something from each record, so that replay is not optimized away
+struct sum_visitor {
+  uint64_t & sum;
+
+  void operator()(const order_placed & o) const { sum += o.quantity; }
+  void operator()(const order_cancelled & o) const { sum += o.id; }
+  void operator()(const strict_variant::string_ref & s) const { sum += s.size(); }
+};
+
+struct temp_dir {
+  std::string path;
+
+  temp_dir() {
+    char name[] = "/tmp/strict_variant_event_log_XXXXXX";
+    path = ::mkdtemp(name);
+  }
+
+  ~temp_dir() {
+    for (std::size_t i = 0;
+         ::unlink(strict_variant::detail::segment_path(path, i).c_str()) == 0; ++i) {}
+    ::rmdir(path.c_str());
+  }
+};
+
+// The number of bytes of records in the log
+std::size_t
+log_bytes(const std::string & dir) {
+  std::size_t bytes = 0;
+  for (std::size_t i = 0;; ++i) {
+    strict_variant::detail::mapped_file f;
+    if (!f.open(strict_variant::detail::segment_path(dir, i), false)) { break; }
+    bytes += strict_variant::detail::scan_segment<event_t>(f.data(), f.size());
+  }
+  return bytes;
+}
+
+void
+report_throughput(double ns_per_item, double bytes_per_item) {
+  std::fprintf(stdout, "  bytes per item = %f\n  throughput = %f MB/s\n\n\n", bytes_per_item,
+               bytes_per_item * 1000.0 / ns_per_item);
+}
+
+void
+bench_write(const char * name, const std::vector<event_t> & events,
+            strict_variant::event_log_options options) {
+  temp_dir dir;
+  strict_variant::event_log_writer<event_t> w{options};
+  if (!w.open(dir.path)) {
+    std::fprintf(stdout, "%s: open failed: %s\n", name, w.last_error().message().c_str());
+    return;
+  }
+  const double ns = benchmark::run_operation(name, seq_length, repeat_num, [&]() {
+    std::size_t ok = 0;
+    for (const event_t & e : events) {
+      ok += w.append(e);
+    }
+    return ok;
+  });
+  w.close();
+  report_throughput(ns, static_cast<double>(log_bytes(dir.path)) / (double{seq_length} * repeat_num));
+}
+
+int
+main() {
+  std::mt19937 rng{rng_seed};
+  std::vector<event_t> events;
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    events.push_back(make_event(rng, i + 100));
+  }
+
+  strict_variant::event_log_options options;
+  options.segment_size = std::size_t{16} << 20;
+
+  bench_write("write, no sync", events, options);
+
+  options.commit_every = 1000;
+  bench_write("write, msync every 1000", events, options);
+
+  options.sync = strict_variant::event_log_sync::fdatasync;
+  bench_write("write, fdatasync every 1000", events, options);
+
+  // Replay a log of `seq_length` records
+  temp_dir dir;
+  {
+    strict_variant::event_log_writer<event_t> w{strict_variant::event_log_options{}};
+    w.open(dir.path);
+    for (const event_t & e : events) {
+      w.append(e);
+    }
+  }
+  uint64_t sum = 0;
+  const double ns = benchmark::run_operation("replay", seq_length, repeat_num, [&]() {
+    std::error_code ec;
+    return strict_variant::replay_event_log<event_t>(dir.path, sum_visitor{sum}, ec);
+  });
+  report_throughput(ns, static_cast<double>(log_bytes(dir.path)) / seq_length);
+  std::fprintf(stdout, "checksum = %lu\n", static_cast<unsigned long>(sum));
+}
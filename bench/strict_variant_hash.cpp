@@ -0,0 +1,119 @@
+#include "bench_ops.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_hash.hpp>
+
+#include <cstdint>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+/***
+ * Benchmarks of variant hashing: collision rates and throughput of the
+ * current scheme, against the earlier `hash(value) + 31 * which` scheme.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+using var_t = strict_variant::variant<int32_t, int64_t, uint32_t>;
+
+// Earlier implementation of std::hash<variant>
+struct old_hash {
+  struct hasher {
+    template <typename Arg>
+    std::size_t operator()(const Arg & arg) const {
+      return std::hash<Arg>{}(arg);
+    }
+  };
+
+  std::size_t operator()(const var_t & v) const {
+    return strict_variant::apply_visitor(hasher{}, v) + (31 * v.which());
+  }
+};
+
+using new_hash = std::hash<var_t>;
+
+// Small integers of each type, as for instance ids or enum-like keys
+std::vector<var_t>
+make_keys() {
+  std::vector<var_t> keys;
+  for (uint32_t i = 0; keys.size() < seq_length; ++i) {
+    keys.emplace_back(static_cast<int32_t>(i));
+    keys.emplace_back(static_cast<int64_t>(i));
+    keys.emplace_back(static_cast<uint32_t>(i));
+  }
+  keys.resize(seq_length);
+  return keys;
+}
+
+template <typename Hash>
+void
+report_collisions(const char * name, const std::vector<var_t> & keys) {
+  std::unordered_set<std::size_t> hashes;
+  std::unordered_set<var_t, Hash> set(keys.begin(), keys.end());
+
+  for (const var_t & k : keys) {
+    hashes.insert(Hash{}(k));
+  }
+
+  std::size_t longest_chain = 0;
+  for (std::size_t b = 0; b < set.bucket_count(); ++b) {
+    longest_chain = std::max(longest_chain, set.bucket_size(b));
+  }
+
+  std::fprintf(stdout, "%s:\n  keys = %u\n  distinct hashes = %u\n  longest bucket chain = %u\n\n\n",
+               name, static_cast<uint32_t>(keys.size()), static_cast<uint32_t>(hashes.size()),
+               static_cast<uint32_t>(longest_chain));
+}
+
+template <typename Hash>
+void
+bench_lookup(const char * name, const std::vector<var_t> & keys,
+             const std::vector<var_t> & probes) {
+  std::unordered_set<var_t, Hash> set(keys.begin(), keys.end());
+  benchmark::run_operation(name, seq_length, repeat_num, [&]() {
+    std::size_t found = 0;
+    for (const var_t & p : probes) {
+      found += set.count(p);
+    }
+    return found;
+  });
+}
+
+template <typename Hash>
+void
+bench_hash(const char * name, const std::vector<var_t> & keys, std::vector<std::size_t> & out) {
+  benchmark::run_operation(name, seq_length, repeat_num, [&]() {
+    Hash h;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      out[i] = h(keys[i]);
+    }
+    return out.back();
+  });
+}
+
+int
+main() {
+  const std::vector<var_t> keys = make_keys();
+
+  std::vector<var_t> probes;
+  std::mt19937 rng{rng_seed};
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    probes.push_back(keys[rng() % keys.size()]);
+  }
+
+  report_collisions<old_hash>("collisions, hash + 31 * which", keys);
+  report_collisions<new_hash>("collisions, std::hash<variant>", keys);
+
+  std::vector<std::size_t> out(keys.size());
+  bench_hash<old_hash>("hash, hash + 31 * which", keys, out);
+  bench_hash<new_hash>("hash, std::hash<variant>", keys, out);
+  benchmark::run_operation("hash_batch", seq_length, repeat_num, [&]() {
+    strict_variant::hash_batch(keys.begin(), keys.end(), out.begin());
+    return out.back();
+  });
+
+  bench_lookup<old_hash>("unordered_set lookup, hash + 31 * which", keys, probes);
+  bench_lookup<new_hash>("unordered_set lookup, std::hash<variant>", keys, probes);
+}
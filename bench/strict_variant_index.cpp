@@ -0,0 +1,143 @@
+#include "bench_ops.hpp"
+#include <strict_variant/index_wrapper.hpp>
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/***
+ * Sums the leaves of balanced trees of a million nodes, with the nodes in
+ * `recursive_wrapper` and in `index_wrapper`, and reports the memory used
+ * by the nodes.
+ *
+ * The trees are built in depth-first order, and then again after shuffling
+ * the free memory, so that the nodes are scattered. The scattered
+ * `index_wrapper` tree is then compacted.
+ */
+
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr int depth{20};
+
+template <template <typename> class Wrapper>
+struct ast {
+  struct node;
+  using tree_t = strict_variant::variant<uint32_t, Wrapper<node>>;
+
+  struct node {
+    tree_t lhs;
+    tree_t rhs;
+  };
+
+  static void make_balanced(tree_t & t, uint32_t first, int d) {
+    if (!d) {
+      t = first;
+      return;
+    }
+    t.template emplace<node>(node{0u, 0u});
+    node * n = strict_variant::get<node>(&t);
+    make_balanced(n->lhs, first, d - 1);
+    make_balanced(n->rhs, first + (1u << (d - 1)), d - 1);
+  }
+
+  // Allocates as many nodes as the tree has, and frees them in a random order
+  static void shuffle_free_memory() {
+    std::vector<tree_t> nodes;
+    nodes.reserve(std::size_t{1} << depth);
+    for (uint32_t i = 0; i < (1u << depth); ++i) {
+      nodes.emplace_back(node{i, i});
+    }
+    // Moving a variant would move the node into a new wrapper, so the order
+    // is shuffled rather than the nodes
+    std::vector<uint32_t> order(nodes.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+      order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937{RNG_SEED});
+    for (uint32_t i : order) {
+      nodes[i] = 0u;
+    }
+  }
+
+  struct sum {
+    uint64_t operator()(uint32_t i) const { return i; }
+    uint64_t operator()(const node & n) const {
+      return strict_variant::apply_visitor(*this, n.lhs)
+             + strict_variant::apply_visitor(*this, n.rhs);
+    }
+  };
+};
+
+template <typename Ast>
+void
+bench(const char * label, const typename Ast::tree_t & tree, std::size_t bytes) {
+  uint64_t result = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t r = 0; r < repeat_num; ++r) {
+    result += strict_variant::apply_visitor(typename Ast::sum{}, tree);
+    benchmark::ClobberMemory();
+  }
+  const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+  benchmark::DoNotOptimize(result);
+
+  const uint64_t nodes = (uint64_t{1} << depth) - 1;
+  const uint64_t items = nodes * repeat_num;
+  std::fprintf(stdout,
+               "%s:\n  items = %lu\n  bytes per node = %f\n\n"
+               "average nanoseconds per item: %f\n\n\n",
+               label, static_cast<unsigned long>(items),
+               static_cast<double>(bytes) / static_cast<double>(nodes),
+               static_cast<double>(elapsed.count()) / static_cast<double>(items));
+}
+
+template <typename T>
+using pointer_wrapper = strict_variant::recursive_wrapper<T>;
+
+int
+main() {
+  {
+    using ast_t = ast<pointer_wrapper>;
+    // Not counting the overhead of the heap
+    const std::size_t bytes = ((std::size_t{1} << depth) - 1) * sizeof(ast_t::node);
+    {
+      ast_t::tree_t tree{0u};
+      ast_t::make_balanced(tree, 0, depth);
+      bench<ast_t>("recursive_wrapper", tree, bytes);
+    }
+    {
+      ast_t::shuffle_free_memory();
+      ast_t::tree_t tree{0u};
+      ast_t::make_balanced(tree, 0, depth);
+      bench<ast_t>("recursive_wrapper, scattered", tree, bytes);
+    }
+  }
+  {
+    using ast_t = ast<strict_variant::index_wrapper>;
+    using pool_t = strict_variant::index_pool<ast_t::node>;
+    {
+      pool_t pool;
+      pool_t::scope scope{pool};
+      ast_t::tree_t tree{0u};
+      ast_t::make_balanced(tree, 0, depth);
+      bench<ast_t>("index_wrapper", tree, pool.memory_usage());
+    }
+    {
+      pool_t pool;
+      pool_t::scope scope{pool};
+      ast_t::shuffle_free_memory();
+      ast_t::tree_t tree{0u};
+      ast_t::make_balanced(tree, 0, depth);
+      bench<ast_t>("index_wrapper, scattered", tree, pool.memory_usage());
+
+      const auto start = std::chrono::steady_clock::now();
+      pool.compact(tree);
+      const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+      std::fprintf(stdout, "compact: %f ms\n\n", static_cast<double>(elapsed.count()) / 1e6);
+      bench<ast_t>("index_wrapper, compacted", tree, pool.memory_usage());
+    }
+  }
+}
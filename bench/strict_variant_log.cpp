@@ -0,0 +1,143 @@
+#include "bench_ops.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_chars.hpp>
+#include <strict_variant/variant_log.hpp>
+#include <strict_variant/variant_stream_ops.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***
+ * Cost per call on the logging thread, for `variant_logger::log`, while a
+ * background thread drains and formats the records, compared with formatting
+ * on the logging thread with `printer_visitor` or `to_chars`. Calls that drop
+ * the event would be cheaper, so the buffer is large enough that none do.
+ *
+ * Measured for a variant of trivially copyable types, and one which also holds
+ * strings.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+using small_t = strict_variant::variant<int32_t, int64_t, double, bool>;
+using mixed_t = strict_variant::variant<int32_t, double, std::string>;
+
+template <typename V>
+V make_value(std::mt19937 & rng);
+
+template <>
+small_t
+make_value<small_t>(std::mt19937 & rng) {
+  const uint32_t x = static_cast<uint32_t>(rng());
+  switch (x % 4) {
+    case 0:
+      return small_t{static_cast<int32_t>(x)};
+    case 1:
+      return small_t{static_cast<int64_t>(x) << 20};
+    case 2:
+      return small_t{static_cast<double>(x) / 7};
+    default:
+      return small_t{(x & 16) != 0};
+  }
+}
+
+template <>
+mixed_t
+make_value<mixed_t>(std::mt19937 & rng) {
+  const uint32_t x = static_cast<uint32_t>(rng());
+  switch (x % 3) {
+    case 0:
+      return mixed_t{static_cast<int32_t>(x)};
+    case 1:
+      return mixed_t{static_cast<double>(x) / 7};
+    default:
+      return mixed_t{std::string("request ") + std::to_string(x % 10000) + " done"};
+  }
+}
+
+template <typename V>
+void
+bench(const char * label) {
+  std::mt19937 rng{rng_seed};
+  std::vector<V> values;
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    values.push_back(make_value<V>(rng));
+  }
+
+  const std::string name = label;
+
+  {
+    // Each pass is timed on its own, and then the drain thread is allowed to
+    // catch up, so that nothing is dropped and the cost of formatting is not
+    // included.
+    strict_variant::variant_logger<V> logger{std::size_t{1} << 22};
+    std::atomic<bool> done{false};
+    std::atomic<std::size_t> drained{0};
+    std::thread drainer([&]() {
+      std::ostringstream ss;
+      V value{values.front()};
+      while (!done.load()) {
+        const std::size_t n = logger.drain(value, strict_variant::printer_visitor{ss});
+        if (!n) { std::this_thread::yield(); }
+        drained += n;
+        ss.str(std::string());
+      }
+    });
+
+    const std::string op = name + ", variant_logger::log";
+    std::fprintf(stdout, "%s:\n  items = %u\n  repeat_num = %u\n\n", op.c_str(), seq_length,
+                 repeat_num);
+    std::chrono::nanoseconds elapsed{0};
+    for (uint32_t count = 0; count < repeat_num; ++count) {
+      const auto start = std::chrono::steady_clock::now();
+      std::size_t ok = 0;
+      for (const V & v : values) {
+        ok += logger.log(v);
+      }
+      benchmark::DoNotOptimize(ok);
+      elapsed += std::chrono::steady_clock::now() - start;
+      while (drained.load() < (count + 1) * std::size_t{seq_length}) {
+        std::this_thread::yield();
+      }
+    }
+    done = true;
+    drainer.join();
+
+    std::fprintf(stdout, "average nanoseconds per item: %f\n  dropped = %lu\n\n\n",
+                 static_cast<double>(elapsed.count()) / (double{seq_length} * repeat_num),
+                 static_cast<unsigned long>(logger.dropped()));
+  }
+
+  std::ostringstream ss;
+  benchmark::run_operation((name + ", printer_visitor").c_str(), seq_length, repeat_num, [&]() {
+    ss.str(std::string());
+    for (const V & v : values) {
+      strict_variant::apply_visitor(strict_variant::printer_visitor{ss}, v);
+    }
+    return ss.tellp();
+  });
+
+  std::vector<char> text(seq_length * 32);
+  benchmark::run_operation((name + ", to_chars").c_str(), seq_length, repeat_num, [&]() {
+    char * p = text.data();
+    for (const V & v : values) {
+      p = strict_variant::to_chars(p, text.data() + text.size(), v).ptr;
+    }
+    return p;
+  });
+}
+
+int
+main() {
+  bench<small_t>("trivially copyable");
+  bench<mixed_t>("with strings");
+}
@@ -0,0 +1,72 @@
+#include "bench_ops.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_compare.hpp>
+#include <strict_variant/variant_lookup.hpp>
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/***
+ * Benchmarks of heterogeneous lookup: finding a string key in a map keyed by
+ * a variant, by constructing a temporary variant, against looking up the
+ * `std::string_view` directly with the transparent comparator.
+ *
+ * Requires C++17.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+using var_t = strict_variant::variant<int64_t, std::string>;
+
+// Long enough keys that std::string makes an allocation
+std::string
+make_key(uint32_t i) {
+  return "benchmark_key_with_a_long_common_prefix_" + std::to_string(i);
+}
+
+int
+main() {
+  constexpr uint32_t num_keys = 1000;
+
+  std::map<var_t, uint32_t, strict_variant::variant_comparator<var_t>> plain_map;
+  std::map<var_t, uint32_t, strict_variant::transparent_variant_comparator<var_t>> transparent_map;
+
+  std::vector<std::string> key_text;
+  for (uint32_t i = 0; i < num_keys; ++i) {
+    key_text.push_back(make_key(i));
+    plain_map.emplace(var_t{key_text.back()}, i);
+    transparent_map.emplace(var_t{key_text.back()}, i);
+    plain_map.emplace(var_t{static_cast<int64_t>(i)}, i);
+    transparent_map.emplace(var_t{static_cast<int64_t>(i)}, i);
+  }
+
+  // Probes are views into a buffer, as for instance when parsing
+  std::vector<std::string_view> probes;
+  std::mt19937 rng{rng_seed};
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    probes.push_back(key_text[rng() % num_keys]);
+  }
+
+  benchmark::run_operation("map find, temporary variant", seq_length, repeat_num, [&]() {
+    uint64_t total = 0;
+    for (std::string_view p : probes) {
+      total += plain_map.find(var_t{std::string{p}})->second;
+    }
+    return total;
+  });
+
+  benchmark::run_operation("map find, transparent_variant_comparator", seq_length, repeat_num,
+                           [&]() {
+                             uint64_t total = 0;
+                             for (std::string_view p : probes) {
+                               total += transparent_map.find(p)->second;
+                             }
+                             return total;
+                           });
+}
@@ -0,0 +1,151 @@
+#include "bench_ops.hpp"
+#include <strict_variant/thread_pool.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_parallel.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/***
+ * Visits a sequence of variants in which the cost of the value types differs
+ * by a factor of about 1000, and the costly ones are clustered in one part of
+ * the sequence, as in a log with a burst of large messages.
+ *
+ * Compares a serial loop, an equal split over `std::thread`s, and
+ * `parallel_visit` / `parallel_reduce` on pools from 1 thread up to all of
+ * the local cores.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+
+struct small_msg {
+  uint32_t value;
+};
+
+struct large_msg {
+  uint32_t seed;
+  uint32_t rounds;
+};
+
+using msg_t = strict_variant::variant<small_msg, large_msg>;
+
+struct cost_visitor {
+  uint64_t operator()(const small_msg & m) const { return m.value; }
+  uint64_t operator()(const large_msg & m) const {
+    uint64_t x = m.seed;
+    for (uint32_t i = 0; i < m.rounds; ++i) {
+      x = x * 6364136223846793005ull + 1442695040888963407ull;
+    }
+    return x >> 32;
+  }
+};
+
+// One in 16 of the messages is large, and all of them are in the first 8th
+std::vector<msg_t>
+make_msgs() {
+  std::vector<msg_t> result;
+  result.reserve(seq_length);
+  const uint32_t num_large = seq_length / 16;
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    if (i % 2 == 0 && i / 2 < num_large) {
+      result.emplace_back(large_msg{i, 1000});
+    } else {
+      result.emplace_back(small_msg{i});
+    }
+  }
+  return result;
+}
+
+uint64_t
+serial(const std::vector<msg_t> & msgs) {
+  uint64_t sum = 0;
+  for (const msg_t & m : msgs) {
+    sum += strict_variant::apply_visitor(cost_visitor{}, m);
+  }
+  return sum;
+}
+
+// Each thread takes an equal part of the sequence
+uint64_t
+static_split(const std::vector<msg_t> & msgs, unsigned num_threads) {
+  std::vector<uint64_t> sums(num_threads);
+  std::vector<std::thread> threads;
+  const std::size_t part = (msgs.size() + num_threads - 1) / num_threads;
+  for (unsigned t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      uint64_t sum = 0;
+      const std::size_t end = std::min(msgs.size(), (t + 1) * part);
+      for (std::size_t i = t * part; i < end; ++i) {
+        sum += strict_variant::apply_visitor(cost_visitor{}, msgs[i]);
+      }
+      sums[t] = sum;
+    });
+  }
+  uint64_t sum = 0;
+  for (unsigned t = 0; t < num_threads; ++t) {
+    threads[t].join();
+    sum += sums[t];
+  }
+  return sum;
+}
+
+struct sum_visitor {
+  std::atomic<uint64_t> & sum;
+
+  template <typename T>
+  void operator()(const T & m) const {
+    sum.fetch_add(cost_visitor{}(m), std::memory_order_relaxed);
+  }
+};
+
+uint64_t
+pool_visit(const std::vector<msg_t> & msgs, strict_variant::thread_pool & pool) {
+  std::atomic<uint64_t> sum{0};
+  strict_variant::parallel_visit(msgs.begin(), msgs.end(), sum_visitor{sum}, pool);
+  return sum.load();
+}
+
+uint64_t
+pool_reduce(const std::vector<msg_t> & msgs, strict_variant::thread_pool & pool) {
+  return strict_variant::parallel_reduce(msgs.begin(), msgs.end(), uint64_t{0}, cost_visitor{},
+                                         std::plus<uint64_t>{}, pool);
+}
+
+template <typename F>
+void
+bench(const char * label, unsigned num_threads, F && f) {
+  uint64_t sum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t r = 0; r < repeat_num; ++r) {
+    sum += f();
+  }
+  const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+  benchmark::DoNotOptimize(sum);
+
+  const uint64_t items = uint64_t{seq_length} * repeat_num;
+  std::fprintf(stdout, "%s, %u threads:\n  items = %lu\n\naverage nanoseconds per item: %f\n\n\n",
+               label, num_threads, static_cast<unsigned long>(items),
+               static_cast<double>(elapsed.count()) / static_cast<double>(items));
+}
+
+int
+main() {
+  const auto msgs = make_msgs();
+  const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+  bench("serial", 1, [&]() { return serial(msgs); });
+  for (unsigned threads = 1;; threads = std::min(cores, threads * 2)) {
+    strict_variant::thread_pool pool{threads};
+    bench("static split", threads, [&]() { return static_split(msgs, threads); });
+    bench("parallel_visit", threads, [&]() { return pool_visit(msgs, pool); });
+    bench("parallel_reduce", threads, [&]() { return pool_reduce(msgs, pool); });
+    if (threads == cores) { break; }
+  }
+}
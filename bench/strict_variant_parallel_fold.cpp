@@ -0,0 +1,118 @@
+#include "bench_ops.hpp"
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/thread_pool.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_parallel.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <utility>
+
+/***
+ * Evaluates expression trees, in which each leaf does a little arithmetic,
+ * with a recursive visitor and with `parallel_fold` on pools from 1 thread up
+ * to all of the local cores.
+ *
+ * The balanced tree is complete. The skewed tree is a long left spine, with a
+ * small balanced tree on the right of each node, which a split by depth would
+ * balance badly.
+ */
+
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+
+struct binop;
+using expr_t = strict_variant::variant<uint32_t, strict_variant::recursive_wrapper<binop>>;
+
+struct binop {
+  expr_t lhs;
+  expr_t rhs;
+};
+
+uint64_t
+leaf_cost(uint32_t seed) {
+  uint64_t x = seed;
+  for (int i = 0; i < 64; ++i) {
+    x = x * 6364136223846793005ull + 1442695040888963407ull;
+  }
+  return x >> 48;
+}
+
+expr_t
+make_balanced(uint32_t first, int depth) {
+  if (!depth) { return expr_t{first}; }
+  return expr_t{binop{make_balanced(first, depth - 1),
+                      make_balanced(first + (1u << (depth - 1)), depth - 1)}};
+}
+
+expr_t
+make_skewed(uint32_t length, int depth) {
+  expr_t result{0u};
+  for (uint32_t i = 0; i < length; ++i) {
+    result = expr_t{binop{std::move(result), make_balanced(i << depth, depth)}};
+  }
+  return result;
+}
+
+struct serial_eval {
+  uint64_t operator()(uint32_t leaf) const { return leaf_cost(leaf); }
+  uint64_t operator()(const binop & b) const {
+    return strict_variant::apply_visitor(*this, b.lhs)
+           + strict_variant::apply_visitor(*this, b.rhs);
+  }
+};
+
+struct fold_eval {
+  template <typename Ctx>
+  uint64_t operator()(uint32_t leaf, Ctx &) const {
+    return leaf_cost(leaf);
+  }
+
+  template <typename Ctx>
+  uint64_t operator()(const binop & b, Ctx & ctx) const {
+    const auto r = ctx.fold_pair(b.lhs, b.rhs);
+    return r.first + r.second;
+  }
+};
+
+template <typename F>
+void
+bench(const char * label, const char * tree_label, unsigned num_threads, uint64_t leaves, F && f) {
+  uint64_t sum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t r = 0; r < repeat_num; ++r) {
+    sum += f();
+  }
+  const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+  benchmark::DoNotOptimize(sum);
+
+  const uint64_t items = leaves * repeat_num;
+  std::fprintf(stdout,
+               "%s, %s tree, %u threads:\n  items = %lu\n\naverage nanoseconds per item: %f\n\n\n",
+               label, tree_label, num_threads, static_cast<unsigned long>(items),
+               static_cast<double>(elapsed.count()) / static_cast<double>(items));
+}
+
+int
+main() {
+  const expr_t balanced = make_balanced(0, 17);
+  const expr_t skewed = make_skewed(2048, 6);
+  const std::pair<const char *, const expr_t *> trees[] = {{"balanced", &balanced},
+                                                           {"skewed", &skewed}};
+  const uint64_t leaves[] = {uint64_t{1} << 17, 2048 * 64 + 1};
+  const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+
+  for (int t = 0; t < 2; ++t) {
+    const expr_t & tree = *trees[t].second;
+    bench("recursive visitor", trees[t].first, 1, leaves[t],
+          [&]() { return strict_variant::apply_visitor(serial_eval{}, tree); });
+    for (unsigned threads = 1;; threads = std::min(cores, threads * 2)) {
+      strict_variant::thread_pool pool{threads};
+      bench("parallel_fold", trees[t].first, threads, leaves[t],
+            [&]() { return strict_variant::parallel_fold<uint64_t>(tree, fold_eval{}, pool); });
+      if (threads == cores) { break; }
+    }
+  }
+}
@@ -0,0 +1,73 @@
+#include "bench_ops.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_algorithm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+/***
+ * Benchmark of comparing two equal snapshots, i.e. arrays of variants, as in
+ * a change-detection pass. "dispatch ==" compares each pair of values using
+ * a visitor, as `operator ==` does for types that are not bitwise comparable.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+struct dispatch_equal {
+  struct eq_visitor {
+    template <typename T>
+    bool operator()(const strict_variant::detail::value_pair<T> & p) const {
+      return p.first == p.second;
+    }
+  };
+
+  template <typename V>
+  bool operator()(const V & lhs, const V & rhs) const {
+    if (lhs.which() != rhs.which()) { return false; }
+    return V::apply_paired_visitor_impl(eq_visitor{}, lhs, rhs);
+  }
+};
+
+template <typename V, typename A, typename B>
+void
+bench_variant(const char * type_name) {
+  std::mt19937 rng{rng_seed};
+
+  std::vector<V> snapshot;
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    const uint32_t x = static_cast<uint32_t>(rng());
+    if (x % 2) {
+      snapshot.emplace_back(static_cast<A>(x));
+    } else {
+      snapshot.emplace_back(static_cast<B>(x));
+    }
+  }
+  const std::vector<V> copy = snapshot;
+
+  std::fprintf(stdout, "%s\n\n", type_name);
+
+  benchmark::run_operation("std::equal, dispatch ==", seq_length, repeat_num, [&]() {
+    return std::equal(snapshot.begin(), snapshot.end(), copy.begin(), dispatch_equal{});
+  });
+
+  benchmark::run_operation("std::equal, operator ==", seq_length, repeat_num, [&]() {
+    return std::equal(snapshot.begin(), snapshot.end(), copy.begin());
+  });
+
+  benchmark::run_operation("ranges_equal", seq_length, repeat_num, [&]() {
+    return strict_variant::ranges_equal(snapshot.data(), snapshot.data() + snapshot.size(),
+                                        copy.data());
+  });
+}
+
+int
+main() {
+  bench_variant<strict_variant::variant<int32_t, uint32_t>, int32_t, uint32_t>(
+    "variant<int32_t, uint32_t> (no padding):");
+  bench_variant<strict_variant::variant<int64_t, uint64_t>, int64_t, uint64_t>(
+    "variant<int64_t, uint64_t> (padded):");
+}
@@ -0,0 +1,99 @@
+#include "bench_ops.hpp"
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_serialize.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+/***
+ * Throughput of `serialize` and `deserialize`, in MB/s of serialized data,
+ * for a variant of small trivially copyable types, and one with strings and
+ * vectors behind recursive wrappers.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+using small_t = strict_variant::variant<int32_t, uint64_t, double, bool>;
+using mixed_t = strict_variant::variant<int64_t, double, std::string,
+                                        strict_variant::recursive_wrapper<std::vector<int32_t>>>;
+
+small_t
+make_small(std::mt19937 & rng) {
+  const uint32_t x = static_cast<uint32_t>(rng());
+  switch (x % 4) {
+    case 0:
+      return small_t{static_cast<int32_t>(x)};
+    case 1:
+      return small_t{static_cast<uint64_t>(x) << 20};
+    case 2:
+      return small_t{static_cast<double>(x) / 7};
+    default:
+      return small_t{(x & 16) != 0};
+  }
+}
+
+mixed_t
+make_mixed(std::mt19937 & rng) {
+  const uint32_t x = static_cast<uint32_t>(rng());
+  switch (x % 4) {
+    case 0:
+      return mixed_t{static_cast<int64_t>(x)};
+    case 1:
+      return mixed_t{static_cast<double>(x) / 7};
+    case 2:
+      return mixed_t{std::string(x % 32, 'a')};
+    default:
+      return mixed_t{std::vector<int32_t>(x % 16, static_cast<int32_t>(x))};
+  }
+}
+
+void
+report_throughput(double ns_per_item, std::size_t bytes) {
+  const double bytes_per_item = static_cast<double>(bytes) / seq_length;
+  std::fprintf(stdout, "  bytes per item = %f\n  throughput = %f MB/s\n\n\n", bytes_per_item,
+               bytes_per_item * 1000.0 / ns_per_item);
+}
+
+template <typename V>
+void
+bench_type(const std::string & name, V (*make)(std::mt19937 &)) {
+  std::mt19937 rng{rng_seed};
+  std::vector<V> values;
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    values.push_back(make(rng));
+  }
+
+  std::vector<unsigned char> buffer;
+  double ns = benchmark::run_operation(("serialize, " + name).c_str(), seq_length, repeat_num,
+                                       [&]() {
+                                         buffer.clear();
+                                         for (const V & v : values) {
+                                           strict_variant::serialize(v, buffer);
+                                         }
+                                         return buffer.size();
+                                       });
+  report_throughput(ns, buffer.size());
+
+  std::vector<V> results(values.size(), values.front());
+  ns = benchmark::run_operation(("deserialize, " + name).c_str(), seq_length, repeat_num, [&]() {
+    strict_variant::byte_source src{buffer.data(), buffer.size()};
+    std::size_t ok = 0;
+    for (V & r : results) {
+      ok += strict_variant::deserialize(src, r);
+    }
+    return ok;
+  });
+  report_throughput(ns, buffer.size());
+}
+
+int
+main() {
+  bench_type<small_t>("trivially copyable", &make_small);
+  bench_type<mixed_t>("strings and vectors", &make_mixed);
+}
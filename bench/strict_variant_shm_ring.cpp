@@ -0,0 +1,197 @@
+#include "bench_ops.hpp"
+#include <strict_variant/offset_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_serialize.hpp>
+#include <strict_variant/variant_shm_ring.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/***
+ * Throughput of passing variants from one process to another: through a
+ * `shm_ring`, which the consumer maps at a different address, and through a
+ * pipe, serializing each message. One in four messages carries a string.
+ *
+ * The parent produces, and the time is until the child has consumed and
+ * checked every message. Both sides yield when the ring is full or empty, so
+ * that the result is meaningful on a single core.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint64_t num_messages{uint64_t{seq_length} * repeat_num};
+
+struct tick {
+  uint64_t id;
+  double price;
+};
+
+using shm_msg_t = strict_variant::variant<tick, strict_variant::offset_array<char>>;
+using pipe_msg_t = strict_variant::variant<tick, std::string>;
+using ring_t = strict_variant::shm_ring<shm_msg_t>;
+
+struct sum_visitor {
+  uint64_t & sum;
+
+  void operator()(const tick & t) const { sum += t.id; }
+  void operator()(const strict_variant::offset_array<char> & s) const { sum += s.size(); }
+  void operator()(const std::string & s) const { sum += s.size(); }
+};
+
+std::string
+make_note(uint64_t i) {
+  return std::string(static_cast<std::size_t>(i % 48), 'n');
+}
+
+uint64_t
+expected_sum() {
+  uint64_t sum = 0;
+  for (uint64_t i = 0; i < num_messages; ++i) {
+    sum += (i % 4 == 3) ? make_note(i).size() : i;
+  }
+  return sum;
+}
+
+// Run `consumer` in a child process, and `producer` here. Returns nanoseconds
+// per message, or a negative number if the child failed.
+template <typename P, typename C>
+double
+run(const char * name, P && producer, C && consumer) {
+  const auto start = std::chrono::steady_clock::now();
+  const pid_t pid = ::fork();
+  if (pid == 0) { std::_Exit(consumer() ? 0 : 1); }
+  producer();
+  int status = 0;
+  ::waitpid(pid, &status, 0);
+  const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+
+  const double ns = static_cast<double>(elapsed.count()) / static_cast<double>(num_messages);
+  const bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  std::fprintf(stdout, "%s:\n  items = %lu\n\naverage nanoseconds per item: %f\n  %s\n\n\n", name,
+               static_cast<unsigned long>(num_messages), ns, ok ? "ok" : "FAILED");
+  return ok ? ns : -1;
+}
+
+void
+bench_shm_ring(const std::string & path, std::size_t slots) {
+  const std::size_t size = ring_t::required_size(slots, 256);
+  const int fd = ::open(path.c_str(), O_RDWR);
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) { return; }
+  void * mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ring_t * ring = ring_t::create(mem, slots, 256);
+
+  const std::string name = "shm_ring, " + std::to_string(slots) + " slots";
+  run(name.c_str(),
+      [&]() {
+        for (uint64_t i = 0; i < num_messages; ++i) {
+          if (i % 4 == 3) {
+            while (!ring->try_emplace<strict_variant::offset_array<char>>(make_note(i))) {
+              ::sched_yield();
+            }
+          } else {
+            while (!ring->try_emplace<tick>(tick{i, 1.5})) {
+              ::sched_yield();
+            }
+          }
+        }
+      },
+      [&]() {
+        // Another mapping, at a different address
+        void * other = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ring_t * r = ring_t::attach(other);
+        if (!r || other == mem) { return false; }
+        uint64_t sum = 0;
+        uint64_t count = 0;
+        while (count < num_messages) {
+          const std::size_t n = r->consume_all(
+            [&](const shm_msg_t & m) { strict_variant::apply_visitor(sum_visitor{sum}, m); });
+          if (!n) { ::sched_yield(); }
+          count += n;
+        }
+        return sum == expected_sum();
+      });
+
+  ::munmap(mem, size);
+  ::close(fd);
+}
+
+void
+bench_pipe() {
+  int fds[2];
+  if (::pipe(fds) != 0) { return; }
+
+  run("pipe, serialize",
+      [&]() {
+        ::close(fds[0]);
+        std::vector<unsigned char> buffer;
+        for (uint64_t i = 0; i < num_messages; ++i) {
+          if (i % 4 == 3) {
+            strict_variant::serialize(pipe_msg_t{make_note(i)}, buffer);
+          } else {
+            strict_variant::serialize(pipe_msg_t{tick{i, 1.5}}, buffer);
+          }
+          if (buffer.size() >= 4096 || i + 1 == num_messages) {
+            std::size_t written = 0;
+            while (written < buffer.size()) {
+              const ssize_t n = ::write(fds[1], buffer.data() + written, buffer.size() - written);
+              if (n <= 0) { return; }
+              written += static_cast<std::size_t>(n);
+            }
+            buffer.clear();
+          }
+        }
+        ::close(fds[1]);
+      },
+      [&]() {
+        ::close(fds[1]);
+        std::vector<unsigned char> buffer;
+        unsigned char chunk[65536];
+        uint64_t sum = 0;
+        uint64_t count = 0;
+        pipe_msg_t value{tick{0, 0}};
+        for (;;) {
+          const ssize_t n = ::read(fds[0], chunk, sizeof(chunk));
+          if (n <= 0) { break; }
+          buffer.insert(buffer.end(), chunk, chunk + n);
+
+          // Records may be split across reads
+          strict_variant::byte_source src{buffer.data(), buffer.size()};
+          const unsigned char * done = src.pos;
+          while (strict_variant::deserialize(src, value)) {
+            strict_variant::apply_visitor(sum_visitor{sum}, value);
+            ++count;
+            done = src.pos;
+          }
+          buffer.erase(buffer.begin(), buffer.begin() + (done - buffer.data()));
+        }
+        return count == num_messages && sum == expected_sum();
+      });
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+int
+main() {
+  char name[] = "/tmp/strict_variant_shm_ring_XXXXXX";
+  const int fd = ::mkstemp(name);
+  if (fd < 0) { return 1; }
+  ::close(fd);
+  const std::string path = name;
+
+  bench_shm_ring(path, 64);
+  bench_shm_ring(path, 4096);
+  bench_pipe();
+
+  ::unlink(path.c_str());
+}
@@ -0,0 +1,137 @@
+#include "bench_ops.hpp"
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_snapshot.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***
+ * Lookups in a routing table, which is a tree of variants, from 1 to 64
+ * reader threads, while a writer replaces the table every millisecond. The
+ * table is held in a `variant_snapshot`, and in a variant guarded by a
+ * `std::mutex`.
+ *
+ * Reports the wall time per lookup, over all of the readers, so perfect
+ * scaling on enough cores would divide it by the number of readers.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint64_t lookups_per_reader{uint64_t{seq_length} * repeat_num / 64};
+
+struct node;
+using table_t = strict_variant::variant<uint32_t, strict_variant::recursive_wrapper<node>>;
+
+// Keys below `split` go left
+struct node {
+  uint32_t split;
+  table_t lo;
+  table_t hi;
+};
+
+// Routes for keys in [first, last), each to `first + version`
+table_t
+make_table(uint32_t first, uint32_t last, uint32_t version) {
+  if (last - first == 1) { return table_t{first + version}; }
+  const uint32_t mid = first + (last - first) / 2;
+  return table_t{node{mid, make_table(first, mid, version), make_table(mid, last, version)}};
+}
+
+uint32_t
+lookup(const table_t & t, uint32_t key) {
+  const table_t * p = &t;
+  while (const node * n = strict_variant::get<node>(p)) {
+    p = key < n->split ? &n->lo : &n->hi;
+  }
+  return *strict_variant::get<uint32_t>(p);
+}
+
+static constexpr uint32_t num_routes = 1024;
+
+struct snapshot_table {
+  strict_variant::variant_snapshot<table_t> snapshot{make_table(0, num_routes, 0)};
+
+  struct reader {
+    strict_variant::variant_snapshot<table_t>::reader r;
+
+    uint32_t lookup(uint32_t key) { return ::lookup(*r.read(), key); }
+  };
+
+  reader make_reader() { return reader{snapshot.make_reader()}; }
+  void store(table_t t) { snapshot.store(std::move(t)); }
+};
+
+struct locked_table {
+  std::mutex mutex;
+  table_t table{make_table(0, num_routes, 0)};
+
+  struct reader {
+    locked_table & t;
+
+    uint32_t lookup(uint32_t key) {
+      std::lock_guard<std::mutex> lock{t.mutex};
+      return ::lookup(t.table, key);
+    }
+  };
+
+  reader make_reader() { return reader{*this}; }
+
+  void store(table_t t) {
+    std::lock_guard<std::mutex> lock{mutex};
+    table = std::move(t);
+  }
+};
+
+template <typename Table>
+void
+bench(const char * label, unsigned num_readers) {
+  Table table;
+  std::atomic<unsigned> reading{num_readers};
+  uint32_t version = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> readers;
+  for (unsigned t = 0; t < num_readers; ++t) {
+    readers.emplace_back([&table, &reading, t]() {
+      auto r = table.make_reader();
+      uint32_t sum = 0;
+      uint32_t key = t;
+      for (uint64_t i = 0; i < lookups_per_reader; ++i) {
+        key = key * 1103515245u + 12345u;
+        sum += r.lookup((key >> 8) % num_routes);
+      }
+      benchmark::DoNotOptimize(sum);
+      --reading;
+    });
+  }
+  // The new table is built outside of the lock
+  while (reading.load()) {
+    table.store(make_table(0, num_routes, ++version));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  for (std::thread & t : readers) {
+    t.join();
+  }
+  const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+
+  const uint64_t lookups = lookups_per_reader * num_readers;
+  std::fprintf(stdout,
+               "%s, %u readers:\n  items = %lu\n  versions = %u\n\naverage nanoseconds per item: "
+               "%f\n\n\n",
+               label, num_readers, static_cast<unsigned long>(lookups), version,
+               static_cast<double>(elapsed.count()) / static_cast<double>(lookups));
+}
+
+int
+main() {
+  for (unsigned readers : {1u, 2u, 4u, 8u, 16u, 32u, 64u}) {
+    bench<snapshot_table>("variant_snapshot", readers);
+    bench<locked_table>("mutex", readers);
+  }
+}
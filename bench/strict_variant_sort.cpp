@@ -0,0 +1,89 @@
+#include "bench_ops.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_algorithm.hpp>
+#include <strict_variant/variant_compare.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***
+ * Benchmarks of `strict_variant::sort` against `std::sort` with
+ * `variant_comparator`, for a uniform and a skewed distribution of the value
+ * types.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+using var_t = strict_variant::variant<int32_t, uint64_t, double, std::string>;
+
+// `weights` gives the relative frequency of each value type
+std::vector<var_t>
+make_values(const uint32_t (&weights)[4]) {
+  std::mt19937 rng{rng_seed};
+  std::discrete_distribution<int> dist{weights, weights + 4};
+
+  std::vector<var_t> values;
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    const uint32_t x = static_cast<uint32_t>(rng() % 100000);
+    switch (dist(rng)) {
+      case 0:
+        values.emplace_back(static_cast<int32_t>(x) - 50000);
+        break;
+      case 1:
+        values.emplace_back(static_cast<uint64_t>(x));
+        break;
+      case 2:
+        values.emplace_back(static_cast<double>(x) / 7);
+        break;
+      default:
+        values.emplace_back(std::to_string(x));
+        break;
+    }
+  }
+  return values;
+}
+
+void
+bench_distribution(const std::string & name, const uint32_t (&weights)[4]) {
+  const std::vector<var_t> values = make_values(weights);
+  std::vector<var_t> work;
+
+  benchmark::run_operation(("std::sort, variant_comparator, " + name).c_str(), seq_length,
+                           repeat_num, [&]() {
+                             work = values;
+                             std::sort(work.begin(), work.end(),
+                                       strict_variant::variant_comparator<var_t>{});
+                             return work.front().which();
+                           });
+
+  benchmark::run_operation(("strict_variant::sort_by_which, 1 thread, " + name).c_str(), seq_length,
+                           repeat_num, [&]() {
+                             work = values;
+                             strict_variant::sort_by_which(work.begin(), work.end(), 1);
+                             return work.front().which();
+                           });
+
+  const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  benchmark::run_operation(
+    ("strict_variant::sort_by_which, " + std::to_string(threads) + " threads, " + name).c_str(),
+    seq_length, repeat_num, [&]() {
+      work = values;
+      strict_variant::sort_by_which(work.begin(), work.end(), threads);
+      return work.front().which();
+    });
+}
+
+int
+main() {
+  const uint32_t uniform[4] = {1, 1, 1, 1};
+  const uint32_t skewed[4] = {90, 5, 4, 1};
+
+  bench_distribution("uniform", uniform);
+  bench_distribution("skewed", skewed);
+}
@@ -0,0 +1,151 @@
+#include "bench_ops.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_compare.hpp>
+#include <strict_variant/variant_sort_key.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+/***
+ * Benchmarks of sorting and searching variants through `variant_comparator`,
+ * against encoding them with `encode_sort_key` and using byte comparisons, or
+ * an MSD radix sort.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+using var_t = strict_variant::variant<int32_t, uint64_t, double, std::string>;
+using comparator_t = strict_variant::variant_comparator<var_t>;
+
+var_t
+make_value(std::mt19937 & rng) {
+  const uint32_t x = static_cast<uint32_t>(rng());
+  switch (x % 4) {
+    case 0:
+      return var_t{static_cast<int32_t>(x % 100000) - 50000};
+    case 1:
+      return var_t{static_cast<uint64_t>(x % 100000)};
+    case 2:
+      return var_t{static_cast<double>(x % 100000) / 7};
+    default:
+      return var_t{std::to_string(x % 100000)};
+  }
+}
+
+std::string
+sort_key(const var_t & v) {
+  std::string result;
+  strict_variant::encode_sort_key(v, result);
+  return result;
+}
+
+// MSD radix sort of strings, by pointer. Small buckets fall back to std::sort.
+void
+radix_sort(const std::string ** first, const std::string ** last, std::size_t depth,
+           std::vector<const std::string *> & buffer) {
+  const std::size_t n = static_cast<std::size_t>(last - first);
+  if (n < 64) {
+    std::sort(first, last, [](const std::string * a, const std::string * b) { return *a < *b; });
+    return;
+  }
+
+  // Bucket 0 is for strings which end at depth
+  std::size_t counts[258] = {};
+  auto bucket = [depth](const std::string * s) -> std::size_t {
+    return s->size() > depth ? static_cast<unsigned char>((*s)[depth]) + 1u : 0u;
+  };
+  for (const std::string ** it = first; it != last; ++it) {
+    ++counts[bucket(*it) + 1];
+  }
+  for (std::size_t b = 1; b < 258; ++b) {
+    counts[b] += counts[b - 1];
+  }
+
+  buffer.resize(n);
+  std::size_t offsets[257];
+  std::copy(counts, counts + 257, offsets);
+  for (const std::string ** it = first; it != last; ++it) {
+    buffer[offsets[bucket(*it)]++] = *it;
+  }
+  std::copy(buffer.begin(), buffer.end(), first);
+
+  for (std::size_t b = 1; b < 257; ++b) {
+    if (counts[b + 1] - counts[b] > 1) {
+      radix_sort(first + counts[b], first + counts[b + 1], depth + 1, buffer);
+    }
+  }
+}
+
+int
+main() {
+  std::mt19937 rng{rng_seed};
+
+  std::vector<var_t> values;
+  std::vector<var_t> probes;
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    values.push_back(make_value(rng));
+    probes.push_back(make_value(rng));
+  }
+
+  std::vector<std::string> keys(values.size());
+  std::vector<std::string> probe_keys;
+  for (const var_t & p : probes) {
+    probe_keys.push_back(sort_key(p));
+  }
+
+  benchmark::run_operation("encode_sort_key", seq_length, repeat_num, [&]() {
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      keys[i].clear();
+      strict_variant::encode_sort_key(values[i], keys[i]);
+    }
+    return keys.back().size();
+  });
+
+  std::vector<var_t> sorted_values;
+  benchmark::run_operation("std::sort, variant_comparator", seq_length, repeat_num, [&]() {
+    sorted_values = values;
+    std::sort(sorted_values.begin(), sorted_values.end(), comparator_t{});
+    return sorted_values.front().which();
+  });
+
+  std::vector<std::string> sorted_keys;
+  benchmark::run_operation("std::sort, sort keys", seq_length, repeat_num, [&]() {
+    sorted_keys = keys;
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+    return sorted_keys.front().size();
+  });
+
+  std::vector<const std::string *> key_ptrs(keys.size());
+  std::vector<const std::string *> buffer;
+  benchmark::run_operation("radix sort, sort keys", seq_length, repeat_num, [&]() {
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      key_ptrs[i] = &keys[i];
+    }
+    radix_sort(key_ptrs.data(), key_ptrs.data() + key_ptrs.size(), 0, buffer);
+    return key_ptrs.front()->size();
+  });
+
+  benchmark::run_operation("lower_bound, variant_comparator", seq_length, repeat_num, [&]() {
+    std::size_t total = 0;
+    for (const var_t & p : probes) {
+      total += static_cast<std::size_t>(
+        std::lower_bound(sorted_values.begin(), sorted_values.end(), p, comparator_t{})
+        - sorted_values.begin());
+    }
+    return total;
+  });
+
+  benchmark::run_operation("lower_bound, sort keys", seq_length, repeat_num, [&]() {
+    std::size_t total = 0;
+    for (const std::string & p : probe_keys) {
+      total += static_cast<std::size_t>(
+        std::lower_bound(sorted_keys.begin(), sorted_keys.end(), p) - sorted_keys.begin());
+    }
+    return total;
+  });
+}
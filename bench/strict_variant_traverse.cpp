@@ -0,0 +1,129 @@
+#include "bench_ops.hpp"
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_traverse.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+/***
+ * Sums the leaves of a balanced binary tree, and of a list, with a recursive
+ * visitor, and with `visit_preorder`, `visit_postorder` and `fold_tree`.
+ *
+ * The list is kept short enough to be visited recursively.
+ */
+
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+
+struct binop;
+using expr_t = strict_variant::variant<uint32_t, strict_variant::recursive_wrapper<binop>>;
+
+struct binop {
+  expr_t lhs;
+  expr_t rhs;
+};
+
+expr_t
+make_balanced(uint32_t first, int depth) {
+  if (!depth) { return expr_t{first}; }
+  return expr_t{binop{make_balanced(first, depth - 1),
+                      make_balanced(first + (1u << (depth - 1)), depth - 1)}};
+}
+
+// A list of binops, each with a leaf on the left
+void
+make_list(expr_t & list, uint32_t length) {
+  expr_t * tail = &list;
+  for (uint32_t i = 0; i < length; ++i) {
+    tail->emplace<binop>(binop{expr_t{i}, expr_t{0u}});
+    tail = &strict_variant::get<binop>(tail)->rhs;
+  }
+}
+
+uint64_t
+count_nodes(const expr_t & e) {
+  const binop * b = strict_variant::get<binop>(&e);
+  return b ? 1 + count_nodes(b->lhs) + count_nodes(b->rhs) : 1;
+}
+
+struct recursive_sum {
+  uint64_t operator()(uint32_t leaf) const { return leaf; }
+  uint64_t operator()(const binop & b) const {
+    return strict_variant::apply_visitor(*this, b.lhs)
+           + strict_variant::apply_visitor(*this, b.rhs);
+  }
+};
+
+struct expr_children {
+  template <typename Push>
+  void operator()(const binop & b, Push & push) const {
+    push(b.lhs);
+    push(b.rhs);
+  }
+
+  template <typename Push>
+  void operator()(uint32_t, Push &) const {}
+};
+
+struct leaf_sum {
+  uint64_t & sum;
+
+  void operator()(uint32_t leaf) const { sum += leaf; }
+  void operator()(const binop &) const {}
+};
+
+struct fold_sum {
+  uint64_t operator()(uint32_t leaf, const strict_variant::child_results<uint64_t> &) const {
+    return leaf;
+  }
+  uint64_t operator()(const binop &, const strict_variant::child_results<uint64_t> & r) const {
+    return r[0] + r[1];
+  }
+};
+
+template <typename F>
+void
+bench(const char * label, const char * tree_label, uint64_t nodes, F && f) {
+  uint64_t sum = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t r = 0; r < repeat_num; ++r) {
+    sum += f();
+  }
+  const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+  benchmark::DoNotOptimize(sum);
+
+  const uint64_t items = nodes * repeat_num;
+  std::fprintf(stdout, "%s, %s:\n  items = %lu\n\naverage nanoseconds per item: %f\n\n\n", label,
+               tree_label, static_cast<unsigned long>(items),
+               static_cast<double>(elapsed.count()) / static_cast<double>(items));
+}
+
+void
+bench_tree(const char * tree_label, const expr_t & tree) {
+  const uint64_t nodes = count_nodes(tree);
+  bench("recursive visitor", tree_label, nodes,
+        [&]() { return strict_variant::apply_visitor(recursive_sum{}, tree); });
+  bench("visit_preorder", tree_label, nodes, [&]() {
+    uint64_t sum = 0;
+    strict_variant::visit_preorder(tree, expr_children{}, leaf_sum{sum});
+    return sum;
+  });
+  bench("visit_postorder", tree_label, nodes, [&]() {
+    uint64_t sum = 0;
+    strict_variant::visit_postorder(tree, expr_children{}, leaf_sum{sum});
+    return sum;
+  });
+  bench("fold_tree", tree_label, nodes,
+        [&]() { return strict_variant::fold_tree<uint64_t>(tree, expr_children{}, fold_sum{}); });
+}
+
+int
+main() {
+  const expr_t balanced = make_balanced(0, 18);
+  bench_tree("balanced tree", balanced);
+
+  expr_t list{0u};
+  make_list(list, 10000);
+  bench_tree("list", list);
+}
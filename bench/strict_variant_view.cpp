@@ -0,0 +1,95 @@
+#include "bench_ops.hpp"
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_serialize.hpp>
+#include <strict_variant/variant_view.hpp>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+/***
+ * Compares loading a buffer of serialized variants by deserializing all of it,
+ * with indexing it using `variant_array_view`. Then compares one visitation
+ * pass over the loaded values with one over the views.
+ */
+
+static constexpr uint32_t seq_length{SEQ_LENGTH};
+static constexpr uint32_t repeat_num{REPEAT_NUM};
+static constexpr uint32_t rng_seed{RNG_SEED};
+
+using var_t = strict_variant::variant<int64_t, double, std::string, std::vector<int32_t>>;
+
+var_t
+make_value(std::mt19937 & rng) {
+  const uint32_t x = static_cast<uint32_t>(rng());
+  switch (x % 4) {
+    case 0:
+      return var_t{static_cast<int64_t>(x)};
+    case 1:
+      return var_t{static_cast<double>(x) / 7};
+    case 2:
+      return var_t{std::string(x % 32, 'a')};
+    default:
+      return var_t{std::vector<int32_t>(x % 16, static_cast<int32_t>(x))};
+  }
+}
+
+// Sums something from each value, so that it has to be read
+struct sum_visitor {
+  uint64_t operator()(int64_t i) const { return static_cast<uint64_t>(i); }
+  uint64_t operator()(double d) const { return static_cast<uint64_t>(d); }
+
+  uint64_t operator()(const std::string & s) const { return s.size(); }
+  uint64_t operator()(const strict_variant::string_ref & s) const { return s.size(); }
+
+  uint64_t operator()(const std::vector<int32_t> & v) const {
+    return v.empty() ? 0 : static_cast<uint64_t>(v.back());
+  }
+  uint64_t operator()(const strict_variant::vector_ref<int32_t> & v) const {
+    return v.empty() ? 0 : static_cast<uint64_t>(v[v.size() - 1]);
+  }
+};
+
+int
+main() {
+  std::mt19937 rng{rng_seed};
+  std::vector<unsigned char> buffer;
+  for (uint32_t i = 0; i < seq_length; ++i) {
+    strict_variant::serialize(make_value(rng), buffer);
+  }
+
+  std::vector<var_t> values;
+  benchmark::run_operation("load, deserialize", seq_length, repeat_num, [&]() {
+    values.clear();
+    values.reserve(seq_length);
+    strict_variant::byte_source src{buffer.data(), buffer.size()};
+    while (src.remaining()) {
+      values.emplace_back(int64_t{0});
+      strict_variant::deserialize(src, values.back());
+    }
+    return values.size();
+  });
+
+  strict_variant::variant_array_view<var_t> view;
+  benchmark::run_operation("load, variant_array_view", seq_length, repeat_num, [&]() {
+    view.assign(buffer.data(), buffer.size());
+    return view.size();
+  });
+
+  benchmark::run_operation("visit, deserialized", seq_length, repeat_num, [&]() {
+    uint64_t result = 0;
+    for (const var_t & v : values) {
+      result += strict_variant::apply_visitor(sum_visitor{}, v);
+    }
+    return result;
+  });
+
+  benchmark::run_operation("visit, variant_view", seq_length, repeat_num, [&]() {
+    uint64_t result = 0;
+    for (std::size_t i = 0; i < view.size(); ++i) {
+      result += strict_variant::apply_visitor(sum_visitor{}, view[i]);
+    }
+    return result;
+  });
+}
@@ -0,0 +1,282 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * For use with strict_variant::variant
+ *
+ * `arena_wrapper<T, Arena>` is like `recursive_wrapper<T>`, but allocates its
+ * value from a bump arena, and never frees it. The whole tree is freed at once
+ * when the arena is released, which is much cheaper than freeing each node.
+ *
+ * The destructor of the wrapper does not run the destructor of its value
+ * either, so destroying a tree is free. So the values should not own other
+ * resources, such as a `std::string` or a `std::vector` using the heap, which
+ * would leak. Variants, and other `arena_wrapper`s, are fine.
+ *
+ * `Arena` is a type with a static function `allocate(size, alignment)`. The
+ * default, `thread_arena`, allocates from the `bump_arena` installed on the
+ * calling thread by an `arena_scope`, or else from an arena of the thread's
+ * own. Values are only valid until the arena they came from is released.
+ */
+
+#include <strict_variant/wrapper.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// #define STRICT_VARIANT_DEBUG
+
+#ifdef STRICT_VARIANT_DEBUG
+#include <cassert>
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+    assert((X) && C);                                                                              \
+  } while (0)
+
+#else // STRICT_VARIANT_DEBUG
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+  } while (0)
+
+#endif // STRICT_VARIANT_DEBUG
+
+namespace strict_variant {
+
+//[ strict_variant_bump_arena
+/***
+ * Allocates by bumping a pointer through blocks obtained from
+ * `operator new`. Blocks double in size, up to `max_block_size`, and a larger
+ * allocation gets a block of its own size. Memory is only returned by
+ * `release()`, and by the destructor. Not thread-safe.
+ */
+class bump_arena {
+  struct block {
+    block * prev;
+    std::size_t size;
+  };
+
+  static constexpr std::size_t header_size =
+    (sizeof(block) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+  static constexpr std::size_t max_block_size = std::size_t{1} << 20;
+
+  block * m_block = nullptr;
+  std::uintptr_t m_next = 0;
+  std::uintptr_t m_end = 0;
+  std::size_t m_next_size;
+  std::size_t m_used = 0;
+  std::size_t m_spanned = 0;
+
+  void new_block(std::size_t min_size) {
+    std::size_t size = m_next_size;
+    if (size < min_size + header_size) { size = min_size + header_size; }
+    block * b = static_cast<block *>(::operator new(size));
+    b->prev = m_block;
+    b->size = size;
+    m_block = b;
+    m_next = reinterpret_cast<std::uintptr_t>(b) + header_size;
+    m_end = reinterpret_cast<std::uintptr_t>(b) + size;
+    if (m_next_size < max_block_size) { m_next_size *= 2; }
+  }
+
+public:
+  explicit bump_arena(std::size_t first_block_size = 4096) noexcept
+    : m_next_size(first_block_size > 2 * header_size ? first_block_size : 2 * header_size) {}
+
+  bump_arena(const bump_arena &) = delete;
+  bump_arena & operator=(const bump_arena &) = delete;
+
+  bump_arena(bump_arena && other) noexcept //
+    : m_block(other.m_block)
+    , m_next(other.m_next)
+    , m_end(other.m_end)
+    , m_next_size(other.m_next_size)
+    , m_used(other.m_used)
+    , m_spanned(other.m_spanned) //
+  {
+    other.m_block = nullptr;
+    other.m_next = other.m_end = 0;
+    other.m_used = other.m_spanned = 0;
+  }
+
+  ~bump_arena() noexcept {
+    while (m_block) {
+      block * prev = m_block->prev;
+      ::operator delete(m_block);
+      m_block = prev;
+    }
+  }
+
+  // `alignment` must be a power of two
+  void * allocate(std::size_t size, std::size_t alignment) {
+    std::uintptr_t p = (m_next + alignment - 1) & ~std::uintptr_t{alignment - 1};
+    if (!m_block || p + size > m_end) {
+      this->new_block(size + alignment);
+      p = (m_next + alignment - 1) & ~std::uintptr_t{alignment - 1};
+    }
+    m_next = p + size;
+    m_used += size;
+    m_spanned = ((m_spanned + alignment - 1) & ~(alignment - 1)) + size;
+    return reinterpret_cast<void *>(p);
+  }
+
+  /***
+   * Make sure that the next `bytes` bytes of allocations, with padding, come
+   * from one block, by starting a block of at least that size if needed.
+   */
+  void reserve(std::size_t bytes) {
+    if (!m_block || m_end - m_next < bytes) { this->new_block(bytes); }
+  }
+
+  /***
+   * Free everything allocated from the arena. The most recent block, which is
+   * the largest, is kept for reuse.
+   */
+  void release() noexcept {
+    if (!m_block) { return; }
+    block * b = m_block->prev;
+    while (b) {
+      block * prev = b->prev;
+      ::operator delete(b);
+      b = prev;
+    }
+    m_block->prev = nullptr;
+    m_next = reinterpret_cast<std::uintptr_t>(m_block) + header_size;
+    m_end = reinterpret_cast<std::uintptr_t>(m_block) + m_block->size;
+    m_used = 0;
+    m_spanned = 0;
+  }
+
+  // The number of bytes allocated since the last release, without padding
+  std::size_t bytes_used() const noexcept { return m_used; }
+
+  // The number of bytes which those allocations would span in one block
+  std::size_t bytes_spanned() const noexcept { return m_spanned; }
+};
+//]
+
+namespace detail {
+
+inline bump_arena *&
+current_arena() noexcept {
+  static thread_local bump_arena * a = nullptr;
+  return a;
+}
+
+} // end namespace detail
+
+//[ strict_variant_thread_arena
+/***
+ * The default `Arena` of `arena_wrapper`. Allocates from the arena installed
+ * by the innermost `arena_scope` of the calling thread, or else from the
+ * calling thread's own arena, which `get()` returns.
+ */
+struct thread_arena {
+  static bump_arena & get() noexcept {
+    if (bump_arena * a = detail::current_arena()) { return *a; }
+    static thread_local bump_arena own;
+    return own;
+  }
+
+  static void * allocate(std::size_t size, std::size_t alignment) {
+    return get().allocate(size, alignment);
+  }
+};
+
+/***
+ * Installs an arena for `thread_arena` on the calling thread, for the
+ * lifetime of the scope.
+ */
+class arena_scope {
+  bump_arena * m_prev;
+
+public:
+  explicit arena_scope(bump_arena & a) noexcept
+    : m_prev(detail::current_arena()) {
+    detail::current_arena() = &a;
+  }
+
+  arena_scope(const arena_scope &) = delete;
+  arena_scope & operator=(const arena_scope &) = delete;
+
+  ~arena_scope() noexcept { detail::current_arena() = m_prev; }
+};
+//]
+
+//[ strict_variant_arena_wrapper
+template <typename T, typename Arena = thread_arena>
+class arena_wrapper {
+  T * m_t;
+
+  template <typename... Args>
+  void init(Args &&... args) {
+    // If the constructor throws, the memory stays in the arena until it is
+    // released
+    void * p = Arena::allocate(sizeof(T), alignof(T));
+    m_t = new (p) T(std::forward<Args>(args)...);
+  }
+
+public:
+  typedef T value_type;
+
+  // Neither frees the value nor destroys it
+  ~arena_wrapper() noexcept = default;
+
+  template <typename... Args>
+  arena_wrapper(Args &&... args)
+    : m_t(nullptr) {
+    this->init(std::forward<Args>(args)...);
+  }
+
+  arena_wrapper(arena_wrapper & rhs)
+    : arena_wrapper(static_cast<const arena_wrapper &>(rhs)) {}
+
+  arena_wrapper(const arena_wrapper & rhs)
+    : m_t(nullptr) {
+    this->init(rhs.get());
+  }
+
+  // Pointer move
+  arena_wrapper(arena_wrapper && rhs) noexcept //
+    : m_t(rhs.m_t)                             //
+  {
+    rhs.m_t = nullptr;
+  }
+
+  // Not assignable, like recursive_wrapper
+  arena_wrapper & operator=(const arena_wrapper &) = delete;
+  arena_wrapper & operator=(arena_wrapper &&) = delete;
+
+  T & get() & {
+    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
+    return *m_t;
+  }
+  const T & get() const & {
+    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
+    return *m_t;
+  }
+  T && get() && {
+    STRICT_VARIANT_ASSERT(m_t, "Bad access!");
+    return std::move(*m_t);
+  }
+};
+//]
+
+namespace detail {
+
+template <typename T, typename A>
+struct is_wrapper<arena_wrapper<T, A>> : std::true_type {};
+
+} // end namespace detail
+
+} // end namespace strict_variant
+
+#undef STRICT_VARIANT_ASSERT
@@ -0,0 +1,298 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * An atomic cell holding a variant of trivially copyable types, for state
+ * which one thread publishes and many threads read.
+ *
+ * The value is held as its bytes, zero padded, followed by the `which` value
+ * in the last byte. When that fits in 8 bytes, as for
+ * `atomic_variant<int, float, Mode>`, the cell is a single
+ * `std::atomic<std::uint64_t>`, and every operation is lock-free. Otherwise
+ * the cell is a seqlock: readers retry if a write overlapped their read, and
+ * do not write to the cell, so they do not contend with one another. Writers
+ * exclude each other with a spin lock.
+ *
+ * Like `std::atomic`, `compare_exchange` compares the object representations,
+ * not using `operator ==`. So `0.0` and `-0.0` are different, and value types
+ * should not have padding bytes.
+ */
+
+#include <strict_variant/concurrency.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace strict_variant {
+
+namespace detail {
+
+template <std::size_t N>
+struct atomic_variant_rep {
+  std::uint64_t words[N];
+
+  bool operator==(const atomic_variant_rep & rhs) const noexcept {
+    return std::memcmp(words, rhs.words, sizeof(words)) == 0;
+  }
+};
+
+inline constexpr std::memory_order
+failure_order(std::memory_order order) noexcept {
+  return order == std::memory_order_acq_rel
+           ? std::memory_order_acquire
+           : (order == std::memory_order_release ? std::memory_order_relaxed : order);
+}
+
+template <std::size_t N, bool lock_free = (N == 1 && ATOMIC_LLONG_LOCK_FREE == 2)>
+class atomic_variant_cell;
+
+// A single atomic word
+template <std::size_t N>
+class atomic_variant_cell<N, true> {
+  std::atomic<std::uint64_t> m_word;
+
+public:
+  using rep_t = atomic_variant_rep<1>;
+  static constexpr bool is_always_lock_free = true;
+
+  explicit atomic_variant_cell(const rep_t & r) noexcept
+    : m_word(r.words[0]) {}
+
+  rep_t load(std::memory_order order) const noexcept { return rep_t{{m_word.load(order)}}; }
+
+  void store(const rep_t & r, std::memory_order order) noexcept { m_word.store(r.words[0], order); }
+
+  rep_t exchange(const rep_t & r, std::memory_order order) noexcept {
+    return rep_t{{m_word.exchange(r.words[0], order)}};
+  }
+
+  bool compare_exchange_weak(rep_t & expected, const rep_t & desired, std::memory_order success,
+                             std::memory_order failure) noexcept {
+    return m_word.compare_exchange_weak(expected.words[0], desired.words[0], success, failure);
+  }
+
+  bool compare_exchange_strong(rep_t & expected, const rep_t & desired, std::memory_order success,
+                               std::memory_order failure) noexcept {
+    return m_word.compare_exchange_strong(expected.words[0], desired.words[0], success, failure);
+  }
+};
+
+// A seqlock. The sequence number is odd while a writer holds the lock. The
+// words are atomics, accessed with relaxed ordering, so that a read which
+// overlaps a write is not a data race, only a retry.
+template <std::size_t N>
+class atomic_variant_cell<N, false> {
+public:
+  using rep_t = atomic_variant_rep<N>;
+  static constexpr bool is_always_lock_free = false;
+
+private:
+  std::atomic<std::uint64_t> m_seq;
+  std::atomic<std::uint64_t> m_words[N];
+
+  std::uint64_t lock() noexcept {
+    unsigned spins = 0;
+    for (;;) {
+      std::uint64_t s = m_seq.load(std::memory_order_relaxed);
+      if (!(s & 1)
+          && m_seq.compare_exchange_weak(s, s + 1, std::memory_order_acquire,
+                                         std::memory_order_relaxed)) {
+        // The odd sequence number is visible before any of the writes
+        std::atomic_thread_fence(std::memory_order_release);
+        return s;
+      }
+      spin_wait(spins);
+    }
+  }
+
+  void read_words(rep_t & r) const noexcept {
+    for (std::size_t i = 0; i < N; ++i) {
+      r.words[i] = m_words[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  void write_words(const rep_t & r) noexcept {
+    for (std::size_t i = 0; i < N; ++i) {
+      m_words[i].store(r.words[i], std::memory_order_relaxed);
+    }
+  }
+
+public:
+  explicit atomic_variant_cell(const rep_t & r) noexcept
+    : m_seq(0) {
+    this->write_words(r);
+  }
+
+  // Operations are at least acquire / release, whatever the order
+  rep_t load(std::memory_order) const noexcept {
+    rep_t r;
+    unsigned spins = 0;
+    for (;;) {
+      const std::uint64_t s = m_seq.load(std::memory_order_acquire);
+      if (!(s & 1)) {
+        this->read_words(r);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_seq.load(std::memory_order_relaxed) == s) { return r; }
+      }
+      spin_wait(spins);
+    }
+  }
+
+  void store(const rep_t & r, std::memory_order) noexcept {
+    const std::uint64_t s = this->lock();
+    this->write_words(r);
+    m_seq.store(s + 2, std::memory_order_release);
+  }
+
+  rep_t exchange(const rep_t & r, std::memory_order) noexcept {
+    rep_t old;
+    const std::uint64_t s = this->lock();
+    this->read_words(old);
+    this->write_words(r);
+    m_seq.store(s + 2, std::memory_order_release);
+    return old;
+  }
+
+  bool compare_exchange_strong(rep_t & expected, const rep_t & desired, std::memory_order,
+                               std::memory_order) noexcept {
+    rep_t current;
+    const std::uint64_t s = this->lock();
+    this->read_words(current);
+    if (current == expected) {
+      this->write_words(desired);
+      m_seq.store(s + 2, std::memory_order_release);
+      return true;
+    }
+    // Nothing was written, so readers which started before need not retry
+    m_seq.store(s, std::memory_order_release);
+    expected = current;
+    return false;
+  }
+
+  bool compare_exchange_weak(rep_t & expected, const rep_t & desired, std::memory_order success,
+                             std::memory_order failure) noexcept {
+    return this->compare_exchange_strong(expected, desired, success, failure);
+  }
+};
+
+} // end namespace detail
+
+//[ strict_variant_atomic_variant
+template <typename... Ts>
+class atomic_variant {
+public:
+  using value_type = variant<Ts...>;
+
+private:
+  static_assert(value_type::trivially_copyable_storage,
+                "atomic_variant holds only trivially copyable types");
+  static_assert(sizeof...(Ts) <= 256, "atomic_variant holds at most 256 types");
+
+  static constexpr std::size_t num_words = (value_type::storage_size + 1 + 7) / 8;
+
+  using cell_t = detail::atomic_variant_cell<num_words>;
+  using rep_t = typename cell_t::rep_t;
+
+  cell_t m_cell;
+
+  static rep_t pack(const value_type & v) noexcept {
+    static constexpr std::size_t sizes[] = {sizeof(Ts)...};
+    const unsigned which = static_cast<unsigned>(v.which());
+
+    unsigned char bytes[sizeof(rep_t)] = {};
+    std::memcpy(bytes, value_type::storage_address_impl(v), sizes[which]);
+    bytes[sizeof(rep_t) - 1] = static_cast<unsigned char>(which);
+
+    rep_t r;
+    std::memcpy(&r, bytes, sizeof(rep_t));
+    return r;
+  }
+
+  template <typename T>
+  static value_type unpack_as(const unsigned char * bytes) noexcept {
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    std::memcpy(&storage, bytes, sizeof(T));
+    return value_type{emplace_tag<T>{}, *reinterpret_cast<const T *>(&storage)};
+  }
+
+  static value_type unpack(const rep_t & r) noexcept {
+    using function_t = value_type (*)(const unsigned char *);
+    static constexpr function_t table[] = {&unpack_as<Ts>...};
+
+    unsigned char bytes[sizeof(rep_t)];
+    std::memcpy(bytes, &r, sizeof(rep_t));
+    return table[bytes[sizeof(rep_t) - 1]](bytes);
+  }
+
+public:
+  static constexpr bool is_always_lock_free = cell_t::is_always_lock_free;
+
+  atomic_variant()
+    : atomic_variant(value_type{}) {}
+
+  atomic_variant(const value_type & v) noexcept
+    : m_cell(pack(v)) {}
+
+  atomic_variant(const atomic_variant &) = delete;
+  atomic_variant & operator=(const atomic_variant &) = delete;
+
+  bool is_lock_free() const noexcept { return is_always_lock_free; }
+
+  value_type load(std::memory_order order = std::memory_order_seq_cst) const noexcept {
+    return unpack(m_cell.load(order));
+  }
+
+  void store(const value_type & v, std::memory_order order = std::memory_order_seq_cst) noexcept {
+    m_cell.store(pack(v), order);
+  }
+
+  value_type exchange(const value_type & v,
+                      std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return unpack(m_cell.exchange(pack(v), order));
+  }
+
+  /***
+   * If the value is `expected`, replace it with `desired` and return true.
+   * Otherwise, load the value into `expected` and return false. The weak
+   * version may fail spuriously, as for `std::atomic`.
+   */
+  bool compare_exchange_weak(value_type & expected, const value_type & desired,
+                             std::memory_order success, std::memory_order failure) noexcept {
+    rep_t r = pack(expected);
+    if (m_cell.compare_exchange_weak(r, pack(desired), success, failure)) { return true; }
+    expected = unpack(r);
+    return false;
+  }
+
+  bool compare_exchange_strong(value_type & expected, const value_type & desired,
+                               std::memory_order success, std::memory_order failure) noexcept {
+    rep_t r = pack(expected);
+    if (m_cell.compare_exchange_strong(r, pack(desired), success, failure)) { return true; }
+    expected = unpack(r);
+    return false;
+  }
+
+  bool compare_exchange_weak(value_type & expected, const value_type & desired,
+                             std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return this->compare_exchange_weak(expected, desired, order, detail::failure_order(order));
+  }
+
+  bool compare_exchange_strong(value_type & expected, const value_type & desired,
+                               std::memory_order order = std::memory_order_seq_cst) noexcept {
+    return this->compare_exchange_strong(expected, desired, order, detail::failure_order(order));
+  }
+};
+//]
+
+template <typename... Ts>
+constexpr bool atomic_variant<Ts...>::is_always_lock_free;
+
+} // end namespace strict_variant
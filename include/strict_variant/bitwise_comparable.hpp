@@ -0,0 +1,33 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#include <type_traits>
+
+namespace strict_variant {
+
+/***
+ * Metafunction `is_bitwise_comparable`:
+ *   Detects if two values of type T compare equal exactly when their object
+ *   representations are equal. That means, T is trivially copyable, has no
+ *   padding, and `operator ==` compares all of the bytes.
+ *
+ *   This allows `variant` to compare values using `memcmp` rather than a
+ *   dispatch, and `ranges_equal` to compare whole arrays at once.
+ *
+ *   By default it is true only for integral, enum and pointer types.
+ *   (Floating point types are excluded, since `0.0 == -0.0` and `NaN != NaN`.)
+ *   Specialize it to opt in other types.
+ */
+
+//[ strict_variant_is_bitwise_comparable
+template <typename T>
+struct is_bitwise_comparable
+  : std::integral_constant<bool, std::is_integral<T>::value || std::is_enum<T>::value
+                                   || std::is_pointer<T>::value> {};
+//]
+
+} // end namespace strict_variant
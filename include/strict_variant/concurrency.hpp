@@ -0,0 +1,29 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Helpers shared by the concurrent containers.
+ */
+
+#include <cstddef>
+#include <thread>
+
+namespace strict_variant {
+namespace detail {
+
+// Padding, so that data written by different threads is in different cache
+// lines
+static constexpr std::size_t cache_line_size = 64;
+
+// Spin, and then yield, while waiting for another thread
+inline void
+spin_wait(unsigned & spins) noexcept {
+  if (++spins > 64) { std::this_thread::yield(); }
+}
+
+} // end namespace detail
+} // end namespace strict_variant
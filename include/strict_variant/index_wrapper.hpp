@@ -0,0 +1,311 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * For use with strict_variant::variant
+ *
+ * `index_wrapper<T>` is like `recursive_wrapper<T>`, but holds a 32-bit index
+ * into an `index_pool<T>` rather than a pointer to a node on the heap. So a
+ * variant holding it is smaller, and the nodes of each type are packed
+ * together in the pool, in chunks of 4096, rather than scattered over the heap.
+ *
+ * Indices are resolved, when the variant is visited, through the pool which is
+ * current on the calling thread: the one installed by the innermost
+ * `index_pool<T>::scope`, or else the thread's own pool. So a tree may only be
+ * visited, copied and destroyed on a thread where its pools are current, and
+ * the pools must outlive it. The main thread's own pool outlives trees with
+ * static storage duration.
+ *
+ * After many edits, the live nodes of a pool are interleaved with free slots.
+ * `pool.compact(root)` copies the tree into new storage, in depth-first order,
+ * and frees the old storage, so that traversal is sequential again.
+ */
+
+#include <strict_variant/wrapper.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// #define STRICT_VARIANT_DEBUG
+
+#ifdef STRICT_VARIANT_DEBUG
+#include <cassert>
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+    assert((X) && C);                                                                              \
+  } while (0)
+
+#else // STRICT_VARIANT_DEBUG
+
+#define STRICT_VARIANT_ASSERT(X, C)                                                                \
+  do {                                                                                             \
+  } while (0)
+
+#endif // STRICT_VARIANT_DEBUG
+
+namespace strict_variant {
+
+//[ strict_variant_index_pool
+template <typename T>
+class index_pool {
+  // A free slot holds the index of the next free slot
+  union slot {
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    std::uint32_t next_free;
+  };
+
+  static constexpr unsigned chunk_bits = 12;
+  static constexpr std::uint32_t chunk_size = std::uint32_t{1} << chunk_bits;
+  static constexpr std::uint32_t npos = 0xffffffffu;
+
+  std::vector<std::unique_ptr<slot[]>> m_chunks;
+  std::uint32_t m_free = npos;
+  std::uint32_t m_end = 0;
+  std::size_t m_live = 0;
+
+  static index_pool *& installed() noexcept {
+    static thread_local index_pool * p = nullptr;
+    return p;
+  }
+
+  // The thread's own pool. Thread locals are destroyed before objects with
+  // static storage duration, which may hold nodes of the main thread's pool,
+  // so it is on the heap, and only freed at thread exit if it is empty.
+  static index_pool & own() noexcept {
+    static thread_local index_pool * p = nullptr;
+    if (!p) {
+      struct reclaim {
+        index_pool ** pool;
+        ~reclaim() noexcept {
+          if (!(*pool)->live_count()) {
+            delete *pool;
+            *pool = nullptr;
+          }
+        }
+      };
+
+      p = new index_pool;
+      static thread_local reclaim r{&p};
+    }
+    return *p;
+  }
+
+  // While compacting, new nodes go to another pool
+  static index_pool *& redirected() noexcept {
+    static thread_local index_pool * p = nullptr;
+    return p;
+  }
+
+  slot & slot_at(std::uint32_t i) noexcept {
+    return m_chunks[i >> chunk_bits][i & (chunk_size - 1)];
+  }
+
+  std::uint32_t new_slot() {
+    if (m_free != npos) {
+      const std::uint32_t i = m_free;
+      m_free = this->slot_at(i).next_free;
+      return i;
+    }
+    if (m_end == npos) { throw std::length_error("index_pool is full"); }
+    if ((m_end >> chunk_bits) == m_chunks.size()) {
+      // Owned before the vector grows, so that it is freed if that throws
+      std::unique_ptr<slot[]> chunk{new slot[chunk_size]};
+      m_chunks.push_back(std::move(chunk));
+    }
+    return m_end++;
+  }
+
+  void free_slot(std::uint32_t i) noexcept {
+    this->slot_at(i).next_free = m_free;
+    m_free = i;
+  }
+
+  void swap_storage(index_pool & other) noexcept {
+    m_chunks.swap(other.m_chunks);
+    std::swap(m_free, other.m_free);
+    std::swap(m_end, other.m_end);
+    std::swap(m_live, other.m_live);
+  }
+
+public:
+  /***
+   * Installs a pool as the current pool of `T` on the calling thread, for the
+   * lifetime of the scope.
+   */
+  class scope {
+    index_pool * m_prev;
+
+  public:
+    explicit scope(index_pool & p) noexcept
+      : m_prev(installed()) {
+      installed() = &p;
+    }
+
+    scope(const scope &) = delete;
+    scope & operator=(const scope &) = delete;
+
+    ~scope() noexcept { installed() = m_prev; }
+  };
+
+  index_pool() = default;
+  index_pool(const index_pool &) = delete;
+  index_pool & operator=(const index_pool &) = delete;
+
+  // The nodes which are still live are not destroyed
+  ~index_pool() noexcept = default;
+
+  // The current pool of the calling thread
+  static index_pool & get() noexcept {
+    if (index_pool * p = installed()) { return *p; }
+    return own();
+  }
+
+  // The pool in which `index_wrapper` creates nodes
+  static index_pool & allocating() noexcept {
+    if (index_pool * p = redirected()) { return *p; }
+    return get();
+  }
+
+  template <typename... Args>
+  std::uint32_t create(Args &&... args) {
+    const std::uint32_t i = this->new_slot();
+    try {
+      new (&this->slot_at(i).storage) T(std::forward<Args>(args)...);
+    } catch (...) {
+      this->free_slot(i);
+      throw;
+    }
+    ++m_live;
+    return i;
+  }
+
+  void destroy(std::uint32_t i) noexcept {
+    (*this)[i].~T();
+    this->free_slot(i);
+    --m_live;
+  }
+
+  T & operator[](std::uint32_t i) noexcept {
+    return *reinterpret_cast<T *>(&this->slot_at(i).storage);
+  }
+
+  // The number of live nodes
+  std::size_t live_count() const noexcept { return m_live; }
+
+  // The number of slots which have been used, live or free
+  std::size_t slot_count() const noexcept { return m_end; }
+
+  // The memory held by the pool, in bytes
+  std::size_t memory_usage() const noexcept {
+    return m_chunks.size() * chunk_size * sizeof(slot)
+           + m_chunks.capacity() * sizeof(std::unique_ptr<slot[]>);
+  }
+
+  /***
+   * Move the nodes of the tree `root`, a variant, into new storage, in
+   * depth-first order, and free the old storage. Every live node of the pool
+   * must belong to `root`, and the pool must be current. Nodes of other types
+   * in the tree are copied within their own pools. If copying a node throws,
+   * the tree and the pool are unchanged.
+   */
+  template <typename V>
+  void compact(V & root) {
+    STRICT_VARIANT_ASSERT(&get() == this, "index_pool must be current to compact!");
+    index_pool fresh;
+    {
+      // Nodes are read from this pool, and copies created in the fresh one.
+      // The old nodes are destroyed, with the copy, after the redirect ends.
+      struct redirect {
+        index_pool * prev;
+        explicit redirect(index_pool & p) noexcept
+          : prev(redirected()) {
+          redirected() = &p;
+        }
+        void end() noexcept { redirected() = prev; }
+        ~redirect() noexcept { this->end(); }
+      };
+
+      redirect r{fresh};
+      V copy{root};
+      r.end();
+      root.swap(copy);
+    }
+    STRICT_VARIANT_ASSERT(!m_live, "index_pool had nodes outside of the tree!");
+    this->swap_storage(fresh);
+  }
+};
+//]
+
+//[ strict_variant_index_wrapper
+template <typename T>
+class index_wrapper {
+  static constexpr std::uint32_t npos = 0xffffffffu;
+
+  std::uint32_t m_index;
+
+public:
+  typedef T value_type;
+
+  // A node is freed to the pool it was created in. While compacting, that is
+  // the new pool, for any partial copy destroyed by an exception.
+  ~index_wrapper() noexcept {
+    if (m_index != npos) { index_pool<T>::allocating().destroy(m_index); }
+  }
+
+  template <typename... Args>
+  index_wrapper(Args &&... args)
+    : m_index(index_pool<T>::allocating().create(std::forward<Args>(args)...)) {}
+
+  index_wrapper(index_wrapper & rhs)
+    : index_wrapper(static_cast<const index_wrapper &>(rhs)) {}
+
+  index_wrapper(const index_wrapper & rhs)
+    : m_index(index_pool<T>::allocating().create(rhs.get())) {}
+
+  // Index move
+  index_wrapper(index_wrapper && rhs) noexcept //
+    : m_index(rhs.m_index)                     //
+  {
+    rhs.m_index = npos;
+  }
+
+  // Not assignable, like recursive_wrapper
+  index_wrapper & operator=(const index_wrapper &) = delete;
+  index_wrapper & operator=(index_wrapper &&) = delete;
+
+  T & get() & {
+    STRICT_VARIANT_ASSERT(m_index != npos, "Bad access!");
+    return index_pool<T>::get()[m_index];
+  }
+  const T & get() const & {
+    STRICT_VARIANT_ASSERT(m_index != npos, "Bad access!");
+    return index_pool<T>::get()[m_index];
+  }
+  T && get() && {
+    STRICT_VARIANT_ASSERT(m_index != npos, "Bad access!");
+    return std::move(index_pool<T>::get()[m_index]);
+  }
+};
+//]
+
+namespace detail {
+
+template <typename T>
+struct is_wrapper<index_wrapper<T>> : std::true_type {};
+
+} // end namespace detail
+
+} // end namespace strict_variant
+
+#undef STRICT_VARIANT_ASSERT
@@ -0,0 +1,379 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Position-independent wrappers, for variants in memory which is shared
+ * between processes, and may be mapped at a different address in each.
+ *
+ * `offset_wrapper<T>` is like `recursive_wrapper<T>`, but holds the offset of
+ * the `T` from the wrapper itself instead of a pointer, so a variant holding
+ * one may be read through any mapping of the memory. `offset_array<T>` is a
+ * fixed-size array of a trivially copyable `T`, held the same way, for strings
+ * and other variable-size payloads.
+ *
+ * Both allocate from the current `shm_arena`, which is set by a
+ * `shm_arena::scope`. The arena is a bump allocator whose state is at the
+ * start of its buffer, so that it may be in the shared memory too. Values in
+ * an arena are destroyed, but not freed; the whole arena is reset when it is
+ * no longer used. When there is no current arena, `operator new` is used, so
+ * that values may be built and copied in private memory as usual.
+ *
+ * A move takes the allocation, unless an arena is current and the allocation
+ * is not in it, in which case the value is moved into the arena, so that a
+ * temporary built in private memory may be moved into shared memory. Moves
+ * may not throw, so if the arena is full then, `std::terminate` is called.
+ *
+ * Note: Values moved out of an arena still refer to it, so values should be
+ * copied, not moved, out of an arena which is about to be reset.
+ */
+
+#include <strict_variant/mpl/find_with.hpp>
+#include <strict_variant/variant_fwd.hpp>
+#include <strict_variant/wrapper.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+//[ strict_variant_shm_arena
+/***
+ * A bump allocator in a caller-provided buffer. The arena object is at the
+ * start of the buffer, and the memory it hands out follows it.
+ */
+class shm_arena {
+  std::size_t m_capacity;
+  std::size_t m_used;
+
+  unsigned char * data() noexcept { return reinterpret_cast<unsigned char *>(this + 1); }
+
+public:
+  explicit shm_arena(std::size_t capacity) noexcept
+    : m_capacity(capacity)
+    , m_used(0) {}
+
+  shm_arena(const shm_arena &) = delete;
+  shm_arena & operator=(const shm_arena &) = delete;
+
+  // Construct an arena using `size` bytes at `mem`, which must be aligned
+  // for a `std::max_align_t`. Returns nullptr if there is not enough room.
+  static shm_arena * create(void * mem, std::size_t size) noexcept {
+    if (size < sizeof(shm_arena)) { return nullptr; }
+    return new (mem) shm_arena(size - sizeof(shm_arena));
+  }
+
+  // Returns nullptr if there is not enough room
+  void * allocate(std::size_t size, std::size_t align) noexcept {
+    const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(this->data());
+    const std::uintptr_t p = (base + m_used + align - 1) & ~static_cast<std::uintptr_t>(align - 1);
+    if (p - base > m_capacity || size > m_capacity - (p - base)) { return nullptr; }
+    m_used = static_cast<std::size_t>(p - base) + size;
+    return reinterpret_cast<void *>(p);
+  }
+
+  void reset() noexcept { m_used = 0; }
+
+  bool contains(const void * p) const noexcept {
+    const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(this + 1);
+    const std::uintptr_t x = reinterpret_cast<std::uintptr_t>(p);
+    return x >= base && x - base < m_capacity;
+  }
+
+  std::size_t used() const noexcept { return m_used; }
+  std::size_t capacity() const noexcept { return m_capacity; }
+
+  // The arena used by offset wrappers on this thread, or nullptr
+  static shm_arena *& current() noexcept {
+    static thread_local shm_arena * arena = nullptr;
+    return arena;
+  }
+
+  // Makes an arena current, until the end of the scope
+  class scope {
+    shm_arena * m_prev;
+
+  public:
+    explicit scope(shm_arena & arena) noexcept
+      : m_prev(current()) {
+      current() = &arena;
+    }
+
+    scope(const scope &) = delete;
+    scope & operator=(const scope &) = delete;
+
+    ~scope() noexcept { current() = m_prev; }
+  };
+};
+//]
+
+namespace detail {
+
+// A self-relative pointer. Allocations are at least 2-aligned, so the low bit
+// of the offset marks those which came from `operator new`. Zero is null.
+class offset_ptr {
+  std::ptrdiff_t m_offset = 0;
+
+public:
+  offset_ptr() noexcept = default;
+  offset_ptr(const offset_ptr &) = delete;
+  offset_ptr & operator=(const offset_ptr &) = delete;
+
+  void set(const void * p, bool heap) noexcept {
+    if (!p) {
+      m_offset = 0;
+      return;
+    }
+    const std::uintptr_t diff =
+      reinterpret_cast<std::uintptr_t>(p) - reinterpret_cast<std::uintptr_t>(this);
+    m_offset = static_cast<std::ptrdiff_t>(diff | static_cast<std::uintptr_t>(heap));
+  }
+
+  void * get() const noexcept {
+    if (!m_offset) { return nullptr; }
+    const std::uintptr_t diff = static_cast<std::uintptr_t>(m_offset) & ~std::uintptr_t{1};
+    return reinterpret_cast<void *>(reinterpret_cast<std::uintptr_t>(this) + diff);
+  }
+
+  bool heap() const noexcept { return m_offset & 1; }
+
+  // Point at what `rhs` points at, and make `rhs` null
+  void take(offset_ptr & rhs) noexcept {
+    this->set(rhs.get(), rhs.heap());
+    rhs.m_offset = 0;
+  }
+};
+
+inline void *
+offset_allocate(std::size_t size, std::size_t align, bool & heap) {
+  if (shm_arena * arena = shm_arena::current()) {
+    heap = false;
+    void * p = arena->allocate(size, align < 2 ? 2 : align);
+    if (!p) { throw std::bad_alloc{}; }
+    return p;
+  }
+  heap = true;
+  return ::operator new(size);
+}
+
+// Whether a move should take the allocation at `p`, rather than moving the
+// value into the current arena
+inline bool
+offset_take(const void * p) noexcept {
+  shm_arena * arena = shm_arena::current();
+  return !p || !arena || arena->contains(p);
+}
+
+inline void
+offset_deallocate(const offset_ptr & p) noexcept {
+  if (p.heap()) { ::operator delete(p.get()); }
+}
+
+} // end namespace detail
+
+//[ strict_variant_offset_wrapper
+template <typename T>
+class offset_wrapper {
+  detail::offset_ptr m_ptr;
+
+  // Frees the allocation, unless construction succeeded, as in alloc_wrapper
+  struct initer {
+    void * p;
+    bool heap;
+    bool success;
+
+    initer()
+      : p(nullptr)
+      , heap(false)
+      , success(false) {
+      p = detail::offset_allocate(sizeof(T), alignof(T), heap);
+    }
+
+    ~initer() {
+      if (!success && heap) { ::operator delete(p); }
+    }
+
+    template <typename... Args>
+    void go(Args &&... args) {
+      new (p) T(std::forward<Args>(args)...);
+      success = true;
+    }
+  };
+
+  template <typename... Args>
+  void init(Args &&... args) {
+    initer i;
+    i.go(std::forward<Args>(args)...);
+    m_ptr.set(i.p, i.heap);
+  }
+
+  T * ptr() const noexcept { return static_cast<T *>(m_ptr.get()); }
+
+public:
+  typedef T value_type;
+
+  ~offset_wrapper() noexcept {
+    if (T * t = this->ptr()) {
+      t->~T();
+      detail::offset_deallocate(m_ptr);
+    }
+  }
+
+  template <typename... Args>
+  offset_wrapper(Args &&... args) {
+    this->init(std::forward<Args>(args)...);
+  }
+
+  offset_wrapper(offset_wrapper & rhs)
+    : offset_wrapper(static_cast<const offset_wrapper &>(rhs)) {}
+
+  offset_wrapper(const offset_wrapper & rhs) { this->init(rhs.get()); }
+
+  offset_wrapper(offset_wrapper && rhs) noexcept {
+    if (detail::offset_take(rhs.ptr())) {
+      m_ptr.take(rhs.m_ptr);
+    } else {
+      this->init(std::move(rhs).get());
+    }
+  }
+
+  // Not assignable, like alloc_wrapper
+  offset_wrapper & operator=(const offset_wrapper &) = delete;
+  offset_wrapper & operator=(offset_wrapper &&) = delete;
+
+  T & get() & { return *this->ptr(); }
+  const T & get() const & { return *this->ptr(); }
+  T && get() && { return std::move(*this->ptr()); }
+};
+//]
+
+//[ strict_variant_offset_array
+/***
+ * A fixed-size array of a trivially copyable type, allocated like an
+ * `offset_wrapper`. `offset_array<char>` may hold a string.
+ */
+template <typename T>
+class offset_array {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "offset_array holds only trivially copyable types");
+
+  detail::offset_ptr m_ptr;
+  std::size_t m_size = 0;
+
+  void init(const T * data, std::size_t n) {
+    if (!n) { return; }
+    bool heap;
+    void * p = detail::offset_allocate(n * sizeof(T), alignof(T), heap);
+    std::memcpy(p, data, n * sizeof(T));
+    m_ptr.set(p, heap);
+    m_size = n;
+  }
+
+  // Take the allocation of `rhs`, or copy it into the current arena
+  void move_from(offset_array & rhs) noexcept {
+    if (detail::offset_take(rhs.data())) {
+      m_ptr.take(rhs.m_ptr);
+      m_size = rhs.m_size;
+      rhs.m_size = 0;
+    } else {
+      this->init(rhs.data(), rhs.size());
+    }
+  }
+
+public:
+  using value_type = T;
+  using const_iterator = const T *;
+
+  offset_array() noexcept = default;
+
+  offset_array(const T * data, std::size_t n) { this->init(data, n); }
+
+  offset_array(std::initializer_list<T> list) { this->init(list.begin(), list.size()); }
+
+  template <typename A>
+  offset_array(const std::vector<T, A> & vec) {
+    this->init(vec.data(), vec.size());
+  }
+
+  template <typename Traits, typename A>
+  offset_array(const std::basic_string<T, Traits, A> & str) {
+    this->init(str.data(), str.size());
+  }
+
+  offset_array(const offset_array & rhs) { this->init(rhs.data(), rhs.size()); }
+
+  offset_array(offset_array && rhs) noexcept { this->move_from(rhs); }
+
+  offset_array & operator=(const offset_array & rhs) {
+    offset_array tmp{rhs};
+    return *this = std::move(tmp);
+  }
+
+  offset_array & operator=(offset_array && rhs) noexcept {
+    if (this != &rhs) {
+      detail::offset_deallocate(m_ptr);
+      m_ptr.set(nullptr, false);
+      m_size = 0;
+      this->move_from(rhs);
+    }
+    return *this;
+  }
+
+  ~offset_array() noexcept { detail::offset_deallocate(m_ptr); }
+
+  const T * data() const noexcept { return static_cast<const T *>(m_ptr.get()); }
+  std::size_t size() const noexcept { return m_size; }
+  bool empty() const noexcept { return !m_size; }
+
+  const T * begin() const noexcept { return this->data(); }
+  const T * end() const noexcept { return this->data() + m_size; }
+
+  const T & operator[](std::size_t idx) const noexcept { return this->data()[idx]; }
+};
+//]
+
+//[ strict_variant_is_position_independent
+/***
+ * Trait for types which may be read through any mapping of the memory they
+ * are in. By default, trivially copyable types other than pointers, member
+ * pointers and arrays of them. Classes are assumed not to hold pointers.
+ * Offset wrappers and arrays are position independent if what they hold is.
+ * Specialize this for classes with members of those types.
+ */
+template <typename T>
+struct is_position_independent
+  : std::integral_constant<bool,
+                           std::is_trivially_copyable<T>::value
+                             && !std::is_pointer<typename std::remove_all_extents<T>::type>::value
+                             && !std::is_member_pointer<
+                                  typename std::remove_all_extents<T>::type>::value> {};
+
+template <typename T>
+struct is_position_independent<offset_wrapper<T>> : is_position_independent<T> {};
+
+template <typename T>
+struct is_position_independent<offset_array<T>> : is_position_independent<T> {};
+
+template <typename... Ts>
+struct is_position_independent<variant<Ts...>>
+  : std::integral_constant<bool, mpl::All_Have<is_position_independent, Ts...>::value> {};
+//]
+
+namespace detail {
+
+template <typename T>
+struct is_wrapper<offset_wrapper<T>> : std::true_type {};
+
+} // end namespace detail
+
+} // end namespace strict_variant
@@ -0,0 +1,131 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A stateless allocator which keeps freed nodes for reuse.
+ *
+ * `pool_allocator<T>` is meant for `alloc_wrapper` and `alloc_variant`, and
+ * node-based containers such as `std::map`, which allocate one `T` at a time.
+ * Each thread has a free list of nodes of each size, shared by the types of
+ * that size. Deallocated nodes go to the free list of the calling thread, and
+ * are released when that thread exits. So when a tree of variants is destroyed
+ * and another is built, for instance when decoding many messages, the nodes
+ * are reused without calling `operator new`.
+ *
+ * Nodes are reused in LIFO order, which suits building and dropping many
+ * small trees. A very large tree built from reused nodes may have poor
+ * locality. Allocations of more than one `T` go straight to `operator new`.
+ *
+ * Note: Objects with static storage duration should not use this allocator,
+ * since they may be destroyed after the free list of the main thread.
+ */
+
+#include <cstddef>
+#include <new>
+
+namespace strict_variant {
+
+namespace detail {
+
+// A list of free nodes of one size, which are linked through their storage
+template <std::size_t node_size>
+class node_free_list {
+  struct node {
+    node * next;
+  };
+
+  node * m_head = nullptr;
+
+public:
+  node_free_list() = default;
+  node_free_list(const node_free_list &) = delete;
+  node_free_list & operator=(const node_free_list &) = delete;
+
+  ~node_free_list() noexcept {
+    while (m_head) {
+      node * n = m_head;
+      m_head = n->next;
+      ::operator delete(n);
+    }
+  }
+
+  void * pop() {
+    if (node * n = m_head) {
+      m_head = n->next;
+      return n;
+    }
+    return ::operator new(node_size);
+  }
+
+  void push(void * p) noexcept {
+    node * n = static_cast<node *>(p);
+    n->next = m_head;
+    m_head = n;
+  }
+
+  static node_free_list & local() {
+    static thread_local node_free_list list;
+    return list;
+  }
+};
+
+// The node size for T. This is not computed in the body of `pool_allocator`,
+// so that `pool_allocator<T>` may be named while `T` is incomplete.
+template <typename T>
+struct pool_node_size {
+  static_assert(alignof(T) <= alignof(std::max_align_t),
+                "pool_allocator does not support over-aligned types");
+  static constexpr std::size_t value = sizeof(T) < sizeof(void *) ? sizeof(void *) : sizeof(T);
+};
+
+} // end namespace detail
+
+//[ strict_variant_pool_allocator
+template <typename T>
+struct pool_allocator {
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = pool_allocator<U>;
+  };
+
+  pool_allocator() noexcept = default;
+
+  template <typename U>
+  pool_allocator(const pool_allocator<U> &) noexcept {}
+
+  T * allocate(std::size_t n) {
+    using list_t = detail::node_free_list<detail::pool_node_size<T>::value>;
+    if (n == 1) { return static_cast<T *>(list_t::local().pop()); }
+    return static_cast<T *>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T * p, std::size_t n) noexcept {
+    using list_t = detail::node_free_list<detail::pool_node_size<T>::value>;
+    if (n == 1) {
+      list_t::local().push(p);
+    } else {
+      ::operator delete(p);
+    }
+  }
+};
+//]
+
+template <typename T, typename U>
+inline bool
+operator==(const pool_allocator<T> &, const pool_allocator<U> &) noexcept {
+  return true;
+}
+
+template <typename T, typename U>
+inline bool
+operator!=(const pool_allocator<T> &, const pool_allocator<U> &) noexcept {
+  return false;
+}
+
+} // end namespace strict_variant
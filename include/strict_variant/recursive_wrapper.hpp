@@ -13,6 +13,7 @@
 #include <strict_variant/wrapper.hpp>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 // #define STRICT_VARIANT_DEBUG
 
@@ -32,14 +33,94 @@
 
 #endif // STRICT_VARIANT_DEBUG
 
-//[ strict_variant_recursive_wrapper
 namespace strict_variant {
 
+//[ strict_variant_destroy_iteratively
+namespace detail {
+
+/***
+ * Trait to make `recursive_wrapper<T>` destroy its value without recursion.
+ * Specialize it for `T`, before the wrapper is destroyed, to opt in.
+ *
+ * Then a wrapper which is destroyed while another such wrapper on the same
+ * thread is being destroyed only puts its value on a worklist. The outermost
+ * wrapper deletes the values on the worklist one at a time, so destroying a
+ * long list or a deep tree uses constant stack space. The worklist is drained
+ * last in, first out, so each node on a path leaves its other children on it:
+ * it holds at most about depth * (fan-out - 1) values. So for a spine of
+ * nodes each with one leaf child, it may grow by one value per level.
+ */
+
+template <typename T>
+struct destroy_iteratively : std::false_type {};
+
+} // end namespace detail
+//]
+
+namespace detail {
+
+class deferred_deletes {
+  struct entry {
+    void * ptr;
+    void (*del)(void *) noexcept;
+  };
+
+  template <typename T>
+  static void delete_as(void * p) noexcept {
+    delete static_cast<T *>(p);
+  }
+
+  // The worklist of the outermost destroy on this thread, if any. It lives on
+  // that call's stack, so that nothing thread local needs to be destroyed, and
+  // wrappers with static storage duration may be destroyed at exit.
+  static std::vector<entry> *& pending() noexcept {
+    static thread_local std::vector<entry> * p = nullptr;
+    return p;
+  }
+
+public:
+  template <typename T>
+  static void destroy(T * p) noexcept {
+    std::vector<entry> *& current = pending();
+    if (current) {
+      try {
+        current->push_back(entry{p, &delete_as<T>});
+      } catch (...) { delete p; }
+      return;
+    }
+
+    std::vector<entry> worklist;
+    current = &worklist;
+    delete p;
+    while (!worklist.empty()) {
+      const entry e = worklist.back();
+      worklist.pop_back();
+      e.del(e.ptr);
+    }
+    current = nullptr;
+  }
+};
+
+template <typename T>
+inline void
+destroy_wrapped(T * p, std::false_type) noexcept {
+  delete p;
+}
+
+template <typename T>
+inline void
+destroy_wrapped(T * p, std::true_type) noexcept {
+  if (p) { deferred_deletes::destroy(p); }
+}
+
+} // end namespace detail
+
+//[ strict_variant_recursive_wrapper
 template <typename T>
 class recursive_wrapper {
   T * m_t;
 
-  void destroy() { delete m_t; }
+  void destroy() { detail::destroy_wrapped(m_t, detail::destroy_iteratively<T>{}); }
 
   template <typename... Args>
   void init(Args &&... args) {
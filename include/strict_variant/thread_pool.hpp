@@ -0,0 +1,309 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A small work-stealing thread pool, used by the parallel algorithms.
+ *
+ * `parallel_for(n, grain, f)` calls `f(begin, end)` for pieces of the index
+ * range `[0, n)`, of at most `grain` indices, on the workers and the calling
+ * thread, and returns when all of them are done. A thread which takes a piece
+ * larger than the grain splits it in halves, keeps the first half, and pushes
+ * the second onto its own deque. Threads pop their own deque from the back,
+ * which keeps the pieces they split recently, and idle threads steal from the
+ * front of the others, which takes the largest pieces. So the work balances
+ * even when the cost of indices varies wildly, without tuning the grain.
+ *
+ * Calls may be nested: a call from inside `f` uses the deque of the worker it
+ * runs on. If `f` throws, the rest of the pieces are skipped, and the first
+ * exception is rethrown by `parallel_for`.
+ *
+ * Each deque is guarded by its own mutex, which is only contended when a
+ * thread steals. Idle workers sleep on a condition variable.
+ */
+
+#include <strict_variant/concurrency.hpp>
+#include <strict_variant/mpl/std_traits.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace strict_variant {
+
+namespace detail {
+
+// A call of parallel_for. It lives on the stack of the caller, which waits
+// until `remaining` is zero.
+struct range_job {
+  std::atomic<std::size_t> remaining;
+  std::size_t grain;
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+
+  range_job(std::size_t n, std::size_t g) noexcept
+    : remaining(n)
+    , grain(g) {}
+
+  virtual void run(std::size_t begin, std::size_t end) = 0;
+
+protected:
+  ~range_job() = default;
+};
+
+template <typename F>
+struct range_job_impl final : range_job {
+  F & f;
+
+  range_job_impl(std::size_t n, std::size_t g, F & func) noexcept
+    : range_job(n, g)
+    , f(func) {}
+
+  void run(std::size_t begin, std::size_t end) override { f(begin, end); }
+};
+
+struct range_task {
+  range_job * job;
+  std::size_t begin;
+  std::size_t end;
+};
+
+} // end namespace detail
+
+//[ strict_variant_thread_pool
+class thread_pool {
+  struct task_queue {
+    char pad[detail::cache_line_size];
+    std::mutex mutex;
+    std::deque<detail::range_task> tasks;
+    // The size of `tasks`, which may be read without the mutex
+    std::atomic<std::size_t> count{0};
+    char pad_end[detail::cache_line_size];
+  };
+
+  // One for each worker, and the last for threads which are not workers
+  std::vector<std::unique_ptr<task_queue>> m_queues;
+  std::vector<std::thread> m_threads;
+
+  std::mutex m_sleep_mutex;
+  std::condition_variable m_wake;
+  std::atomic<unsigned> m_sleeping{0};
+  std::uint64_t m_signal = 0;
+  bool m_stop = false;
+
+  struct worker_id {
+    const thread_pool * pool;
+    unsigned index;
+  };
+
+  static worker_id & current() noexcept {
+    static thread_local worker_id id{nullptr, 0};
+    return id;
+  }
+
+  unsigned queue_index() const noexcept {
+    const worker_id & id = current();
+    return id.pool == this ? id.index : static_cast<unsigned>(m_threads.size());
+  }
+
+  void push(unsigned q, const detail::range_task & t) {
+    {
+      task_queue & queue = *m_queues[q];
+      std::lock_guard<std::mutex> lock{queue.mutex};
+      queue.tasks.push_back(t);
+      queue.count.store(queue.tasks.size(), std::memory_order_relaxed);
+    }
+    // Either a worker which is going to sleep sees the task, or this sees it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed)) {
+      {
+        std::lock_guard<std::mutex> lock{m_sleep_mutex};
+        ++m_signal;
+      }
+      m_wake.notify_one();
+    }
+  }
+
+  bool pop(unsigned q, detail::range_task & t) {
+    task_queue & queue = *m_queues[q];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if (queue.tasks.empty()) { return false; }
+    t = queue.tasks.back();
+    queue.tasks.pop_back();
+    queue.count.store(queue.tasks.size(), std::memory_order_relaxed);
+    return true;
+  }
+
+  bool steal(unsigned q, detail::range_task & t) {
+    const std::size_t n = m_queues.size();
+    for (std::size_t i = 1; i < n; ++i) {
+      task_queue & queue = *m_queues[(q + i) % n];
+      std::lock_guard<std::mutex> lock{queue.mutex};
+      if (!queue.tasks.empty()) {
+        t = queue.tasks.front();
+        queue.tasks.pop_front();
+        queue.count.store(queue.tasks.size(), std::memory_order_relaxed);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool find_task(unsigned q, detail::range_task & t) {
+    return this->pop(q, t) || this->steal(q, t);
+  }
+
+  bool has_tasks() {
+    for (const auto & queue : m_queues) {
+      std::lock_guard<std::mutex> lock{queue->mutex};
+      if (!queue->tasks.empty()) { return true; }
+    }
+    return false;
+  }
+
+  void execute(unsigned q, detail::range_task t) {
+    detail::range_job & job = *t.job;
+    // Split off the second half, until the piece is small enough. If a push
+    // fails, this thread does the rest.
+    while (t.end - t.begin > job.grain) {
+      const std::size_t mid = t.begin + (t.end - t.begin) / 2;
+      try {
+        this->push(q, detail::range_task{&job, mid, t.end});
+      } catch (...) { break; }
+      t.end = mid;
+    }
+
+    if (!job.failed.load(std::memory_order_relaxed)) {
+      try {
+        job.run(t.begin, t.end);
+      } catch (...) {
+        if (!job.failed.exchange(true)) { job.error = std::current_exception(); }
+      }
+    }
+    // The job may be destroyed after this
+    job.remaining.fetch_sub(t.end - t.begin, std::memory_order_acq_rel);
+  }
+
+  void worker_loop(unsigned index) {
+    current() = worker_id{this, index};
+    unsigned spins = 0;
+    for (;;) {
+      detail::range_task t;
+      if (this->find_task(index, t)) {
+        this->execute(index, t);
+        spins = 0;
+        continue;
+      }
+      if (++spins < 64) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock{m_sleep_mutex};
+      if (m_stop) { return; }
+      const std::uint64_t signal = m_signal;
+      m_sleeping.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!this->has_tasks()) {
+        m_wake.wait(lock, [this, signal]() { return m_stop || m_signal != signal; });
+      }
+      m_sleeping.fetch_sub(1);
+      spins = 0;
+    }
+  }
+
+public:
+  /***
+   * A pool for `num_threads` threads, counting the thread which calls
+   * `parallel_for`, so it starts `num_threads - 1` workers.
+   */
+  explicit thread_pool(unsigned num_threads = std::thread::hardware_concurrency()) {
+    const unsigned num_workers = num_threads > 1 ? num_threads - 1 : 0;
+    for (unsigned i = 0; i <= num_workers; ++i) {
+      m_queues.emplace_back(new task_queue);
+    }
+    m_threads.reserve(num_workers);
+    for (unsigned i = 0; i < num_workers; ++i) {
+      m_threads.emplace_back([this, i]() { this->worker_loop(i); });
+    }
+  }
+
+  thread_pool(const thread_pool &) = delete;
+  thread_pool & operator=(const thread_pool &) = delete;
+
+  // No call of `parallel_for` may be running
+  ~thread_pool() noexcept {
+    {
+      std::lock_guard<std::mutex> lock{m_sleep_mutex};
+      m_stop = true;
+      ++m_signal;
+    }
+    m_wake.notify_all();
+    for (std::thread & t : m_threads) {
+      t.join();
+    }
+  }
+
+  // The number of threads which run tasks, counting a caller
+  unsigned concurrency() const noexcept { return static_cast<unsigned>(m_threads.size()) + 1; }
+
+  // A pool for all of the cores, made when first used
+  static thread_pool & default_pool() {
+    static thread_pool pool;
+    return pool;
+  }
+
+  /***
+   * Whether it is worth splitting work on the calling thread: there are
+   * other threads, and they have stolen every piece this thread pushed.
+   * Recursive algorithms use this to split lazily, so that they only make
+   * tasks when some thread may be idle.
+   */
+  bool should_split() const noexcept {
+    return !m_threads.empty()
+           && !m_queues[this->queue_index()]->count.load(std::memory_order_relaxed);
+  }
+
+  /***
+   * Call `f(begin, end)` for pieces of `[0, n)` of at most `grain` indices,
+   * in parallel, and wait for all of them.
+   */
+  template <typename F>
+  void parallel_for(std::size_t n, std::size_t grain, F && f) {
+    if (!grain) { grain = 1; }
+    if (n <= grain || m_threads.empty()) {
+      if (n) { f(std::size_t{0}, n); }
+      return;
+    }
+
+    detail::range_job_impl<mpl::remove_reference_t<F>> job{n, grain, f};
+    const unsigned q = this->queue_index();
+    this->execute(q, detail::range_task{&job, 0, n});
+
+    // Help with any task while waiting, so that nested calls make progress
+    unsigned spins = 0;
+    while (job.remaining.load(std::memory_order_acquire)) {
+      detail::range_task t;
+      if (this->find_task(q, t)) {
+        this->execute(q, t);
+        spins = 0;
+      } else {
+        detail::spin_wait(spins);
+      }
+    }
+    if (job.error) { std::rethrow_exception(job.error); }
+  }
+};
+//]
+
+} // end namespace strict_variant
@@ -20,6 +20,7 @@
  *   https://github.com/jarro2783/thenewcpp
  */
 
+#include <strict_variant/bitwise_comparable.hpp>
 #include <strict_variant/filter_overloads.hpp>
 #include <strict_variant/mpl/find_with.hpp>
 #include <strict_variant/mpl/nonstd_traits.hpp>
@@ -33,11 +34,13 @@
 #include <strict_variant/variant_fwd.hpp>
 #include <strict_variant/variant_storage.hpp>
 
+#include <cstring>
 #include <type_traits>
 #include <utility>
 
 // #define STRICT_VARIANT_ASSUME_MOVE_NOTHROW
 // #define STRICT_VARIANT_ASSUME_COPY_NOTHROW
+// #define STRICT_VARIANT_OPTIMIZER_HINTS
 // #define STRICT_VARIANT_DEBUG
 
 #ifdef STRICT_VARIANT_DEBUG
@@ -56,6 +59,35 @@
 
 #endif // STRICT_VARIANT_DEBUG
 
+// Like STRICT_VARIANT_ASSERT, but in release mode with
+// STRICT_VARIANT_OPTIMIZER_HINTS, the condition is passed to the optimizer.
+#if defined(STRICT_VARIANT_DEBUG)
+
+#define STRICT_VARIANT_ASSUME(X, C) STRICT_VARIANT_ASSERT(X, C)
+
+#elif defined(STRICT_VARIANT_OPTIMIZER_HINTS) && defined(__clang__)
+
+#define STRICT_VARIANT_ASSUME(X, C) __builtin_assume((X))
+
+#elif defined(STRICT_VARIANT_OPTIMIZER_HINTS) && defined(__GNUC__)
+
+#define STRICT_VARIANT_ASSUME(X, C)                                                                \
+  do {                                                                                             \
+    if (!(X)) { __builtin_unreachable(); }                                                         \
+  } while (0)
+
+#elif defined(STRICT_VARIANT_OPTIMIZER_HINTS) && defined(_MSC_VER)
+
+#define STRICT_VARIANT_ASSUME(X, C) __assume((X))
+
+#else
+
+#define STRICT_VARIANT_ASSUME(X, C)                                                                \
+  do {                                                                                             \
+  } while (0)
+
+#endif
+
 namespace strict_variant {
 
 /***
@@ -115,7 +147,7 @@ private:
 
   template <std::size_t index, typename... Args>
   void initialize(Args &&... args) noexcept(
-    noexcept(static_cast<storage_t *>(nullptr)->template initialize<index>(
+    noexcept(std::declval<storage_t &>().template initialize<index>(
       std::forward<Args>(std::declval<Args>())...))) {
     m_storage.template initialize<index>(std::forward<Args>(args)...);
     this->m_which = static_cast<int>(index);
@@ -339,7 +371,7 @@ public:
   // Emplace with explicitly specified type -- makes a call to index version
   template <typename T, typename... Args>
   void emplace(Args &&... args) noexcept(noexcept(
-    static_cast<variant *>(nullptr)->emplace<find_which<T>::value>(std::forward<Args>(args)...))) {
+    std::declval<variant &>().template emplace<find_which<T>::value>(std::forward<Args>(args)...))) {
     constexpr std::size_t idx = find_which<T>::value;
     static_assert(idx < sizeof...(Types) + 1,
                   "Requested type is not a member of this variant type");
@@ -355,7 +387,11 @@ public:
    * Accessors
    */
 
-  int which() const noexcept { return m_which; }
+  int which() const noexcept {
+    STRICT_VARIANT_ASSUME(static_cast<unsigned>(m_which) < sizeof...(Types) + 1,
+                          "Invalid which value!");
+    return m_which;
+  }
 
   // get
   template <typename T>
@@ -397,6 +433,57 @@ public:
     }
   }
 
+  // get_unchecked: no test of `which`, the caller must already know that
+  // the variant contains the requested type.
+  template <typename T>
+  T & get_unchecked() & noexcept {
+    constexpr std::size_t idx = find_which<T>::value;
+    static_assert(idx < sizeof...(Types) + 1,
+                  "Requested type is not a member of this variant type");
+
+    return this->get_unchecked<idx>();
+  }
+
+  template <typename T>
+  const T & get_unchecked() const & noexcept {
+    constexpr std::size_t idx = find_which<T>::value;
+    static_assert(idx < sizeof...(Types) + 1,
+                  "Requested type is not a member of this variant type");
+
+    return this->get_unchecked<idx>();
+  }
+
+  template <typename T>
+  T && get_unchecked() && noexcept {
+    constexpr std::size_t idx = find_which<T>::value;
+    static_assert(idx < sizeof...(Types) + 1,
+                  "Requested type is not a member of this variant type");
+
+    return std::move(*this).template get_unchecked<idx>();
+  }
+
+  // get_unchecked with integer index
+  template <std::size_t idx>
+  auto get_unchecked() & noexcept
+    -> decltype(std::declval<storage_t &>().template get_value<idx>(detail::false_{})) {
+    STRICT_VARIANT_ASSUME(static_cast<int>(idx) == m_which, "Bad unchecked access!");
+    return m_storage.template get_value<idx>(detail::false_{});
+  }
+
+  template <std::size_t idx>
+  auto get_unchecked() const & noexcept
+    -> decltype(std::declval<const storage_t &>().template get_value<idx>(detail::false_{})) {
+    STRICT_VARIANT_ASSUME(static_cast<int>(idx) == m_which, "Bad unchecked access!");
+    return m_storage.template get_value<idx>(detail::false_{});
+  }
+
+  template <std::size_t idx>
+  auto get_unchecked() && noexcept
+    -> decltype(std::declval<storage_t &&>().template get_value<idx>(detail::false_{})) {
+    STRICT_VARIANT_ASSUME(static_cast<int>(idx) == m_which, "Bad unchecked access!");
+    return std::move(m_storage).template get_value<idx>(detail::false_{});
+  }
+
   /***
    * Visitation
    */
@@ -421,6 +508,44 @@ public:
 
 #undef APPLY_VISITOR_IMPL_BODY
 
+  // Visits two variants which are known to have the same `which` value, using
+  // a single dispatch. The visitor is passed a `detail::value_pair`.
+  // Used to implement comparisons.
+  using paired_storage_t = detail::storage_pair<const storage_t>;
+
+  template <typename Visitor>
+  static auto apply_paired_visitor_impl(Visitor && visitor, const variant & lhs,
+                                        const variant & rhs)
+    -> decltype(dispatcher_t{}(0u, std::declval<paired_storage_t>(), std::forward<Visitor>(visitor))) {
+    STRICT_VARIANT_ASSERT(lhs.which() == rhs.which(), "Paired visit of mismatched variants!");
+    return dispatcher_t{}(static_cast<unsigned>(lhs.which()),
+                          paired_storage_t{lhs.m_storage, rhs.m_storage},
+                          std::forward<Visitor>(visitor));
+  }
+
+  // Compares two variants using `memcmp` of the storage.
+  // Used to implement `operator ==` when each value type is bitwise comparable
+  // and has the same size, so that every byte of the storage is in use.
+  static constexpr bool bitwise_equality =
+    storage_t::uniform_size && mpl::All_Have<is_bitwise_comparable, First, Types...>::value;
+
+  static bool bitwise_equal_impl(const variant & lhs, const variant & rhs) noexcept {
+    static_assert(bitwise_equality, "Misuse of bitwise_equal_impl!");
+    return lhs.m_which == rhs.m_which
+           && std::memcmp(lhs.m_storage.address(), rhs.m_storage.address(), storage_t::m_size) == 0;
+  }
+
+  // The storage as bytes, when each value type is trivially copyable, so that
+  // a variant may be copied without a dispatch. Used by `log_ring`.
+  static constexpr bool trivially_copyable_storage =
+    mpl::All_Have<std::is_trivially_copyable, First, Types...>::value;
+  static constexpr std::size_t storage_size = storage_t::m_size;
+
+  static const void * storage_address_impl(const variant & v) noexcept {
+    static_assert(trivially_copyable_storage, "Misuse of storage_address_impl!");
+    return v.m_storage.address();
+  }
+
   // public:
   // C++17 visit syntax
   template <typename V>
@@ -446,6 +571,17 @@ public:
   }
 };
 
+/***
+ * A variant is itself bitwise comparable if `operator ==` uses `memcmp`, and
+ * it has no padding, so that arrays of variants may be compared using `memcmp`.
+ */
+template <typename First, typename... Types>
+struct is_bitwise_comparable<variant<First, Types...>>
+  : std::integral_constant<bool,
+                           variant<First, Types...>::bitwise_equality
+                             && sizeof(variant<First, Types...>)
+                                  == sizeof(detail::storage<First, Types...>) + sizeof(int)> {};
+
 /***
  * apply one visitor function. `boost::variant` syntax.
  * This is the basic version, used in implementation of multivisitation.
@@ -492,6 +628,50 @@ get(const variant<Types...> * var) noexcept
   return var->template get<idx>();
 }
 
+/***
+ * strict_variant::get_unchecked function. Returns a reference, and does not
+ * check `which()`, so using the wrong type is undefined behavior.
+ */
+template <typename T, typename... Types>
+T &
+get_unchecked(variant<Types...> & var) noexcept {
+  return var.template get_unchecked<T>();
+}
+
+template <typename T, typename... Types>
+const T &
+get_unchecked(const variant<Types...> & var) noexcept {
+  return var.template get_unchecked<T>();
+}
+
+template <typename T, typename... Types>
+T &&
+get_unchecked(variant<Types...> && var) noexcept {
+  return std::move(var).template get_unchecked<T>();
+}
+
+// Using integer index
+template <std::size_t idx, typename... Types>
+auto
+get_unchecked(variant<Types...> & var) noexcept
+  -> decltype(std::declval<variant<Types...> &>().template get_unchecked<idx>()) {
+  return var.template get_unchecked<idx>();
+}
+
+template <std::size_t idx, typename... Types>
+auto
+get_unchecked(const variant<Types...> & var) noexcept
+  -> decltype(std::declval<const variant<Types...> &>().template get_unchecked<idx>()) {
+  return var.template get_unchecked<idx>();
+}
+
+template <std::size_t idx, typename... Types>
+auto
+get_unchecked(variant<Types...> && var) noexcept
+  -> decltype(std::declval<variant<Types...> &&>().template get_unchecked<idx>()) {
+  return std::move(var).template get_unchecked<idx>();
+}
+
 /// If a variant has type T, then get a reference to it,
 /// otherwise, create a new T default value in the variant
 /// and return a reference to the new value.
@@ -586,7 +766,7 @@ struct variant<First, Types...>::destroyer {
  */
 
 #define STRICT_VARIANT_ASSERT_WHICH_INVARIANT                                                      \
-  STRICT_VARIANT_ASSERT(static_cast<unsigned>(this->which()) < sizeof...(Types) + 1,               \
+  STRICT_VARIANT_ASSUME(static_cast<unsigned>(this->m_which) < sizeof...(Types) + 1,               \
                         "Postcondition failed!")
 
 template <typename First, typename... Types>
@@ -763,6 +943,7 @@ variant<First, Types...>::emplace(Args &&... args) noexcept
 template <typename First, typename... Types>
 struct variant<First, Types...>::swapper {
   using var_t = variant<First, Types...>;
+  using result_type = void;
 
   swapper(var_t & lhs_var, var_t & rhs_var)
     : lhs_(lhs_var)
@@ -774,12 +955,14 @@ struct variant<First, Types...>::swapper {
   // Second visit is to rhs_var
   template <typename T>
   void operator()(T & first_visit) const noexcept {
-    second_visitor<T> v{lhs_, rhs_, first_visit};
+    const second_visitor<T> v{lhs_, rhs_, first_visit};
     rhs_.apply_visitor_internal(v);
   }
 
   template <typename T>
   struct second_visitor {
+    using result_type = void;
+
     var_t & first_var_;
     var_t & second_var_;
     T & first_visit_;
@@ -789,27 +972,37 @@ struct variant<First, Types...>::swapper {
       , second_var_(second_var)
       , first_visit_(first_visit) {}
 
+    template <typename U>
+    void operator()(U & second_visit) const noexcept {
+      using same_swappable_t =
+        std::integral_constant<bool, std::is_same<T, U>::value
+                                       && mpl::is_nothrow_swappable<T>::value>;
+      this->do_swap(second_visit, same_swappable_t{});
+    }
+
+  private:
     // If both give us a T, and T is noexcept swappable, then do that
-    mpl::enable_if_t<mpl::is_nothrow_swappable<T>::value> operator()(T & second_visit) const
-      noexcept {
+    void do_swap(T & second_visit, std::true_type) const noexcept {
       using std::swap;
       swap(first_visit_, second_visit);
     }
 
     // swap using a move
     template <typename U>
-    void operator()(U & second_visit) const noexcept {
+    void do_swap(U & second_visit, std::false_type) const noexcept {
       constexpr std::size_t t_idx = var_t::find_which<T>::value;
       constexpr std::size_t u_idx = var_t::find_which<U>::value;
 
-      STRICT_VARIANT_ASSERT(t_idx == first_var_.which(), "Bad access during swap!");
-      STRICT_VARIANT_ASSERT(u_idx == second_var_.which(), "Bad access during swap!");
+      STRICT_VARIANT_ASSERT(static_cast<int>(t_idx) == first_var_.which(),
+                            "Bad access during swap!");
+      STRICT_VARIANT_ASSERT(static_cast<int>(u_idx) == second_var_.which(),
+                            "Bad access during swap!");
 
       T temp{std::move(first_visit_)};
       first_var_.destroy();
-      first_var_.initialize<u_idx>(std::move(second_visit));
+      first_var_.template initialize<u_idx>(std::move(second_visit));
       second_var_.destroy();
-      second_var_.initialize<t_idx>(std::move(temp));
+      second_var_.template initialize<t_idx>(std::move(temp));
     }
   };
 
@@ -827,47 +1020,41 @@ variant<First, Types...>::swap(variant & other) noexcept {
 
 // Operator ==, !=
 
+namespace detail {
+
 // equality check
-// This is essentially a multivisitor, but we do the boiler-plate manually to
-// avoid including extra stuff.
-template <typename First, typename... Types>
+// Applied to both values at once, using the paired dispatch above.
 struct eq_checker {
   typedef bool result_type;
 
-  using var_t = variant<First, Types...>;
-
-  eq_checker(const var_t & lhs_variant)
-    : lhs_v(lhs_variant) {}
-
-  // After we've visited the first value, store it in a function object.
-  // second_visitor<T> is applied to the variant we are passed in ctor.
   template <typename T>
-  struct second_visitor {
-    const T & r;
+  bool operator()(const value_pair<T> & p) const {
+    return p.first == p.second;
+  }
+};
 
-    bool operator()(const T & l) const { return l == r; }
-    template <typename U>
-    bool operator()(const U &) const {
-      STRICT_VARIANT_ASSERT(false, "Should be unreachable!");
-      return false;
-    }
-  };
+template <typename First, typename... Types>
+inline bool
+variant_equal(const variant<First, Types...> & lhs, const variant<First, Types...> & rhs,
+              std::false_type) {
+  if (lhs.which() != rhs.which()) { return false; }
+  return variant<First, Types...>::apply_paired_visitor_impl(eq_checker{}, lhs, rhs);
+}
 
-  template <typename Rhs>
-  bool operator()(const Rhs & rhs) const {
-    return apply_visitor(second_visitor<Rhs>{rhs}, lhs_v);
-  }
+template <typename First, typename... Types>
+inline bool
+variant_equal(const variant<First, Types...> & lhs, const variant<First, Types...> & rhs,
+              std::true_type) noexcept {
+  return variant<First, Types...>::bitwise_equal_impl(lhs, rhs);
+}
 
-private:
-  const var_t & lhs_v;
-};
+} // end namespace detail
 
 template <typename First, typename... Types>
 inline bool
 operator==(const variant<First, Types...> & lhs, const variant<First, Types...> & rhs) {
-  if (lhs.which() != rhs.which()) { return false; }
-  eq_checker<First, Types...> eq{lhs};
-  return apply_visitor(eq, rhs);
+  return detail::variant_equal(
+    lhs, rhs, std::integral_constant<bool, variant<First, Types...>::bitwise_equality>{});
 }
 
 template <typename First, typename... Types>
@@ -879,4 +1066,5 @@ operator!=(const variant<First, Types...> & lhs, const variant<First, Types...>
 } // end namespace strict_variant
 
 #undef STRICT_VARIANT_ASSERT
+#undef STRICT_VARIANT_ASSUME
 #undef STRICT_VARIANT_ASSERT_WHICH_INVARIANT
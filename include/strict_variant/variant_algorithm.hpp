@@ -0,0 +1,289 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Algorithms specialized for ranges of variants.
+ *
+ * Note: `sort_by_which` may use threads, so programs using it may need to link with
+ * `-pthread`.
+ */
+
+#include <strict_variant/bitwise_comparable.hpp>
+#include <strict_variant/mpl/std_traits.hpp>
+#include <strict_variant/mpl/ulist.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace strict_variant {
+
+namespace detail {
+
+// Whole range is compared using memcmp, which is vectorized by the C library
+template <typename T>
+inline bool
+ranges_equal_impl(const T * first1, const T * last1, const T * first2, std::true_type) noexcept {
+  if (first1 == last1) { return true; }
+  return std::memcmp(first1, first2, static_cast<std::size_t>(last1 - first1) * sizeof(T)) == 0;
+}
+
+// Element-wise, using operator ==. For variants whose value types are
+// bitwise comparable, this is still a `memcmp` of each storage.
+template <typename It1, typename It2>
+inline bool
+ranges_equal_impl(It1 first1, It1 last1, It2 first2, std::false_type) {
+  return std::equal(first1, last1, first2);
+}
+
+} // end namespace detail
+
+//[ strict_variant_ranges_equal
+/// Same as `std::equal(first1, last1, first2)`.
+/// When the iterators are pointers, and the value type is bitwise comparable,
+/// such as a variant over integers of the same size and without padding,
+/// compares the whole block of memory at once.
+template <typename It1, typename It2>
+inline bool
+ranges_equal(It1 first1, It1 last1, It2 first2) {
+  using value1_t = typename std::iterator_traits<It1>::value_type;
+  using value2_t = typename std::iterator_traits<It2>::value_type;
+
+  constexpr bool use_memcmp = std::is_pointer<It1>::value && std::is_pointer<It2>::value
+                              && std::is_same<value1_t, value2_t>::value
+                              && is_bitwise_comparable<value1_t>::value;
+
+  return detail::ranges_equal_impl(first1, last1, first2,
+                                   std::integral_constant<bool, use_memcmp>{});
+}
+//]
+
+namespace detail {
+
+/***
+ * Random access iterator over a range of variants which all contain value
+ * type `idx`. Dereferences to the contained value, using `get_unchecked`.
+ *
+ * Sorting through this iterator moves and compares the contained values
+ * directly, without a dispatch on `which` for each operation.
+ */
+template <typename RandomIt, std::size_t idx>
+class unchecked_iterator {
+  RandomIt it_;
+
+public:
+  using variant_t = typename std::iterator_traits<RandomIt>::value_type;
+  using reference = decltype(get_unchecked<idx>(*std::declval<RandomIt>()));
+  using value_type = mpl::remove_const_t<mpl::remove_reference_t<reference>>;
+  using pointer = mpl::remove_reference_t<reference> *;
+  using difference_type = typename std::iterator_traits<RandomIt>::difference_type;
+  using iterator_category = std::random_access_iterator_tag;
+
+  unchecked_iterator() = default;
+  explicit unchecked_iterator(RandomIt it)
+    : it_(it) {}
+
+  reference operator*() const { return get_unchecked<idx>(*it_); }
+  pointer operator->() const { return &**this; }
+  reference operator[](difference_type n) const { return *(*this + n); }
+
+  unchecked_iterator & operator++() {
+    ++it_;
+    return *this;
+  }
+  unchecked_iterator & operator--() {
+    --it_;
+    return *this;
+  }
+  unchecked_iterator operator++(int) { return unchecked_iterator(it_++); }
+  unchecked_iterator operator--(int) { return unchecked_iterator(it_--); }
+
+  unchecked_iterator & operator+=(difference_type n) {
+    it_ += n;
+    return *this;
+  }
+  unchecked_iterator & operator-=(difference_type n) {
+    it_ -= n;
+    return *this;
+  }
+
+  friend unchecked_iterator operator+(unchecked_iterator i, difference_type n) { return i += n; }
+  friend unchecked_iterator operator+(difference_type n, unchecked_iterator i) { return i += n; }
+  friend unchecked_iterator operator-(unchecked_iterator i, difference_type n) { return i -= n; }
+  friend difference_type operator-(const unchecked_iterator & a, const unchecked_iterator & b) {
+    return a.it_ - b.it_;
+  }
+
+  friend bool operator==(const unchecked_iterator & a, const unchecked_iterator & b) {
+    return a.it_ == b.it_;
+  }
+  friend bool operator!=(const unchecked_iterator & a, const unchecked_iterator & b) {
+    return a.it_ != b.it_;
+  }
+  friend bool operator<(const unchecked_iterator & a, const unchecked_iterator & b) {
+    return a.it_ < b.it_;
+  }
+  friend bool operator>(const unchecked_iterator & a, const unchecked_iterator & b) {
+    return a.it_ > b.it_;
+  }
+  friend bool operator<=(const unchecked_iterator & a, const unchecked_iterator & b) {
+    return a.it_ <= b.it_;
+  }
+  friend bool operator>=(const unchecked_iterator & a, const unchecked_iterator & b) {
+    return a.it_ >= b.it_;
+  }
+};
+
+template <typename V>
+struct num_value_types;
+
+template <typename... Ts>
+struct num_value_types<variant<Ts...>> {
+  static constexpr std::size_t value = sizeof...(Ts);
+};
+
+// Sort a bucket of variants which all contain value type `idx`
+template <template <typename> class ComparatorTemplate, typename RandomIt, unsigned idx>
+void
+sort_bucket(RandomIt first, RandomIt last) {
+  using iterator_t = unchecked_iterator<RandomIt, idx>;
+  std::sort(iterator_t{first}, iterator_t{last},
+            ComparatorTemplate<typename iterator_t::value_type>{});
+}
+
+template <template <typename> class ComparatorTemplate, typename RandomIt, typename UL>
+struct sort_bucket_table;
+
+template <template <typename> class ComparatorTemplate, typename RandomIt, unsigned... us>
+struct sort_bucket_table<ComparatorTemplate, RandomIt, mpl::ulist<us...>> {
+  using function_t = void (*)(RandomIt, RandomIt);
+
+  static function_t get(std::size_t idx) {
+    static constexpr function_t table[] = {&sort_bucket<ComparatorTemplate, RandomIt, us>...};
+    return table[idx];
+  }
+};
+
+// Ranges smaller than this are not split across threads
+static constexpr std::size_t parallel_sort_threshold = 1u << 15;
+
+} // end namespace detail
+
+//[ strict_variant_sort_by_which
+/***
+ * Sort a range of variants, in the same order as
+ * `variant_comparator<V, ComparatorTemplate>`.
+ *
+ * First partitions the range by `which`, using a counting pass and an
+ * in-place permutation (American flag sort). Then each bucket is sorted with
+ * `ComparatorTemplate<T>` for its value type `T`, through `get_unchecked`, so
+ * that comparisons and moves don't dispatch on `which`.
+ *
+ * If the range is large, the buckets are sorted in parallel, largest first,
+ * by up to `num_threads` threads (including the calling thread). By default,
+ * `std::thread::hardware_concurrency()` is used. An exception thrown when
+ * sorting a bucket is rethrown, after all of the threads finish.
+ *
+ * Not stable.
+ */
+template <template <typename> class ComparatorTemplate = std::less, typename RandomIt>
+void
+sort_by_which(RandomIt first, RandomIt last,
+              unsigned num_threads = std::thread::hardware_concurrency()) {
+  using variant_t = typename std::iterator_traits<RandomIt>::value_type;
+  using difference_t = typename std::iterator_traits<RandomIt>::difference_type;
+  static_assert(is_variant<variant_t>::value, "sort_by_which requires a range of variants");
+
+  constexpr std::size_t num_types = detail::num_value_types<variant_t>::value;
+  using table_t =
+    detail::sort_bucket_table<ComparatorTemplate, RandomIt, mpl::count_t<num_types>>;
+
+  // Counting pass
+  std::size_t counts[num_types] = {};
+  for (RandomIt it = first; it != last; ++it) {
+    ++counts[(*it).which()];
+  }
+
+  difference_t begins[num_types + 1];
+  begins[0] = 0;
+  for (std::size_t k = 0; k < num_types; ++k) {
+    begins[k + 1] = begins[k] + static_cast<difference_t>(counts[k]);
+  }
+
+  // Permute each element into its bucket
+  difference_t next[num_types];
+  std::copy(begins, begins + num_types, next);
+  for (std::size_t k = 0; k < num_types; ++k) {
+    while (next[k] < begins[k + 1]) {
+      const std::size_t w = static_cast<std::size_t>(first[next[k]].which());
+      if (w == k) {
+        ++next[k];
+      } else {
+        first[next[k]].swap(first[next[w]++]);
+      }
+    }
+  }
+
+  // Buckets in decreasing order of size, skipping those with nothing to sort
+  std::vector<std::size_t> order;
+  for (std::size_t k = 0; k < num_types; ++k) {
+    if (counts[k] > 1) { order.push_back(k); }
+  }
+  std::sort(order.begin(), order.end(),
+            [&counts](std::size_t a, std::size_t b) { return counts[a] > counts[b]; });
+
+  auto sort_bucket = [&](std::size_t k) {
+    table_t::get(k)(first + begins[k], first + begins[k + 1]);
+  };
+
+  const std::size_t total = static_cast<std::size_t>(begins[num_types]);
+  if (num_threads <= 1 || order.size() <= 1 || total < detail::parallel_sort_threshold) {
+    for (std::size_t k : order) {
+      sort_bucket(k);
+    }
+    return;
+  }
+
+  // Each worker takes the next largest bucket
+  std::atomic<std::size_t> next_bucket{0};
+  auto worker = [&]() {
+    for (std::size_t i; (i = next_bucket++) < order.size();) {
+      sort_bucket(order[i]);
+    }
+  };
+
+  const std::size_t num_helpers = std::min<std::size_t>(num_threads, order.size()) - 1;
+  std::vector<std::future<void>> helpers;
+  for (std::size_t i = 0; i < num_helpers; ++i) {
+    helpers.push_back(std::async(std::launch::async, worker));
+  }
+
+  std::exception_ptr error;
+  try {
+    worker();
+  } catch (...) { error = std::current_exception(); }
+
+  for (auto & h : helpers) {
+    try {
+      h.get();
+    } catch (...) {
+      if (!error) { error = std::current_exception(); }
+    }
+  }
+  if (error) { std::rethrow_exception(error); }
+}
+//]
+
+} // end namespace strict_variant
@@ -0,0 +1,221 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * CBOR (RFC 7049) encoding and decoding of variants, using `codec_traits`.
+ *
+ * Integers, string lengths and container sizes are written in the smallest
+ * form. `float` is written in single precision, and `double` in double
+ * precision. When reading, half precision floats are also accepted.
+ *
+ * Byte strings, tags, indefinite-length items, and simple values other than
+ * `false`, `true` and `null` are not supported.
+ */
+
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_codec.hpp>
+#include <strict_variant/variant_serialize.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace strict_variant {
+
+//[ strict_variant_cbor_writer
+template <typename Sink>
+class cbor_writer {
+  Sink & m_sink;
+
+  void put(unsigned char c) { m_sink.push_back(static_cast<typename Sink::value_type>(c)); }
+
+  // The initial byte of an item, and its argument
+  void head(unsigned major, std::uint64_t x) {
+    const unsigned char mt = static_cast<unsigned char>(major << 5);
+    if (x < 24u) {
+      this->put(static_cast<unsigned char>(mt | x));
+    } else if (x <= 0xffu) {
+      this->put(mt | 24u);
+      detail::put_uint_be(x, 1, m_sink);
+    } else if (x <= 0xffffu) {
+      this->put(mt | 25u);
+      detail::put_uint_be(x, 2, m_sink);
+    } else if (x <= 0xffffffffu) {
+      this->put(mt | 26u);
+      detail::put_uint_be(x, 4, m_sink);
+    } else {
+      this->put(mt | 27u);
+      detail::put_uint_be(x, 8, m_sink);
+    }
+  }
+
+public:
+  explicit cbor_writer(Sink & sink) noexcept
+    : m_sink(sink) {}
+
+  void nil() { this->put(0xf6); }
+  void boolean(bool b) { this->put(b ? 0xf5 : 0xf4); }
+
+  void uint(std::uint64_t x) { this->head(0, x); }
+  // Negative integers are written as -1 - x
+  void nint(std::int64_t x) { this->head(1, ~static_cast<std::uint64_t>(x)); }
+
+  void float32(float f) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    this->put(0xfa);
+    detail::put_uint_be(bits, 4, m_sink);
+  }
+
+  void float64(double d) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    this->put(0xfb);
+    detail::put_uint_be(bits, 8, m_sink);
+  }
+
+  void string(const char * data, std::size_t size) {
+    this->head(3, size);
+    detail::put_bytes(data, size, m_sink);
+  }
+
+  void array(std::size_t n) { this->head(4, n); }
+  void map(std::size_t n) { this->head(5, n); }
+};
+//]
+
+namespace detail {
+
+// Decode an IEEE half precision float
+inline double
+half_to_double(std::uint64_t h) noexcept {
+  const int exp = static_cast<int>((h >> 10) & 0x1fu);
+  const double mant = static_cast<double>(h & 0x3ffu);
+  double result;
+  if (exp == 0) {
+    result = std::ldexp(mant, -24);
+  } else if (exp != 31) {
+    result = std::ldexp(mant + 1024, exp - 25);
+  } else {
+    result = mant == 0 ? std::numeric_limits<double>::infinity()
+                       : std::numeric_limits<double>::quiet_NaN();
+  }
+  return (h & 0x8000u) ? -result : result;
+}
+
+} // end namespace detail
+
+//[ strict_variant_cbor_reader
+class cbor_reader : public wire_reader_base {
+public:
+  using wire_reader_base::wire_reader_base;
+
+  // Read the header of the next item
+  bool next(wire_item & item) noexcept {
+    const unsigned char * p = m_src.take(1);
+    if (!p) { return false; }
+    const unsigned major = *p >> 5;
+    const unsigned info = *p & 0x1fu;
+
+    std::uint64_t x = info;
+    if (info >= 24u) {
+      if (info > 27u || !detail::get_uint_be(m_src, 1u << (info - 24u), x)) { return false; }
+    }
+
+    switch (major) {
+      case 0:
+        item.type = wire_type::uint;
+        item.u = x;
+        return true;
+      case 1:
+        if (x > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+          return false;
+        }
+        item.type = wire_type::nint;
+        item.i = -1 - static_cast<std::int64_t>(x);
+        return true;
+      case 3:
+        if (x > m_src.remaining()) { return false; }
+        item.type = wire_type::string;
+        item.u = x;
+        item.str = reinterpret_cast<const char *>(m_src.take(static_cast<std::size_t>(x)));
+        return true;
+      case 4:
+        item.type = wire_type::array;
+        item.u = x;
+        return true;
+      case 5:
+        item.type = wire_type::map;
+        item.u = x;
+        return true;
+      case 7:
+        return this->simple(info, x, item);
+      default:
+        return false;
+    }
+  }
+
+private:
+  bool simple(unsigned info, std::uint64_t x, wire_item & item) noexcept {
+    switch (info) {
+      case 20:
+      case 21:
+        item.type = wire_type::boolean;
+        item.u = info - 20u;
+        return true;
+      case 22:
+        item.type = wire_type::nil;
+        return true;
+      case 25:
+        item.type = wire_type::floating;
+        item.f = detail::half_to_double(x);
+        return true;
+      case 26: {
+        const std::uint32_t bits = static_cast<std::uint32_t>(x);
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        item.type = wire_type::floating;
+        item.f = f;
+        return true;
+      }
+      case 27:
+        item.type = wire_type::floating;
+        std::memcpy(&item.f, &x, sizeof(x));
+        return true;
+      default:
+        return false;
+    }
+  }
+};
+//]
+
+//[ strict_variant_encode_cbor
+/***
+ * Append the CBOR encoding of a variant to `sink`.
+ */
+template <typename... Ts, typename Sink>
+inline void
+encode_cbor(const variant<Ts...> & v, Sink & sink) {
+  cbor_writer<Sink> w{sink};
+  codec_write(v, w);
+}
+
+/***
+ * Read a CBOR value from `src`, and construct it in place in `v`.
+ * Returns false if the input is bad, or is not a value of the variant.
+ */
+template <typename... Ts>
+inline bool
+decode_cbor(byte_source & src, variant<Ts...> & v) {
+  cbor_reader r{src};
+  return codec_read(r, v);
+}
+//]
+
+} // end namespace strict_variant
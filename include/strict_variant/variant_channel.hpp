@@ -0,0 +1,305 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A bounded channel of variants, for any number of producer threads and one
+ * consumer thread, such as the mailbox of an actor.
+ *
+ * Producers construct each message in place in a slot of the ring, with
+ * `try_emplace<T>(args...)`, so no temporary variant is made. The consumer
+ * drains the ready messages in batches, and passes each one to a visitor.
+ * `drain_grouped` first sorts the batch by type, and then handles each type's
+ * messages together, with one dispatch per type rather than one per message.
+ * Messages of one type from one producer are handled in the order they were
+ * sent in either case, but `drain_grouped` does not keep the order between
+ * types.
+ *
+ * The ring is Vyukov's bounded queue: each slot has a sequence number, which
+ * tells a producer whether the slot is free, and the consumer whether it is
+ * full, so producers only contend on the enqueue position.
+ */
+
+#include <strict_variant/concurrency.hpp>
+#include <strict_variant/mpl/typelist.hpp>
+#include <strict_variant/mpl/ulist.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+//[ strict_variant_channel
+template <typename V>
+class channel;
+
+template <typename... Ts>
+class channel<variant<Ts...>> {
+public:
+  using value_type = variant<Ts...>;
+
+private:
+  static constexpr std::size_t num_types = sizeof...(Ts);
+
+  struct slot {
+    // Equal to the position when the slot is free, and one more when it is full
+    std::atomic<std::uint64_t> seq{0};
+    // False if the producer's constructor threw
+    bool valid = false;
+    typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type storage;
+
+    value_type & value() noexcept { return *reinterpret_cast<value_type *>(&storage); }
+  };
+
+  std::uint64_t m_mask;
+  std::unique_ptr<slot[]> m_slots;
+
+  // Written by producers
+  struct producer_state {
+    char pad[detail::cache_line_size];
+    std::atomic<std::uint64_t> enqueue{0};
+  } m_producer;
+
+  // Used only by the consumer
+  struct consumer_state {
+    char pad[detail::cache_line_size];
+    std::uint64_t dequeue = 0;
+    // Scratch space for drain_grouped
+    std::vector<slot *> batch;
+    std::vector<std::size_t> counts;
+    std::vector<slot *> sorted;
+    char pad_end[detail::cache_line_size];
+  } m_consumer;
+
+  static std::size_t round_capacity(std::size_t n) noexcept {
+    std::size_t result = 2;
+    while (result < n) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  slot & slot_at(std::uint64_t pos) const noexcept { return m_slots[pos & m_mask]; }
+
+  // Claim the slot at the enqueue position, or return nullptr if it is full
+  slot * claim(std::uint64_t & pos) noexcept {
+    pos = m_producer.enqueue.load(std::memory_order_relaxed);
+    for (;;) {
+      slot & s = this->slot_at(pos);
+      const std::uint64_t seq = s.seq.load(std::memory_order_acquire);
+      const std::int64_t diff = static_cast<std::int64_t>(seq - pos);
+      if (diff == 0) {
+        if (m_producer.enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          return &s;
+        }
+      } else if (diff < 0) {
+        return nullptr;
+      } else {
+        pos = m_producer.enqueue.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Publishes a claimed slot, even if constructing the value threw
+  struct publisher {
+    slot & s;
+    std::uint64_t pos;
+    bool success;
+
+    ~publisher() {
+      s.valid = success;
+      s.seq.store(pos + 1, std::memory_order_release);
+    }
+  };
+
+  template <typename... Args>
+  void construct(slot & s, std::uint64_t pos, Args &&... args) {
+    publisher p{s, pos, false};
+    new (&s.storage) value_type(std::forward<Args>(args)...);
+    p.success = true;
+  }
+
+  bool ready(std::uint64_t pos) const noexcept {
+    return this->slot_at(pos).seq.load(std::memory_order_acquire) == pos + 1;
+  }
+
+  void release(std::uint64_t pos) noexcept {
+    slot & s = this->slot_at(pos);
+    if (s.valid) { s.value().~value_type(); }
+    s.seq.store(pos + m_mask + 1, std::memory_order_release);
+  }
+
+  // Releases the slots of a batch, and advances the dequeue position, even if
+  // the handler throws
+  struct batch_releaser {
+    channel & c;
+    std::uint64_t start;
+    std::size_t n;
+
+    ~batch_releaser() {
+      for (std::size_t i = 0; i < n; ++i) {
+        c.release(start + i);
+      }
+      c.m_consumer.dequeue = start + n;
+    }
+  };
+
+  template <unsigned idx, typename Visitor>
+  static void handle_group(Visitor & visitor, slot * const * first, slot * const * last) {
+    for (; first != last; ++first) {
+      visitor((*first)->value().template get_unchecked<idx>());
+    }
+  }
+
+  template <typename Visitor, typename UL>
+  struct group_table;
+
+  template <typename Visitor, unsigned... us>
+  struct group_table<Visitor, mpl::ulist<us...>> {
+    using function_t = void (*)(Visitor &, slot * const *, slot * const *);
+
+    static function_t get(std::size_t idx) {
+      static constexpr function_t table[] = {&handle_group<us, Visitor>...};
+      return table[idx];
+    }
+  };
+
+public:
+  // The capacity is rounded up to a power of two
+  explicit channel(std::size_t capacity)
+    : m_mask(round_capacity(capacity) - 1)
+    , m_slots(new slot[m_mask + 1]) {
+    for (std::size_t i = 0; i <= m_mask; ++i) {
+      m_slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+    m_consumer.batch.reserve(this->capacity());
+    m_consumer.sorted.resize(this->capacity());
+    m_consumer.counts.resize(num_types + 1);
+  }
+
+  channel(const channel &) = delete;
+  channel & operator=(const channel &) = delete;
+
+  // Destroys the messages which were not consumed. No producer may be running.
+  ~channel() noexcept {
+    while (this->ready(m_consumer.dequeue)) {
+      this->release(m_consumer.dequeue++);
+    }
+  }
+
+  std::size_t capacity() const noexcept { return static_cast<std::size_t>(m_mask + 1); }
+
+  /***
+   * Construct a message of type `T` in a slot, with the arguments. Returns
+   * false, without using the arguments, if the channel is full. If the
+   * constructor throws, the slot is skipped by the consumer.
+   */
+  template <typename T, typename... Args>
+  bool try_emplace(Args &&... args) {
+    std::uint64_t pos;
+    slot * s = this->claim(pos);
+    if (!s) { return false; }
+    this->construct(*s, pos, emplace_tag<T>{}, std::forward<Args>(args)...);
+    return true;
+  }
+
+  // As `try_emplace`, but waits until there is room
+  template <typename T, typename... Args>
+  void emplace(Args &&... args) {
+    std::uint64_t pos;
+    slot * s;
+    unsigned spins = 0;
+    while (!(s = this->claim(pos))) {
+      detail::spin_wait(spins);
+    }
+    this->construct(*s, pos, emplace_tag<T>{}, std::forward<Args>(args)...);
+  }
+
+  bool try_push(const value_type & v) {
+    std::uint64_t pos;
+    slot * s = this->claim(pos);
+    if (!s) { return false; }
+    this->construct(*s, pos, v);
+    return true;
+  }
+
+  bool try_push(value_type && v) {
+    std::uint64_t pos;
+    slot * s = this->claim(pos);
+    if (!s) { return false; }
+    this->construct(*s, pos, std::move(v));
+    return true;
+  }
+
+  /***
+   * Consume up to `max` ready messages, in order, calling `visitor` with the
+   * value of each, as `apply_visitor` does. Returns the number consumed. Only
+   * one thread may consume at a time.
+   */
+  template <typename Visitor>
+  std::size_t drain(Visitor && visitor, std::size_t max = static_cast<std::size_t>(-1)) {
+    std::size_t count = 0;
+    while (count < max && this->ready(m_consumer.dequeue)) {
+      batch_releaser r{*this, m_consumer.dequeue, 1};
+      slot & s = this->slot_at(r.start);
+      if (s.valid) { apply_visitor(visitor, s.value()); }
+      ++count;
+    }
+    return count;
+  }
+
+  /***
+   * Consume up to `max` ready messages, at most the capacity, grouped by
+   * type. The messages of each type are passed to `visitor` in order, and
+   * the types are handled in the order of the variant. If `visitor` throws,
+   * the rest of the batch is discarded.
+   */
+  template <typename Visitor>
+  std::size_t drain_grouped(Visitor && visitor, std::size_t max = static_cast<std::size_t>(-1)) {
+    consumer_state & c = m_consumer;
+    c.batch.clear();
+    while (c.batch.size() < max && c.batch.size() <= m_mask
+           && this->ready(c.dequeue + c.batch.size())) {
+      c.batch.push_back(&this->slot_at(c.dequeue + c.batch.size()));
+    }
+    batch_releaser r{*this, c.dequeue, c.batch.size()};
+
+    // Counting sort by `which`
+    std::fill(c.counts.begin(), c.counts.end(), std::size_t{0});
+    for (slot * s : c.batch) {
+      if (s->valid) { ++c.counts[static_cast<std::size_t>(s->value().which()) + 1]; }
+    }
+    for (std::size_t i = 1; i <= num_types; ++i) {
+      c.counts[i] += c.counts[i - 1];
+    }
+    for (slot * s : c.batch) {
+      if (s->valid) { c.sorted[c.counts[static_cast<std::size_t>(s->value().which())]++] = s; }
+    }
+
+    // Now counts[i] is the end of the group of type i
+    using table_t = group_table<mpl::remove_reference_t<Visitor>, mpl::count_t<num_types>>;
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < num_types; ++i) {
+      const std::size_t end = c.counts[i];
+      if (end != begin) {
+        table_t::get(i)(visitor, c.sorted.data() + begin, c.sorted.data() + end);
+        begin = end;
+      }
+    }
+    return c.batch.size();
+  }
+};
+//]
+
+} // end namespace strict_variant
@@ -0,0 +1,513 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Formatting and parsing of variants in caller-provided buffers, without
+ * iostreams, in the manner of `std::to_chars` and `std::from_chars`.
+ *
+ * `to_chars(first, last, v)` writes the contained value:
+ *
+ * - `bool` as `true` or `false`.
+ * - Integers in decimal.
+ * - Floating point numbers so that they read back exactly.
+ * - `std::string` and `const char *` as they are.
+ *
+ * Specialize `chars_traits` to format other types.
+ *
+ * `from_chars(first, last, v)` parses all of `[first, last)` as one value. The
+ * text is classified as `true` / `false`, an integer, or a floating point
+ * number, and the value type is chosen as if the variant were constructed from
+ * a value of a candidate type, using the same rules as the `T &&` constructor:
+ *
+ * - Booleans are `bool`.
+ * - Integers are tried as `short`, `unsigned short`, `int`, ... up to
+ *   `unsigned long long`, skipping those which the variant would reject or for
+ *   which it would be ambiguous, and those which cannot hold the value, or
+ *   whose chosen value type cannot hold it.
+ * - Floating point numbers are tried as `double`, `float`, `long double`. So
+ *   are integers, if no integer type was accepted.
+ *
+ * If no value type is chosen, or the text is something else, it is used to
+ * construct the first value type which is constructible from
+ * `(const char *, std::size_t)`, such as `std::string`.
+ * Nothing is allocated, other than by the constructor of that value type.
+ *
+ * With C++17, `std::to_chars` and `std::from_chars` are used for arithmetic
+ * types. Otherwise integers are handled here, and floating point numbers use
+ * `snprintf` and `strtod`, which depend on the C locale, and floating point
+ * text longer than `detail::max_float_chars` is not parsed as a number.
+ */
+
+#include <strict_variant/filter_overloads.hpp>
+#include <strict_variant/mpl/typelist.hpp>
+#include <strict_variant/mpl/ulist.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus >= 201703L
+#include <charconv>
+#include <string_view>
+#endif
+
+#if !defined(__cpp_lib_to_chars)
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#endif
+
+namespace strict_variant {
+
+//[ strict_variant_chars_result
+struct to_chars_result {
+  char * ptr;
+  std::errc ec;
+};
+
+struct from_chars_result {
+  const char * ptr;
+  std::errc ec;
+};
+//]
+
+//[ strict_variant_chars_traits
+template <typename T, typename ENABLE = void>
+struct chars_traits;
+// {
+//   // Write `t` to the front of [first, last), and return the end of what was
+//   // written, or nullptr if there is not enough room.
+//   static char * write(char * first, char * last, const T & t);
+// };
+//]
+
+namespace detail {
+
+// Copy a string, if there is room
+inline char *
+write_chars(char * first, char * last, const char * str, std::size_t size) noexcept {
+  if (static_cast<std::size_t>(last - first) < size) { return nullptr; }
+  std::memcpy(first, str, size);
+  return first + size;
+}
+
+// Integers, excluding `bool` and character types
+template <typename T, bool = std::is_integral<T>::value>
+struct is_chars_integer : std::false_type {};
+
+template <typename T>
+struct is_chars_integer<T, true>
+  : std::integral_constant<bool, mpl::classify_arithmetic<T>::value
+                                   == mpl::arithmetic_category::integer> {};
+
+#if !defined(__cpp_lib_to_chars)
+// The longest floating point number that we will parse, without charconv
+static constexpr std::size_t max_float_chars = 128;
+
+inline int
+format_float(char * buf, std::size_t size, double d) noexcept {
+  return std::snprintf(buf, size, "%.*g", std::numeric_limits<double>::max_digits10, d);
+}
+
+inline int
+format_float(char * buf, std::size_t size, long double d) noexcept {
+  return std::snprintf(buf, size, "%.*Lg", std::numeric_limits<long double>::max_digits10, d);
+}
+
+inline float
+parse_float(const char * str, char ** end, float) noexcept {
+  return std::strtof(str, end);
+}
+
+inline double
+parse_float(const char * str, char ** end, double) noexcept {
+  return std::strtod(str, end);
+}
+
+inline long double
+parse_float(const char * str, char ** end, long double) noexcept {
+  return std::strtold(str, end);
+}
+#endif
+
+// Parse all of [first, last) as a floating point number
+template <typename F>
+std::errc
+float_from_chars(const char * first, const char * last, F & f) noexcept {
+#if defined(__cpp_lib_to_chars)
+  const auto result = std::from_chars(first, last, f);
+  if (result.ec != std::errc{}) { return result.ec; }
+  return result.ptr == last ? std::errc{} : std::errc::invalid_argument;
+#else
+  // strtod needs a null terminator
+  char buf[max_float_chars + 1];
+  const std::size_t size = static_cast<std::size_t>(last - first);
+  if (size > max_float_chars) { return std::errc::invalid_argument; }
+  std::memcpy(buf, first, size);
+  buf[size] = 0;
+
+  char * end;
+  errno = 0;
+  f = parse_float(buf, &end, F{});
+  if (end != buf + size) { return std::errc::invalid_argument; }
+  return errno == ERANGE ? std::errc::result_out_of_range : std::errc{};
+#endif
+}
+
+// Does [first, last) look like a number, and is it an integer?
+// A number is an optional '-', digits, an optional '.' and digits, and an
+// optional exponent, with at least one digit before the exponent.
+enum class number_syntax { none, integer, floating };
+
+inline number_syntax
+classify_number(const char * first, const char * last) noexcept {
+  const char * p = first;
+  if (p != last && *p == '-') { ++p; }
+
+  std::size_t digits = 0;
+  for (; p != last && *p >= '0' && *p <= '9'; ++p) { ++digits; }
+  if (p == last) { return digits ? number_syntax::integer : number_syntax::none; }
+
+  if (*p == '.') {
+    for (++p; p != last && *p >= '0' && *p <= '9'; ++p) { ++digits; }
+  }
+  if (!digits) { return number_syntax::none; }
+
+  if (p != last && (*p == 'e' || *p == 'E')) {
+    ++p;
+    if (p != last && (*p == '-' || *p == '+')) { ++p; }
+    if (p == last) { return number_syntax::none; }
+    while (p != last && *p >= '0' && *p <= '9') { ++p; }
+  }
+  return p == last ? number_syntax::floating : number_syntax::none;
+}
+
+// Parse an optional '-' and decimal digits into a sign and magnitude.
+// Returns false on overflow.
+inline bool
+parse_integer(const char * first, const char * last, bool & negative,
+              unsigned long long & magnitude) noexcept {
+  negative = (*first == '-');
+  if (negative) { ++first; }
+
+  constexpr unsigned long long max = std::numeric_limits<unsigned long long>::max();
+  magnitude = 0;
+  for (; first != last; ++first) {
+    const unsigned d = static_cast<unsigned>(*first - '0');
+    if (magnitude > (max - d) / 10) { return false; }
+    magnitude = magnitude * 10 + d;
+  }
+  // -0 is 0
+  negative = negative && magnitude;
+  return true;
+}
+
+// Can an integer type hold the value with this sign and magnitude?
+template <typename C>
+bool
+integer_fits(bool negative, unsigned long long magnitude) noexcept {
+  if (!negative) {
+    return magnitude <= static_cast<unsigned long long>(std::numeric_limits<C>::max());
+  }
+  // -(min + 1) + 1 is the magnitude of min, without overflow
+  return std::is_signed<C>::value
+         && magnitude - 1
+              <= static_cast<unsigned long long>(-(std::numeric_limits<C>::min() + 1));
+}
+
+// The variant may convert a signed candidate to an unsigned value type, so
+// the value must fit in that too
+template <typename T>
+bool
+integer_fits(bool negative, unsigned long long magnitude, std::true_type) noexcept {
+  return integer_fits<T>(negative, magnitude);
+}
+
+template <typename T>
+bool
+integer_fits(bool, unsigned long long, std::false_type) noexcept {
+  return true;
+}
+
+template <typename C>
+C
+integer_value(bool negative, unsigned long long magnitude) noexcept {
+  // Negate as unsigned, and convert back, avoiding overflow at min
+  return negative ? static_cast<C>(-static_cast<C>(magnitude - 1) - 1) : static_cast<C>(magnitude);
+}
+
+// The value type that the variant would choose for a `C`, if it is unique
+template <typename UL>
+struct unique_overload : std::false_type {
+  static constexpr unsigned index = 0;
+};
+
+template <unsigned u>
+struct unique_overload<mpl::ulist<u>> : std::true_type {
+  static constexpr unsigned index = u;
+};
+
+// The value types constructible from a pointer and length
+template <typename TL>
+struct string_overloads {
+  template <unsigned u>
+  struct prop {
+    using T = unwrap_type_t<mpl::Index_At<TL, u>>;
+    static constexpr bool value =
+      !std::is_arithmetic<T>::value && std::is_constructible<T, const char *, std::size_t>::value;
+  };
+
+  using type = mpl::ulist_filter_t<prop, mpl::count_t<TL::size>>;
+};
+
+template <typename UL>
+struct first_overload : std::false_type {
+  static constexpr unsigned index = 0;
+};
+
+template <unsigned u, unsigned... us>
+struct first_overload<mpl::ulist<u, us...>> : std::true_type {
+  static constexpr unsigned index = u;
+};
+
+template <typename V>
+struct chars_parser;
+
+template <typename... Ts>
+struct chars_parser<variant<Ts...>> {
+  using var_t = variant<Ts...>;
+
+  template <typename C>
+  struct accepts : unique_overload<typename filter_overloads<C, mpl::TypeList<Ts...>>::type> {};
+
+  template <typename C>
+  using target_t = unwrap_type_t<mpl::Index_At<mpl::TypeList<Ts...>, accepts<C>::index>>;
+
+  using string_slot = first_overload<typename string_overloads<mpl::TypeList<Ts...>>::type>;
+
+  using integer_candidates = mpl::TypeList<short, unsigned short, int, unsigned int, long,
+                                           unsigned long, long long, unsigned long long>;
+  using float_candidates = mpl::TypeList<double, float, long double>;
+
+  template <typename C>
+  static void emplace_as(var_t & v, C x, std::true_type) {
+    v.template emplace<accepts<C>::index>(x);
+  }
+
+  template <typename C>
+  static void emplace_as(var_t &, C, std::false_type) {}
+
+  static bool boolean(var_t & v, bool b) {
+    emplace_as(v, b, accepts<bool>{});
+    return accepts<bool>::value;
+  }
+
+  // Emplace as the first candidate type which the variant accepts and which
+  // can hold the value. `range_error` is set if it was accepted but too large.
+  static bool integer(var_t &, bool, unsigned long long, bool &, mpl::TypeList<>) { return false; }
+
+  template <typename C, typename... Cs>
+  static bool integer(var_t & v, bool negative, unsigned long long magnitude, bool & range_error,
+                      mpl::TypeList<C, Cs...>) {
+    if (accepts<C>::value) {
+      using T = target_t<C>;
+      if (integer_fits<C>(negative, magnitude)
+          && integer_fits<T>(negative, magnitude, std::is_integral<T>{})) {
+        emplace_as(v, integer_value<C>(negative, magnitude), accepts<C>{});
+        return true;
+      }
+      range_error = true;
+    }
+    return integer(v, negative, magnitude, range_error, mpl::TypeList<Cs...>{});
+  }
+
+  static bool floating(var_t &, const char *, const char *, bool &, mpl::TypeList<>) {
+    return false;
+  }
+
+  template <typename C, typename... Cs>
+  static bool floating(var_t & v, const char * first, const char * last, bool & range_error,
+                       mpl::TypeList<C, Cs...>) {
+    if (accepts<C>::value) {
+      C x;
+      const std::errc ec = float_from_chars(first, last, x);
+      if (ec == std::errc{}) {
+        emplace_as(v, x, accepts<C>{});
+        return true;
+      }
+      if (ec == std::errc::result_out_of_range) { range_error = true; }
+    }
+    return floating(v, first, last, range_error, mpl::TypeList<Cs...>{});
+  }
+
+  static bool string(var_t & v, const char * first, const char * last, std::true_type) {
+    v.template emplace<string_slot::index>(first, static_cast<std::size_t>(last - first));
+    return true;
+  }
+
+  static bool string(var_t &, const char *, const char *, std::false_type) { return false; }
+
+  static std::errc parse(const char * first, const char * last, var_t & v) {
+    const std::size_t size = static_cast<std::size_t>(last - first);
+    bool range_error = false;
+    bool done = false;
+
+    if (size == 4 && !std::memcmp(first, "true", 4)) {
+      done = boolean(v, true);
+    } else if (size == 5 && !std::memcmp(first, "false", 5)) {
+      done = boolean(v, false);
+    } else {
+      switch (classify_number(first, last)) {
+        case number_syntax::integer: {
+          bool negative;
+          unsigned long long magnitude;
+          if (parse_integer(first, last, negative, magnitude)) {
+            done = integer(v, negative, magnitude, range_error, integer_candidates{});
+          } else {
+            range_error = true;
+          }
+          // An integer may also be read as a floating point number
+          if (!done && !range_error) {
+            done = floating(v, first, last, range_error, float_candidates{});
+          }
+          break;
+        }
+        case number_syntax::floating:
+          done = floating(v, first, last, range_error, float_candidates{});
+          break;
+        case number_syntax::none:
+          break;
+      }
+    }
+
+    if (!done) { done = string(v, first, last, string_slot{}); }
+    if (done) { return std::errc{}; }
+    return range_error ? std::errc::result_out_of_range : std::errc::invalid_argument;
+  }
+};
+
+struct chars_write_visitor {
+  typedef char * result_type;
+
+  char * first;
+  char * last;
+
+  template <typename T>
+  char * operator()(const T & t) const {
+    return chars_traits<T>::write(first, last, t);
+  }
+};
+
+} // end namespace detail
+
+template <>
+struct chars_traits<bool> {
+  static char * write(char * first, char * last, bool b) noexcept {
+    return b ? detail::write_chars(first, last, "true", 4)
+             : detail::write_chars(first, last, "false", 5);
+  }
+};
+
+template <typename T>
+struct chars_traits<T, mpl::enable_if_t<detail::is_chars_integer<T>::value>> {
+  static char * write(char * first, char * last, T x) noexcept {
+#if __cplusplus >= 201703L
+    const auto result = std::to_chars(first, last, x);
+    return result.ec == std::errc{} ? result.ptr : nullptr;
+#else
+    // Digits are produced backwards, from the magnitude as unsigned
+    using U = typename std::make_unsigned<T>::type;
+    char buf[std::numeric_limits<U>::digits10 + 2];
+    char * p = buf + sizeof(buf);
+    U u = static_cast<U>(x);
+    if (x < 0) { u = static_cast<U>(0u - u); }
+    do {
+      *--p = static_cast<char>('0' + u % 10);
+      u = static_cast<U>(u / 10);
+    } while (u);
+    if (x < 0) { *--p = '-'; }
+    return detail::write_chars(first, last, p, static_cast<std::size_t>(buf + sizeof(buf) - p));
+#endif
+  }
+};
+
+template <typename T>
+struct chars_traits<T, mpl::enable_if_t<std::is_floating_point<T>::value>> {
+  static char * write(char * first, char * last, T x) noexcept {
+#if defined(__cpp_lib_to_chars)
+    const auto result = std::to_chars(first, last, x);
+    return result.ec == std::errc{} ? result.ptr : nullptr;
+#else
+    using F = typename std::conditional<std::is_same<T, long double>::value, long double,
+                                        double>::type;
+    char buf[64];
+    const int n = detail::format_float(buf, sizeof(buf), static_cast<F>(x));
+    if (n < 0 || static_cast<std::size_t>(n) >= sizeof(buf)) { return nullptr; }
+    return detail::write_chars(first, last, buf, static_cast<std::size_t>(n));
+#endif
+  }
+};
+
+template <typename Traits, typename Alloc>
+struct chars_traits<std::basic_string<char, Traits, Alloc>> {
+  static char * write(char * first, char * last,
+                      const std::basic_string<char, Traits, Alloc> & s) noexcept {
+    return detail::write_chars(first, last, s.data(), s.size());
+  }
+};
+
+template <>
+struct chars_traits<const char *> {
+  static char * write(char * first, char * last, const char * s) noexcept {
+    return detail::write_chars(first, last, s, std::strlen(s));
+  }
+};
+
+#if __cplusplus >= 201703L
+template <typename Traits>
+struct chars_traits<std::basic_string_view<char, Traits>> {
+  static char * write(char * first, char * last, std::basic_string_view<char, Traits> s) noexcept {
+    return detail::write_chars(first, last, s.data(), s.size());
+  }
+};
+#endif
+
+//[ strict_variant_to_chars
+/***
+ * Write the contained value to [first, last). On success, returns the end of
+ * what was written, and on failure returns `last` and
+ * `std::errc::value_too_large`, with the contents of the range unspecified.
+ */
+template <typename... Ts>
+inline to_chars_result
+to_chars(char * first, char * last, const variant<Ts...> & v) {
+  char * p = apply_visitor(detail::chars_write_visitor{first, last}, v);
+  if (!p) { return {last, std::errc::value_too_large}; }
+  return {p, std::errc{}};
+}
+
+/***
+ * Parse all of [first, last) as a value of the variant, and construct it in
+ * place in `v`. Returns `last` on success. Otherwise `v` is unchanged, and the
+ * error is `std::errc::result_out_of_range` if the text is a number that is
+ * too large for any value type which would accept it, or else
+ * `std::errc::invalid_argument`.
+ */
+template <typename... Ts>
+inline from_chars_result
+from_chars(const char * first, const char * last, variant<Ts...> & v) {
+  const std::errc ec = detail::chars_parser<variant<Ts...>>::parse(first, last, v);
+  return {ec == std::errc{} ? last : first, ec};
+}
+//]
+
+} // end namespace strict_variant
@@ -0,0 +1,475 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Mapping of variants to self-describing wire formats, such as MessagePack and
+ * CBOR.
+ *
+ * The formats have a common data model: nil, booleans, integers, floating
+ * point numbers, strings, arrays and maps. `codec_traits<T>` maps a value type
+ * to it:
+ *
+ * - `std::nullptr_t` is nil, and `bool` is a boolean.
+ * - Integral types are integers. Floating point types are floats.
+ * - `std::string` is a string.
+ * - `std::vector` is an array, and `std::map` and `std::unordered_map` are maps.
+ * - A variant is its contained value. So the wire format does not record the
+ *   `which` value. When reading, the value goes to the first value type which
+ *   accepts that wire type, and it is an error if that value type can't
+ *   represent it (for instance an integer, or a finite float, which is out of
+ *   range).
+ * - `recursive_wrapper` and `alloc_wrapper` are transparent.
+ *
+ * Specialize the trait to support other types.
+ *
+ * Values are written to a `Writer` and read from a `Reader`, which implement a
+ * particular format. See `variant_msgpack.hpp` and `variant_cbor.hpp`.
+ * Reading does not build any intermediate representation: each value is
+ * constructed in place in its container or variant, as it is read.
+ */
+
+#include <strict_variant/mpl/std_traits.hpp>
+#include <strict_variant/mpl/typelist.hpp>
+#include <strict_variant/mpl/ulist.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_serialize.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+//[ strict_variant_wire_item
+enum class wire_type : unsigned char { nil, boolean, uint, nint, floating, string, array, map };
+
+/***
+ * The header of an item, as reported by a `Reader`. Which members are set
+ * depends on `type`:
+ * - boolean: `u` is 0 or 1.
+ * - uint: `u` is the value. nint: `i` is the (negative) value.
+ * - floating: `f` is the value.
+ * - string: `str` points at `u` bytes, inside the buffer being read.
+ * - array, map: `u` is the number of elements, or of key-value pairs.
+ */
+struct wire_item {
+  wire_type type;
+  std::uint64_t u;
+  std::int64_t i;
+  double f;
+  const char * str;
+};
+//]
+
+// Bit of a wire type, in `codec_traits<T>::kinds`
+constexpr unsigned
+wire_bit(wire_type t) noexcept {
+  return 1u << static_cast<unsigned>(t);
+}
+
+//[ strict_variant_codec_traits
+template <typename T, typename ENABLE = void>
+struct codec_traits;
+// {
+//   // Bitmask of the wire types which may be read as a T
+//   static constexpr unsigned kinds = ...;
+//
+//   template <typename Writer>
+//   static void write(const T &, Writer &);
+//
+//   // Read a value whose header is `item`, and construct it by calling
+//   // `emplace(args...)` exactly once. Return false if the input is bad.
+//   template <typename Reader, typename Emplacer>
+//   static bool read(Reader &, const wire_item & item, Emplacer && emplace);
+// };
+//]
+
+/***
+ * Common part of readers: the buffer, and a limit on the nesting depth.
+ */
+class wire_reader_base {
+protected:
+  byte_source & m_src;
+  unsigned m_depth_left;
+
+public:
+  explicit wire_reader_base(byte_source & src, unsigned max_depth = 128) noexcept
+    : m_src(src)
+    , m_depth_left(max_depth) {}
+
+  std::size_t remaining() const noexcept { return m_src.remaining(); }
+
+  // Called around the elements of an array or map
+  bool enter() noexcept {
+    if (!m_depth_left) { return false; }
+    --m_depth_left;
+    return true;
+  }
+  void leave() noexcept { ++m_depth_left; }
+};
+
+namespace detail {
+
+// Append the low `num_bytes` bytes of x, most significant first
+template <typename Sink>
+inline void
+put_uint_be(std::uint64_t x, unsigned num_bytes, Sink & sink) {
+  unsigned char bytes[8];
+  for (unsigned i = 0; i < num_bytes; ++i) {
+    bytes[i] = static_cast<unsigned char>(x >> (8 * (num_bytes - 1 - i)));
+  }
+  put_bytes(bytes, num_bytes, sink);
+}
+
+inline bool
+get_uint_be(byte_source & src, unsigned num_bytes, std::uint64_t & x) noexcept {
+  const unsigned char * p = src.take(num_bytes);
+  if (!p) { return false; }
+  x = 0;
+  for (unsigned i = 0; i < num_bytes; ++i) {
+    x = (x << 8) | p[i];
+  }
+  return true;
+}
+
+template <typename T>
+constexpr bool
+is_negative(T t, std::true_type) noexcept {
+  return t < T(0);
+}
+
+template <typename T>
+constexpr bool
+is_negative(T, std::false_type) noexcept {
+  return false;
+}
+
+// Read the next item, which should be a T
+template <typename T, typename Reader, typename Emplacer>
+bool
+codec_read_next(Reader & r, Emplacer && emplace) {
+  wire_item item;
+  if (!r.next(item) || !(codec_traits<T>::kinds & wire_bit(item.type))) { return false; }
+  return codec_traits<T>::read(r, item, std::forward<Emplacer>(emplace));
+}
+
+// Holds a value which is being read, such as a map key
+template <typename T>
+class value_holder {
+  raw_value<T> m_value;
+  bool m_constructed = false;
+
+public:
+  value_holder() = default;
+  value_holder(const value_holder &) = delete;
+  value_holder & operator=(const value_holder &) = delete;
+  ~value_holder() {
+    if (m_constructed) { m_value.get().~T(); }
+  }
+
+  template <typename... Args>
+  void operator()(Args &&... args) {
+    new (&m_value.storage) T(std::forward<Args>(args)...);
+    m_constructed = true;
+  }
+
+  T & get() noexcept { return m_value.get(); }
+};
+
+// Inserts into a map, with a key that was already read
+template <typename M>
+struct map_emplacer {
+  M & target;
+  typename M::key_type & key;
+
+  template <typename... Args>
+  void operator()(Args &&... args) const {
+    target.emplace(std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                   std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+};
+
+template <typename Writer>
+struct codec_write_visitor {
+  Writer & writer;
+
+  template <typename T>
+  void operator()(const T & t) const {
+    codec_traits<T>::write(t, writer);
+  }
+};
+
+// Union of the wire types accepted by some types
+template <typename... Ts>
+struct kinds_union;
+
+template <>
+struct kinds_union<> : std::integral_constant<unsigned, 0> {};
+
+template <typename T, typename... Ts>
+struct kinds_union<T, Ts...>
+  : std::integral_constant<unsigned, codec_traits<unwrap_type_t<T>>::kinds
+                                       | kinds_union<Ts...>::value> {};
+
+// Reads value type `idx` of a variant
+template <typename TL, typename Reader, typename Emplacer, unsigned idx>
+bool
+codec_read_alternative(Reader & r, const wire_item & item, Emplacer & emplace) {
+  using T = unwrap_type_t<mpl::Index_At<TL, idx>>;
+  return codec_traits<T>::read(r, item, tagged_emplacer<T, Emplacer>{emplace});
+}
+
+template <typename TL, typename Reader, typename Emplacer, typename UL>
+struct codec_read_table;
+
+template <typename... Ts, typename Reader, typename Emplacer, unsigned... us>
+struct codec_read_table<mpl::TypeList<Ts...>, Reader, Emplacer, mpl::ulist<us...>> {
+  using function_t = bool (*)(Reader &, const wire_item &, Emplacer &);
+
+  // Read the item as the first value type which accepts its wire type
+  static bool read(Reader & r, const wire_item & item, Emplacer & emplace) {
+    static constexpr unsigned kinds[] = {codec_traits<unwrap_type_t<Ts>>::kinds...};
+    static constexpr function_t readers[] = {
+      &codec_read_alternative<mpl::TypeList<Ts...>, Reader, Emplacer, us>...};
+
+    const unsigned bit = wire_bit(item.type);
+    for (std::size_t idx = 0; idx < sizeof...(Ts); ++idx) {
+      if (kinds[idx] & bit) { return readers[idx](r, item, emplace); }
+    }
+    return false;
+  }
+};
+
+// Maps are a header, then each key followed by its value
+template <typename M>
+struct map_codec_traits {
+  static constexpr unsigned kinds = wire_bit(wire_type::map);
+
+  template <typename Writer>
+  static void write(const M & m, Writer & w) {
+    w.map(m.size());
+    for (const auto & p : m) {
+      codec_traits<typename M::key_type>::write(p.first, w);
+      codec_traits<typename M::mapped_type>::write(p.second, w);
+    }
+  }
+
+  template <typename Reader, typename Emplacer>
+  static bool read(Reader & r, const wire_item & item, Emplacer && emplace) {
+    using key_t = typename M::key_type;
+    using mapped_t = typename M::mapped_type;
+
+    // Each key and value is at least one byte
+    if (item.u > r.remaining() / 2 || !r.enter()) { return false; }
+
+    M result;
+    for (std::uint64_t idx = 0; idx < item.u; ++idx) {
+      value_holder<key_t> key;
+      if (!codec_read_next<key_t>(r, key)
+          || !codec_read_next<mapped_t>(r, map_emplacer<M>{result, key.get()})) {
+        r.leave();
+        return false;
+      }
+    }
+    r.leave();
+    emplace(std::move(result));
+    return true;
+  }
+};
+
+} // end namespace detail
+
+template <>
+struct codec_traits<std::nullptr_t> {
+  static constexpr unsigned kinds = wire_bit(wire_type::nil);
+
+  template <typename Writer>
+  static void write(std::nullptr_t, Writer & w) {
+    w.nil();
+  }
+
+  template <typename Reader, typename Emplacer>
+  static bool read(Reader &, const wire_item &, Emplacer && emplace) {
+    emplace(nullptr);
+    return true;
+  }
+};
+
+template <>
+struct codec_traits<bool> {
+  static constexpr unsigned kinds = wire_bit(wire_type::boolean);
+
+  template <typename Writer>
+  static void write(bool b, Writer & w) {
+    w.boolean(b);
+  }
+
+  template <typename Reader, typename Emplacer>
+  static bool read(Reader &, const wire_item & item, Emplacer && emplace) {
+    emplace(item.u != 0);
+    return true;
+  }
+};
+
+// Integers are range-checked when read
+template <typename T>
+struct codec_traits<T, mpl::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>> {
+  static constexpr unsigned kinds =
+    wire_bit(wire_type::uint) | (std::is_signed<T>::value ? wire_bit(wire_type::nint) : 0u);
+
+  template <typename Writer>
+  static void write(T t, Writer & w) {
+    if (detail::is_negative(t, std::is_signed<T>{})) {
+      w.nint(static_cast<std::int64_t>(t));
+    } else {
+      w.uint(static_cast<std::uint64_t>(t));
+    }
+  }
+
+  template <typename Reader, typename Emplacer>
+  static bool read(Reader &, const wire_item & item, Emplacer && emplace) {
+    if (item.type == wire_type::uint) {
+      if (item.u > static_cast<std::uint64_t>(std::numeric_limits<T>::max())) { return false; }
+      emplace(static_cast<T>(item.u));
+    } else {
+      if (item.i < static_cast<std::int64_t>(std::numeric_limits<T>::min())) { return false; }
+      emplace(static_cast<T>(item.i));
+    }
+    return true;
+  }
+};
+
+// `float` is written in single precision, other types in double precision.
+// Finite values are range-checked when read.
+template <typename T>
+struct codec_traits<T, mpl::enable_if_t<std::is_floating_point<T>::value>> {
+  static constexpr unsigned kinds = wire_bit(wire_type::floating);
+
+  template <typename Writer>
+  static void write(T t, Writer & w) {
+    if (std::is_same<T, float>::value) {
+      w.float32(static_cast<float>(t));
+    } else {
+      w.float64(static_cast<double>(t));
+    }
+  }
+
+  template <typename Reader, typename Emplacer>
+  static bool read(Reader &, const wire_item & item, Emplacer && emplace) {
+    if (std::isfinite(item.f)
+        && std::fabs(static_cast<long double>(item.f))
+             > static_cast<long double>(std::numeric_limits<T>::max())) {
+      return false;
+    }
+    emplace(static_cast<T>(item.f));
+    return true;
+  }
+};
+
+template <>
+struct codec_traits<std::string> {
+  static constexpr unsigned kinds = wire_bit(wire_type::string);
+
+  template <typename Writer>
+  static void write(const std::string & s, Writer & w) {
+    w.string(s.data(), s.size());
+  }
+
+  template <typename Reader, typename Emplacer>
+  static bool read(Reader &, const wire_item & item, Emplacer && emplace) {
+    emplace(item.str, static_cast<std::size_t>(item.u));
+    return true;
+  }
+};
+
+template <typename T>
+struct codec_traits<std::vector<T>> {
+  static constexpr unsigned kinds = wire_bit(wire_type::array);
+
+  template <typename Writer>
+  static void write(const std::vector<T> & vec, Writer & w) {
+    w.array(vec.size());
+    for (const T & t : vec) {
+      codec_traits<T>::write(t, w);
+    }
+  }
+
+  template <typename Reader, typename Emplacer>
+  static bool read(Reader & r, const wire_item & item, Emplacer && emplace) {
+    // Each element is at least one byte
+    if (item.u > r.remaining() || !r.enter()) { return false; }
+
+    std::vector<T> result;
+    result.reserve(static_cast<std::size_t>(item.u));
+    for (std::uint64_t idx = 0; idx < item.u; ++idx) {
+      if (!detail::codec_read_next<T>(r, detail::vector_emplacer<T>{result})) {
+        r.leave();
+        return false;
+      }
+    }
+    r.leave();
+    emplace(std::move(result));
+    return true;
+  }
+};
+
+template <typename K, typename V, typename C, typename A>
+struct codec_traits<std::map<K, V, C, A>> : detail::map_codec_traits<std::map<K, V, C, A>> {};
+
+template <typename K, typename V, typename H, typename E, typename A>
+struct codec_traits<std::unordered_map<K, V, H, E, A>>
+  : detail::map_codec_traits<std::unordered_map<K, V, H, E, A>> {};
+
+template <typename... Ts>
+struct codec_traits<variant<Ts...>> {
+  static constexpr unsigned kinds = detail::kinds_union<Ts...>::value;
+
+  template <typename Writer>
+  static void write(const variant<Ts...> & v, Writer & w) {
+    strict_variant::apply_visitor(detail::codec_write_visitor<Writer>{w}, v);
+  }
+
+  template <typename Reader, typename Emplacer>
+  static bool read(Reader & r, const wire_item & item, Emplacer && emplace) {
+    using table_t = detail::codec_read_table<mpl::TypeList<Ts...>, Reader,
+                                             mpl::remove_reference_t<Emplacer>,
+                                             mpl::count_t<sizeof...(Ts)>>;
+    return table_t::read(r, item, emplace);
+  }
+};
+
+//[ strict_variant_codec_write
+/***
+ * Write a variant using a `Writer`, such as `msgpack_writer` or `cbor_writer`.
+ */
+template <typename... Ts, typename Writer>
+inline void
+codec_write(const variant<Ts...> & v, Writer & w) {
+  codec_traits<variant<Ts...>>::write(v, w);
+}
+
+/***
+ * Read a variant using a `Reader`, such as `msgpack_reader` or `cbor_reader`,
+ * and construct it in place in `v`. Returns false if the input is bad.
+ */
+template <typename Reader, typename... Ts>
+inline bool
+codec_read(Reader & r, variant<Ts...> & v) {
+  return detail::codec_read_next<variant<Ts...>>(r, detail::variant_emplacer<variant<Ts...>>{v});
+}
+//]
+
+} // end namespace strict_variant
@@ -0,0 +1,396 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A columnar format for sequences of variants.
+ *
+ * `columnar_writer<V>` collects a sequence of `V`'s, and `write(sink)` appends
+ * them to a sink as columns:
+ *
+ * - The `which` values, as runs. Each run is one varint, holding the length
+ *   of the run minus one, shifted left by the number of bits needed for a tag,
+ *   and then the tag.
+ * - For each value type, the values of that type, in order. Integers are
+ *   stored as a varint of the zigzag-encoded difference from the previous
+ *   value in the column. Other types are stored in the format of `serialize`.
+ *
+ * Values are not padded to the size of the variant's storage, so a sequence
+ * with long runs of one type, or slowly changing integers, is much smaller
+ * than an array of variants. Specialize `column_traits` to change the
+ * encoding of a type.
+ *
+ * `columnar_reader<V>` reads the format in a buffer, without copying it.
+ * `for_each(visitor)` visits the values in their original order, dispatching
+ * once per run of tags. `scan(visitor)` visits each column in turn, which is
+ * faster when the order across types does not matter. The visitor is passed
+ * each value as by `variant_view`: integers by value, strings as `string_ref`,
+ * and so on.
+ *
+ * The format is:
+ *
+ *   varint   number of values
+ *   varint   number of value types
+ *   varint   size of the tag column, in bytes, and then the tag column
+ *   for each value type:
+ *     varint number of values of that type
+ *     varint size of the column, in bytes, and then the column
+ */
+
+#include <strict_variant/mpl/typelist.hpp>
+#include <strict_variant/mpl/ulist.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_serialize.hpp>
+#include <strict_variant/variant_view.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace strict_variant {
+
+//[ strict_variant_column_traits
+/***
+ * The encoding of the values of type `T` in a column. By default, the format
+ * of `serialize`.
+ */
+template <typename T, typename ENABLE = void>
+struct column_traits {
+  // Carried from each value of a column to the next
+  struct state {};
+
+  template <typename Sink>
+  static void write(const T & t, state &, Sink & sink) {
+    serialize_traits<T>::write(t, sink);
+  }
+
+  // Read a value, and pass a view of it to `f`. Return false if the input is
+  // bad.
+  template <typename F>
+  static bool read(byte_source & src, state &, F && f) {
+    const byte_source start = src;
+    if (!view_traits<T>::skip(src)) { return false; }
+    f(view_traits<T>::view(start));
+    return true;
+  }
+};
+//]
+
+namespace detail {
+
+inline std::uint64_t
+zigzag_encode(std::uint64_t x) noexcept {
+  return (x << 1) ^ (0 - (x >> 63));
+}
+
+inline std::uint64_t
+zigzag_decode(std::uint64_t x) noexcept {
+  return (x >> 1) ^ (0 - (x & 1));
+}
+
+// The number of bits needed to hold `x`
+constexpr unsigned
+bit_width(std::size_t x) {
+  return x ? 1 + bit_width(x >> 1) : 0;
+}
+
+} // end namespace detail
+
+// Integers are the difference from the previous value, zigzag-encoded, so that
+// small differences of either sign are one byte
+template <typename T>
+struct column_traits<T, mpl::enable_if_t<std::is_integral<T>::value
+                                         && !std::is_same<T, bool>::value && sizeof(T) <= 8>> {
+  struct state {
+    std::uint64_t prev = 0;
+  };
+
+  template <typename Sink>
+  static void write(const T & t, state & s, Sink & sink) {
+    const std::uint64_t x = static_cast<std::uint64_t>(t);
+    detail::put_varint(detail::zigzag_encode(x - s.prev), sink);
+    s.prev = x;
+  }
+
+  template <typename F>
+  static bool read(byte_source & src, state & s, F && f) {
+    std::uint64_t z;
+    if (!detail::get_varint(src, z)) { return false; }
+    const std::uint64_t x = s.prev + detail::zigzag_decode(z);
+    const T t = static_cast<T>(x);
+    if (static_cast<std::uint64_t>(t) != x) { return false; }
+    s.prev = x;
+    f(t);
+    return true;
+  }
+};
+
+//[ strict_variant_columnar_writer
+template <typename V>
+class columnar_writer;
+
+template <typename... Ts>
+class columnar_writer<variant<Ts...>> {
+  using variant_t = variant<Ts...>;
+  using states_t = std::tuple<typename column_traits<unwrap_type_t<Ts>>::state...>;
+
+  static constexpr std::size_t num_types = sizeof...(Ts);
+  static constexpr unsigned tag_bits = detail::bit_width(num_types - 1);
+
+  std::vector<unsigned char> m_tags;
+  std::vector<unsigned char> m_columns[num_types];
+  std::size_t m_counts[num_types] = {};
+  states_t m_states;
+  std::size_t m_size = 0;
+  // The run of tags which is not yet in `m_tags`
+  std::size_t m_run_tag = 0;
+  std::size_t m_run_length = 0;
+
+  template <typename Sink>
+  void write_run(Sink & sink) const {
+    detail::put_varint((static_cast<std::uint64_t>(m_run_length - 1) << tag_bits) | m_run_tag,
+                       sink);
+  }
+
+  template <unsigned idx>
+  static void write_value(columnar_writer & w, const variant_t & v) {
+    using T = unwrap_type_t<mpl::Index_At<mpl::TypeList<Ts...>, idx>>;
+    column_traits<T>::write(v.template get_unchecked<idx>(), std::get<idx>(w.m_states),
+                            w.m_columns[idx]);
+  }
+
+  template <typename UL>
+  struct write_table;
+
+  template <unsigned... us>
+  struct write_table<mpl::ulist<us...>> {
+    using function_t = void (*)(columnar_writer &, const variant_t &);
+
+    static function_t get(std::size_t idx) {
+      static constexpr function_t table[] = {&write_value<us>...};
+      return table[idx];
+    }
+  };
+
+public:
+  void push_back(const variant_t & v) {
+    const std::size_t which = static_cast<std::size_t>(v.which());
+    if (m_run_length && which != m_run_tag) {
+      this->write_run(m_tags);
+      m_run_length = 0;
+    }
+    m_run_tag = which;
+    ++m_run_length;
+
+    write_table<mpl::count_t<num_types>>::get(which)(*this, v);
+    ++m_counts[which];
+    ++m_size;
+  }
+
+  std::size_t size() const noexcept { return m_size; }
+
+  void clear() { *this = columnar_writer{}; }
+
+  /***
+   * Append the values collected so far to `sink`.
+   */
+  template <typename Sink>
+  void write(Sink & sink) const {
+    // The last run is encoded on the side, so that more values may be added
+    unsigned char run[10];
+    detail::bounded_sink run_sink{run, sizeof(run)};
+    if (m_run_length) { this->write_run(run_sink); }
+
+    detail::put_varint(m_size, sink);
+    detail::put_varint(num_types, sink);
+    detail::put_varint(m_tags.size() + run_sink.size(), sink);
+    detail::put_bytes(m_tags.data(), m_tags.size(), sink);
+    detail::put_bytes(run, run_sink.size(), sink);
+    for (std::size_t i = 0; i < num_types; ++i) {
+      detail::put_varint(m_counts[i], sink);
+      detail::put_varint(m_columns[i].size(), sink);
+      detail::put_bytes(m_columns[i].data(), m_columns[i].size(), sink);
+    }
+  }
+};
+//]
+
+//[ strict_variant_columnar_reader
+template <typename V>
+class columnar_reader;
+
+template <typename... Ts>
+class columnar_reader<variant<Ts...>> {
+  static constexpr std::size_t num_types = sizeof...(Ts);
+  static constexpr unsigned tag_bits = detail::bit_width(num_types - 1);
+
+  struct column {
+    const unsigned char * data = nullptr;
+    std::size_t size = 0;
+    std::size_t count = 0;
+  };
+
+  column m_tags;
+  column m_columns[num_types];
+  std::size_t m_size = 0;
+
+  // The read position and state of each column, during a visit
+  struct cursor {
+    const unsigned char * pos[num_types];
+    const unsigned char * end[num_types];
+    std::tuple<typename column_traits<unwrap_type_t<Ts>>::state...> states;
+
+    explicit cursor(const column * columns) {
+      for (std::size_t i = 0; i < num_types; ++i) {
+        pos[i] = columns[i].data;
+        end[i] = columns[i].data + columns[i].size;
+      }
+    }
+
+    bool at_end() const noexcept {
+      for (std::size_t i = 0; i < num_types; ++i) {
+        if (pos[i] != end[i]) { return false; }
+      }
+      return true;
+    }
+  };
+
+  static bool read_run(byte_source & src, std::size_t & tag, std::size_t & length) noexcept {
+    std::uint64_t x;
+    if (!detail::get_varint(src, x)) { return false; }
+    tag = static_cast<std::size_t>(x & ((std::uint64_t{1} << tag_bits) - 1));
+    length = static_cast<std::size_t>(x >> tag_bits) + 1;
+    return tag < num_types;
+  }
+
+  static bool read_column(byte_source & src, column & c) noexcept {
+    std::uint64_t count, size;
+    if (!detail::get_varint(src, count) || !detail::get_varint(src, size)
+        || size > src.remaining()) {
+      return false;
+    }
+    c.count = static_cast<std::size_t>(count);
+    c.size = static_cast<std::size_t>(size);
+    c.data = src.take(c.size);
+    return true;
+  }
+
+  // Visit the next `n` values of column `idx`
+  template <unsigned idx, typename Visitor>
+  static bool visit_values(cursor & c, std::size_t n, Visitor & visitor) {
+    using T = unwrap_type_t<mpl::Index_At<mpl::TypeList<Ts...>, idx>>;
+    byte_source src{c.pos[idx], static_cast<std::size_t>(c.end[idx] - c.pos[idx])};
+    auto & state = std::get<idx>(c.states);
+    for (; n; --n) {
+      if (!column_traits<T>::read(src, state, visitor)) { return false; }
+    }
+    c.pos[idx] = src.pos;
+    return true;
+  }
+
+  template <typename Visitor, typename UL>
+  struct visit_table;
+
+  template <typename Visitor, unsigned... us>
+  struct visit_table<Visitor, mpl::ulist<us...>> {
+    using function_t = bool (*)(cursor &, std::size_t, Visitor &);
+
+    static function_t get(std::size_t idx) {
+      static constexpr function_t table[] = {&visit_values<us, Visitor>...};
+      return table[idx];
+    }
+  };
+
+  template <typename Visitor>
+  using visit_table_t = visit_table<Visitor, mpl::count_t<num_types>>;
+
+public:
+  /***
+   * Read the format from a buffer, which must outlive the reader. Checks the
+   * layout and the tag column; the values are checked as they are visited.
+   * Returns false if the buffer does not hold exactly one sequence, in which
+   * case the reader is empty.
+   */
+  bool assign(const void * data, std::size_t size) {
+    *this = columnar_reader{};
+    columnar_reader r;
+    byte_source src{data, size};
+
+    std::uint64_t count, types;
+    if (!detail::get_varint(src, count) || !detail::get_varint(src, types)
+        || types != num_types) {
+      return false;
+    }
+    r.m_size = static_cast<std::size_t>(count);
+
+    std::uint64_t tags_size;
+    if (!detail::get_varint(src, tags_size) || tags_size > src.remaining()) { return false; }
+    r.m_tags.size = static_cast<std::size_t>(tags_size);
+    r.m_tags.data = src.take(r.m_tags.size);
+    for (column & c : r.m_columns) {
+      if (!read_column(src, c)) { return false; }
+    }
+    if (src.remaining()) { return false; }
+
+    // The runs must add up to the number of values of each type
+    std::size_t counts[num_types] = {};
+    std::size_t total = 0;
+    byte_source tags{r.m_tags.data, r.m_tags.size};
+    while (tags.remaining()) {
+      std::size_t tag = 0, length = 0;
+      if (!read_run(tags, tag, length) || length > r.m_size - total) { return false; }
+      counts[tag] += length;
+      total += length;
+    }
+    if (total != r.m_size) { return false; }
+    for (std::size_t i = 0; i < num_types; ++i) {
+      if (counts[i] != r.m_columns[i].count) { return false; }
+    }
+
+    *this = r;
+    return true;
+  }
+
+  std::size_t size() const noexcept { return m_size; }
+  bool empty() const noexcept { return !m_size; }
+
+  // The number of values of type `which`
+  std::size_t column_size(std::size_t which) const noexcept { return m_columns[which].count; }
+
+  /***
+   * Visit the values in order. Returns false if a column is bad, in which case
+   * some of the values may have been visited.
+   */
+  template <typename Visitor>
+  bool for_each(Visitor && visitor) const {
+    cursor c{m_columns};
+    byte_source tags{m_tags.data, m_tags.size};
+    while (tags.remaining()) {
+      std::size_t tag = 0, length = 0;
+      if (!read_run(tags, tag, length) || !visit_table_t<Visitor>::get(tag)(c, length, visitor)) {
+        return false;
+      }
+    }
+    return c.at_end();
+  }
+
+  /***
+   * Visit all the values of the first type, and then of the second type, etc.
+   */
+  template <typename Visitor>
+  bool scan(Visitor && visitor) const {
+    cursor c{m_columns};
+    for (std::size_t i = 0; i < num_types; ++i) {
+      if (!visit_table_t<Visitor>::get(i)(c, m_columns[i].count, visitor)) { return false; }
+    }
+    return c.at_end();
+  }
+};
+//]
+
+} // end namespace strict_variant
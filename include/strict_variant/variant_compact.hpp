@@ -0,0 +1,98 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Compaction of trees of recursive variants whose nodes are `arena_wrapper`s.
+ *
+ * After many edits, the nodes of a tree are scattered over the blocks of its
+ * arena, and traversal is dominated by cache misses. `compact(tree)` makes a
+ * deep copy of the tree whose nodes are all in one block of memory, obtained
+ * with a single allocation, in depth-first order, which is the order in which
+ * visitors usually traverse it.
+ *
+ * The copy is made twice: once to measure the size of the block, in an arena
+ * which is then freed, and once into the block.
+ *
+ * Only nodes in `arena_wrapper<T>`, with the default `thread_arena`, are
+ * placed in the block. Nodes in other wrappers are copied as usual; a
+ * `recursive_wrapper` deletes each of its nodes separately, so they cannot
+ * share a block.
+ */
+
+#include <strict_variant/arena_wrapper.hpp>
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace strict_variant {
+
+//[ strict_variant_compact_tree
+/***
+ * Owns a copy of a tree, of variant type `V`, and the block holding its
+ * nodes. Like a tree of `arena_wrapper`s, the nodes are not destroyed.
+ */
+template <typename V>
+class compact_tree {
+  bump_arena m_arena;
+  V * m_root;
+
+  // In case the block is aligned differently from that of the measurement
+  static constexpr std::size_t slack = 4 * alignof(std::max_align_t);
+
+  // The root is put in the arena too, since moving a variant would copy the
+  // nodes again
+  static V * copy_into(bump_arena & arena, const V & tree) {
+    arena_scope scope{arena};
+    return new (arena.allocate(sizeof(V), alignof(V))) V(tree);
+  }
+
+  static std::size_t measure(const V & tree) {
+    bump_arena arena;
+    copy_into(arena, tree)->~V();
+    return arena.bytes_spanned();
+  }
+
+public:
+  explicit compact_tree(const V & tree)
+    : m_arena()
+    , m_root(nullptr) {
+    m_arena.reserve(measure(tree) + slack);
+    m_root = copy_into(m_arena, tree);
+  }
+
+  compact_tree(compact_tree && other) noexcept //
+    : m_arena(std::move(other.m_arena))
+    , m_root(other.m_root) //
+  {
+    other.m_root = nullptr;
+  }
+
+  compact_tree(const compact_tree &) = delete;
+  compact_tree & operator=(const compact_tree &) = delete;
+  compact_tree & operator=(compact_tree &&) = delete;
+
+  ~compact_tree() noexcept {
+    if (m_root) { m_root->~V(); }
+  }
+
+  const V & get() const noexcept { return *m_root; }
+
+  // The number of bytes used in the block
+  std::size_t bytes_used() const noexcept { return m_arena.bytes_spanned(); }
+};
+//]
+
+//[ strict_variant_compact
+template <typename V>
+compact_tree<V>
+compact(const V & tree) {
+  return compact_tree<V>{tree};
+}
+//]
+
+} // end namespace strict_variant
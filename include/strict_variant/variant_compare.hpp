@@ -37,40 +37,76 @@ struct variant_comparator;
 
 namespace strict_variant {
 
+namespace detail {
+
+// Visitors applied to a `value_pair`, using the paired dispatch of variant.
+template <template <typename> class ComparatorTemplate>
+struct paired_comparator {
+  typedef bool result_type;
+
+  template <typename T>
+  bool operator()(const value_pair<T> & p) const {
+    ComparatorTemplate<mpl::remove_const_t<T>> c;
+    return c(p.first, p.second);
+  }
+};
+
+struct paired_less {
+  typedef bool result_type;
+
+  template <typename T>
+  bool operator()(const value_pair<T> & p) const {
+    return p.first < p.second;
+  }
+};
+
+struct paired_three_way {
+  typedef int result_type;
+
+  template <typename T>
+  int operator()(const value_pair<T> & p) const {
+    return (p.first < p.second) ? -1 : ((p.second < p.first) ? 1 : 0);
+  }
+};
+
+} // end namespace detail
+
 template <typename... types, template <typename> class ComparatorTemplate,
           typename WhichComparator_t>
 struct variant_comparator<variant<types...>, ComparatorTemplate, WhichComparator_t> {
 
   typedef variant<types...> var_t;
 
-  struct helper {
-
-    const var_t & first;
-    const var_t & other;
-
-    explicit helper(const var_t & _f, const var_t & _o)
-      : first(_f)
-      , other(_o) {}
-
-    template <typename T>
-    bool operator()(const T & t) const {
-      if (const T * o = strict_variant::get<T>(&other)) {
-        ComparatorTemplate<T> c;
-        return c(t, *o);
-      } else {
-        static_assert(std::is_same<int, decltype(first.which())>::value,
-                      "The return type of 'variant::which' was changed and "
-                      "variant_compare was not updated");
-        WhichComparator_t c;
-        return c(first.which(), other.which());
-      }
-    }
-  };
-
   bool operator()(const var_t & v1, const var_t & v2) const {
-    helper h{v1, v2};
-    return strict_variant::apply_visitor(h, v1);
+    static_assert(std::is_same<int, decltype(v1.which())>::value,
+                  "The return type of 'variant::which' was changed and "
+                  "variant_compare was not updated");
+    if (v1.which() != v2.which()) {
+      WhichComparator_t c;
+      return c(v1.which(), v2.which());
+    }
+    return var_t::apply_paired_visitor_impl(detail::paired_comparator<ComparatorTemplate>{}, v1,
+                                            v2);
   }
 };
 
+/***
+ * Three-way comparison.
+ *
+ * This uses the same ordering as the default `variant_comparator`, but uses
+ * `operator <` of the value types rather than `std::less`.
+ * After comparing `which`, it makes exactly one dispatch.
+ */
+
+//[ strict_variant_compare_three_way
+/// Returns a negative number, zero, or a positive number, if `lhs` is less than,
+/// equivalent to, or greater than `rhs`.
+template <typename First, typename... Types>
+inline int
+compare_three_way(const variant<First, Types...> & lhs, const variant<First, Types...> & rhs) {
+  if (lhs.which() != rhs.which()) { return (lhs.which() < rhs.which()) ? -1 : 1; }
+  return variant<First, Types...>::apply_paired_visitor_impl(detail::paired_three_way{}, lhs, rhs);
+}
+//]
+
 } // end namespace strict_variant
@@ -32,6 +32,36 @@
 
 #endif // STRICT_VARIANT_DEBUG
 
+// STRICT_VARIANT_DISPATCH_ASSUME states an invariant to the optimizer, when
+// STRICT_VARIANT_OPTIMIZER_HINTS is defined. In debug mode it is an assertion.
+#if defined(STRICT_VARIANT_DEBUG)
+
+#define STRICT_VARIANT_DISPATCH_ASSUME(X) STRICT_VARIANT_ASSERT(X)
+
+#elif defined(STRICT_VARIANT_OPTIMIZER_HINTS) && defined(__clang__)
+
+#define STRICT_VARIANT_DISPATCH_ASSUME(X) __builtin_assume((X))
+
+#elif defined(STRICT_VARIANT_OPTIMIZER_HINTS) && defined(__GNUC__)
+
+#define STRICT_VARIANT_DISPATCH_ASSUME(X)                                                          \
+  do {                                                                                             \
+    if (!(X)) { __builtin_unreachable(); }                                                         \
+  } while (0)
+
+#elif defined(STRICT_VARIANT_OPTIMIZER_HINTS) && defined(_MSC_VER)
+
+#define STRICT_VARIANT_DISPATCH_ASSUME(X) __assume((X))
+
+#else
+
+#define STRICT_VARIANT_DISPATCH_ASSUME(X)                                                          \
+  do {                                                                                             \
+    static_cast<void>(X);                                                                          \
+  } while (0)
+
+#endif
+
 namespace strict_variant {
 
 namespace detail {
@@ -111,7 +141,7 @@ struct jumptable_dispatch<return_t, Internal, mpl::ulist<Indices...>> {
     static whichCaller callers[sizeof...(Indices)] = {
       &visitor_caller<Indices, Internal, Storage, Visitor>...};
 
-    STRICT_VARIANT_ASSERT(which < static_cast<unsigned int>(sizeof...(Indices)));
+    STRICT_VARIANT_DISPATCH_ASSUME(which < static_cast<unsigned int>(sizeof...(Indices)));
 
     return (*callers[which])(std::forward<Storage>(storage), std::forward<Visitor>(visitor));
   }
@@ -153,7 +183,7 @@ template <typename return_t, typename Internal, unsigned int base>
 struct binary_search_dispatch<return_t, Internal, base, 1u> {
   template <typename Storage, typename Visitor>
   return_t operator()(const unsigned int which, Storage && storage, Visitor && visitor) {
-    STRICT_VARIANT_ASSERT(which == base);
+    STRICT_VARIANT_DISPATCH_ASSUME(which == base);
 
     return visitor_caller<base, Internal, Storage, Visitor>(std::forward<Storage>(storage),
                                                             std::forward<Visitor>(visitor));
@@ -213,6 +243,8 @@ struct visitor_dispatch {
 
     using chosen_dispatch_t = binary_search_dispatch<return_t, Internal, 0, num_types>;
 
+    STRICT_VARIANT_DISPATCH_ASSUME(which < num_types);
+
     return chosen_dispatch_t{}(which, std::forward<Storage>(storage),
                                std::forward<Visitor>(visitor));
   }
@@ -223,3 +255,4 @@ struct visitor_dispatch {
 } // end namespace strict_variant
 
 #undef STRICT_VARIANT_ASSERT
+#undef STRICT_VARIANT_DISPATCH_ASSUME
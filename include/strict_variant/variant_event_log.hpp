@@ -0,0 +1,354 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * An append-only log of variants, in memory-mapped segment files. (POSIX only.)
+ *
+ * The log is a directory of segments named `00000000000000000000.log`,
+ * `00000000000000000001.log`, ..., each of `segment_size` bytes. Each record
+ * is a 4-byte length (in the byte order of the host) and the variant in the
+ * format of `serialize`. A length of zero marks the end of the records, and
+ * is written after each record. When a record does not fit in the rest of a
+ * segment, the next segment is started.
+ *
+ * `event_log_writer<V>` serializes records straight into the mapping. They are
+ * made durable by `commit()`, which calls `msync` on the pages written since
+ * the last commit, or `fdatasync`. After a new segment is created, `commit()`
+ * also calls `fdatasync` on it and `fsync` on the directory, so that the
+ * file itself survives a crash. With `commit_every = n`, this is done
+ * after every `n` records, so that the cost is shared by a group of records.
+ * Segments are allocated in full when they are created, so a full disk is
+ * reported as an error rather than a crash.
+ *
+ * When an existing log is opened, records are appended after the last valid
+ * record. Records are not checksummed, so a torn write at a crash is only
+ * detected if it does not parse.
+ *
+ * `replay_event_log<V>(dir, visitor)` maps each segment and applies the visitor
+ * to a `variant_view` of each record, without copying or deserializing it.
+ *
+ * Errors are reported as a `false` return value, and `last_error()`.
+ */
+
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_serialize.hpp>
+#include <strict_variant/variant_view.hpp>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace strict_variant {
+
+//[ strict_variant_event_log_options
+enum class event_log_sync { msync, fdatasync };
+
+struct event_log_options {
+  // The size of each segment file, rounded up to a multiple of the page size
+  std::size_t segment_size = std::size_t{64} << 20;
+  // Commit after this many records, or only when `commit()` is called if 0
+  std::size_t commit_every = 0;
+  event_log_sync sync = event_log_sync::msync;
+};
+//]
+
+namespace detail {
+
+inline std::error_code
+errno_code() noexcept {
+  return std::error_code{errno, std::generic_category()};
+}
+
+// Make the entries of a directory durable. Returns false, with errno set, on
+// failure.
+inline bool
+sync_dir(const std::string & dir) noexcept {
+  const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0) { return false; }
+  const bool ok = ::fsync(fd) == 0;
+  const int e = errno;
+  ::close(fd);
+  errno = e;
+  return ok;
+}
+
+inline std::size_t
+page_size() noexcept {
+  static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+inline std::string
+segment_path(const std::string & dir, std::size_t index) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%020lu.log", static_cast<unsigned long>(index));
+  return dir + "/" + name;
+}
+
+// An open file, mapped in full
+class mapped_file {
+  int m_fd = -1;
+  unsigned char * m_data = nullptr;
+  std::size_t m_size = 0;
+
+public:
+  mapped_file() = default;
+  mapped_file(const mapped_file &) = delete;
+  mapped_file & operator=(const mapped_file &) = delete;
+  ~mapped_file() noexcept { this->close(); }
+
+  int fd() const noexcept { return m_fd; }
+  unsigned char * data() const noexcept { return m_data; }
+  std::size_t size() const noexcept { return m_size; }
+
+  // Open for reading, or for writing, in which case the file is created if
+  // need be, and extended to at least `min_size`. The blocks are allocated,
+  // so that a lack of space is reported here, rather than by SIGBUS when the
+  // mapping is written. Returns false, with errno set, on failure.
+  bool open(const std::string & path, bool writable, std::size_t min_size = 0) noexcept {
+    this->close();
+    m_fd = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+    if (m_fd < 0) { return false; }
+
+    struct stat st;
+    if (::fstat(m_fd, &st) != 0) { return this->fail(); }
+    m_size = static_cast<std::size_t>(st.st_size);
+    if (writable && m_size < min_size) {
+      if (const int e = ::posix_fallocate(m_fd, 0, static_cast<off_t>(min_size))) {
+        errno = e;
+        return this->fail();
+      }
+      m_size = min_size;
+    }
+    if (!m_size) { return true; }
+
+    const int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void * p = ::mmap(nullptr, m_size, prot, MAP_SHARED, m_fd, 0);
+    if (p == MAP_FAILED) { return this->fail(); }
+    m_data = static_cast<unsigned char *>(p);
+    return true;
+  }
+
+  void close() noexcept {
+    if (m_data) { ::munmap(m_data, m_size); }
+    if (m_fd >= 0) { ::close(m_fd); }
+    m_fd = -1;
+    m_data = nullptr;
+    m_size = 0;
+  }
+
+private:
+  // Close, keeping errno
+  bool fail() noexcept {
+    const int e = errno;
+    this->close();
+    errno = e;
+    return false;
+  }
+};
+
+static constexpr std::size_t event_header_size = 4;
+
+// Find the end of the valid records in a segment
+template <typename V>
+std::size_t
+scan_segment(const unsigned char * data, std::size_t size) {
+  std::size_t pos = 0;
+  while (size - pos > event_header_size) {
+    std::uint32_t length;
+    std::memcpy(&length, data + pos, event_header_size);
+    if (!length || length > size - pos - event_header_size) { break; }
+
+    byte_source src{data + pos + event_header_size, length};
+    if (!view_traits<V>::skip(src) || src.remaining()) { break; }
+    pos += event_header_size + length;
+  }
+  return pos;
+}
+
+} // end namespace detail
+
+//[ strict_variant_event_log_writer
+template <typename V>
+class event_log_writer {
+  event_log_options m_options;
+  std::string m_dir;
+  detail::mapped_file m_file;
+  std::size_t m_segment = 0;
+  // Write position, and the start of the records which are not committed
+  std::size_t m_pos = 0;
+  std::size_t m_committed = 0;
+  std::size_t m_pending = 0;
+  // A new segment's size, and its directory entry, must also be made durable
+  bool m_new_segment = false;
+  std::error_code m_error;
+
+  bool fail() {
+    m_error = detail::errno_code();
+    return false;
+  }
+
+  bool open_segment(std::size_t index) {
+    const std::string path = detail::segment_path(m_dir, index);
+    m_new_segment = ::access(path.c_str(), F_OK) != 0;
+    if (!m_file.open(path, true, m_options.segment_size)) { return this->fail(); }
+    m_segment = index;
+    m_pos = m_committed = detail::scan_segment<V>(m_file.data(), m_file.size());
+    return true;
+  }
+
+public:
+  explicit event_log_writer(event_log_options options = event_log_options{})
+    : m_options(options) {
+    const std::size_t page = detail::page_size();
+    m_options.segment_size = (m_options.segment_size + page - 1) / page * page;
+  }
+
+  event_log_writer(const event_log_writer &) = delete;
+  event_log_writer & operator=(const event_log_writer &) = delete;
+
+  ~event_log_writer() noexcept { this->close(); }
+
+  /***
+   * Open the log in `dir`, which must exist, creating it if it is empty, or
+   * else continuing after the last record of the last segment.
+   */
+  bool open(const std::string & dir) {
+    this->close();
+    m_dir = dir;
+    m_error = std::error_code{};
+
+    std::size_t last = 0;
+    while (::access(detail::segment_path(dir, last + 1).c_str(), F_OK) == 0) {
+      ++last;
+    }
+    return this->open_segment(last);
+  }
+
+  /***
+   * Append a record. Returns false if it could not be written, because of an
+   * error, or because it is larger than a segment.
+   */
+  bool append(const V & v) {
+    if (!m_file.data()) {
+      m_error = std::make_error_code(std::errc::bad_file_descriptor);
+      return false;
+    }
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+      if (m_file.size() - m_pos > detail::event_header_size) {
+        unsigned char * p = m_file.data() + m_pos;
+        detail::bounded_sink sink{p + detail::event_header_size,
+                                  m_file.size() - m_pos - detail::event_header_size};
+        serialize(v, sink);
+        if (!sink.overflow()) {
+          const std::uint32_t length = static_cast<std::uint32_t>(sink.size());
+          m_pos += detail::event_header_size + length;
+          // The end marker. What follows the last record may not be zero, if a
+          // write failed here, or the segment was not closed cleanly.
+          if (m_file.size() - m_pos >= detail::event_header_size) {
+            std::memset(m_file.data() + m_pos, 0, detail::event_header_size);
+          }
+          std::memcpy(p, &length, detail::event_header_size);
+          if (m_options.commit_every && ++m_pending >= m_options.commit_every) {
+            return this->commit();
+          }
+          return true;
+        }
+      }
+      if (attempt || m_pos == 0) { break; }
+      if (!this->commit() || !this->open_segment(m_segment + 1)) { return false; }
+    }
+    m_error = std::make_error_code(std::errc::value_too_large);
+    return false;
+  }
+
+  /***
+   * Make the records appended so far durable.
+   */
+  bool commit() {
+    if (!m_file.data() || (m_pos == m_committed && !m_new_segment)) { return true; }
+
+    if (m_options.sync == event_log_sync::msync) {
+      const std::size_t start = m_committed / detail::page_size() * detail::page_size();
+      if (::msync(m_file.data() + start, m_pos - start, MS_SYNC) != 0) { return this->fail(); }
+    }
+    if (m_options.sync == event_log_sync::fdatasync || m_new_segment) {
+      if (::fdatasync(m_file.fd()) != 0) { return this->fail(); }
+    }
+    if (m_new_segment && !detail::sync_dir(m_dir)) { return this->fail(); }
+    m_committed = m_pos;
+    m_pending = 0;
+    m_new_segment = false;
+    return true;
+  }
+
+  /***
+   * Commit, and close the log.
+   */
+  bool close() {
+    const bool ok = this->commit();
+    m_file.close();
+    return ok;
+  }
+
+  std::error_code last_error() const noexcept { return m_error; }
+
+  // The index of the segment being written
+  std::size_t segment() const noexcept { return m_segment; }
+};
+//]
+
+//[ strict_variant_replay_event_log
+/***
+ * Apply `visitor` to a `variant_view` of each record in the log in `dir`, in
+ * order. Returns the number of records, and sets `ec` if a segment could not
+ * be read.
+ */
+template <typename V, typename Visitor>
+std::size_t
+replay_event_log(const std::string & dir, Visitor && visitor, std::error_code & ec) {
+  ec = std::error_code{};
+  std::size_t count = 0;
+  detail::mapped_file file;
+
+  for (std::size_t index = 0;; ++index) {
+    if (!file.open(detail::segment_path(dir, index), false)) {
+      if (errno != ENOENT || index == 0) { ec = detail::errno_code(); }
+      return count;
+    }
+
+    const unsigned char * data = file.data();
+    const std::size_t size = file.size();
+    std::size_t pos = 0;
+    while (size - pos > detail::event_header_size) {
+      std::uint32_t length;
+      std::memcpy(&length, data + pos, detail::event_header_size);
+      if (!length || length > size - pos - detail::event_header_size) { break; }
+
+      byte_source src{data + pos + detail::event_header_size, length};
+      byte_source check = src;
+      if (!view_traits<V>::skip(check) || check.remaining()) { break; }
+      strict_variant::apply_visitor(visitor, view_traits<V>::view(src));
+      pos += detail::event_header_size + length;
+      ++count;
+    }
+  }
+}
+//]
+
+} // end namespace strict_variant
@@ -0,0 +1,311 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A logger for variant-valued events, which defers formatting.
+ *
+ * `variant_logger<V>::log(v)` is meant for latency-critical threads. It only
+ * writes `v` in the format of `serialize` into a ring buffer belonging to the
+ * calling thread: the tag, then the raw bytes of a trivially copyable value, or
+ * the serialized form of other values. Nothing is formatted, locked or
+ * allocated, except when a thread logs for the first time. If the ring buffer
+ * is full, the event is dropped and counted.
+ *
+ * `drain(value, visitor)`, called by a background thread, deserializes each
+ * pending record into `value` and applies `visitor` to it, such as
+ * `printer_visitor`. The records of one thread are in order, but there is no
+ * order between threads.
+ *
+ * `log_ring` is the single-producer single-consumer ring buffer which is used
+ * for each thread. It may also be used directly, for instance to copy the
+ * records elsewhere and decode them offline with `deserialize`.
+ */
+
+#include <strict_variant/concurrency.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_serialize.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+//[ strict_variant_log_ring
+/***
+ * A lock-free ring buffer of serialized variants, for one producer thread and
+ * one consumer thread.
+ *
+ * Each record is a 4-byte length and the serialized value, padded to a
+ * multiple of 4 bytes. A record is never split at the end of the buffer.
+ */
+class log_ring {
+  static constexpr std::uint32_t header_size = 4;
+  // A header which means that the rest of the buffer is unused
+  static constexpr std::uint32_t skip = 0xffffffffu;
+
+  std::size_t m_capacity;
+  std::unique_ptr<unsigned char[]> m_buffer;
+
+  // Written by the producer
+  struct producer_state {
+    char pad[detail::cache_line_size];
+    std::atomic<std::size_t> head{0};
+    std::size_t cached_tail = 0;
+    std::atomic<std::size_t> dropped{0};
+  } m_producer;
+
+  // Written by the consumer
+  struct consumer_state {
+    char pad[detail::cache_line_size];
+    std::atomic<std::size_t> tail{0};
+    char pad_end[detail::cache_line_size];
+  } m_consumer;
+
+  static constexpr std::size_t padded(std::size_t n) noexcept { return (n + 3) & ~std::size_t{3}; }
+
+  unsigned char * at(std::size_t pos) const noexcept {
+    return m_buffer.get() + (pos & (m_capacity - 1));
+  }
+
+  static std::size_t round_capacity(std::size_t n) noexcept {
+    std::size_t result = 64;
+    while (result < n && result < (std::size_t{1} << 31)) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  // Find `n` contiguous free bytes at `start`, or else at the beginning of the
+  // buffer, in which case `start` is moved there.
+  bool reserve(std::size_t & start, std::size_t n) noexcept {
+    const std::size_t contiguous = m_capacity - (start & (m_capacity - 1));
+    const std::size_t needed = contiguous < n ? contiguous + n : n;
+    if (m_capacity - (start - m_producer.cached_tail) < needed) {
+      m_producer.cached_tail = m_consumer.tail.load(std::memory_order_acquire);
+      if (m_capacity - (start - m_producer.cached_tail) < needed) { return false; }
+    }
+    if (contiguous < n) {
+      const std::uint32_t marker = skip;
+      std::memcpy(this->at(start), &marker, header_size);
+      start += contiguous;
+    }
+    return true;
+  }
+
+  void count_dropped() noexcept {
+    // Only the producer writes the count, so it need not be a locked add
+    const std::size_t dropped = m_producer.dropped.load(std::memory_order_relaxed);
+    m_producer.dropped.store(dropped + 1, std::memory_order_relaxed);
+  }
+
+  // If each value type is trivially copyable, the tag and all of the storage
+  // are copied, without a dispatch. The length in the header is that of the
+  // serialized form, which is a prefix of this.
+  template <typename... Ts>
+  bool push_impl(const variant<Ts...> & v, std::true_type) {
+    using var_t = variant<Ts...>;
+    static constexpr std::uint32_t sizes[] = {
+      static_cast<std::uint32_t>(1 + sizeof(unwrap_type_t<Ts>))...};
+
+    std::size_t start = m_producer.head.load(std::memory_order_relaxed);
+    if (!this->reserve(start, header_size + padded(1 + var_t::storage_size))) {
+      this->count_dropped();
+      return false;
+    }
+
+    unsigned char * p = this->at(start);
+    const unsigned which = static_cast<unsigned>(v.which());
+    const std::uint32_t size = sizes[which];
+    std::memcpy(p, &size, header_size);
+    p[header_size] = static_cast<unsigned char>(which);
+    std::memcpy(p + header_size + 1, var_t::storage_address_impl(v), var_t::storage_size);
+    m_producer.head.store(start + header_size + padded(size), std::memory_order_release);
+    return true;
+  }
+
+  template <typename... Ts>
+  bool push_impl(const variant<Ts...> & v, std::false_type) {
+    std::size_t start = m_producer.head.load(std::memory_order_relaxed);
+    bool refreshed = false;
+    bool wrapped = false;
+
+    // The size is not known until the value is written, so it is written
+    // into the free space before the end of the buffer. If that fails, the
+    // consumer's position is reloaded, and then the buffer is wrapped.
+    for (;;) {
+      const std::size_t contiguous = m_capacity - (start & (m_capacity - 1));
+      const std::size_t free = m_capacity - (start - m_producer.cached_tail);
+      const std::size_t room = free < contiguous ? free : contiguous;
+
+      if (room > header_size) {
+        detail::bounded_sink sink{this->at(start) + header_size, room - header_size};
+        serialize(v, sink);
+        if (!sink.overflow()) {
+          const std::uint32_t size = static_cast<std::uint32_t>(sink.size());
+          std::memcpy(this->at(start), &size, header_size);
+          m_producer.head.store(start + header_size + padded(size), std::memory_order_release);
+          return true;
+        }
+      }
+
+      if (!refreshed) {
+        m_producer.cached_tail = m_consumer.tail.load(std::memory_order_acquire);
+        refreshed = true;
+      } else if (!wrapped && contiguous < m_capacity - (start - m_producer.cached_tail)) {
+        const std::uint32_t marker = skip;
+        std::memcpy(this->at(start), &marker, header_size);
+        start += contiguous;
+        wrapped = true;
+      } else {
+        this->count_dropped();
+        return false;
+      }
+    }
+  }
+
+public:
+  // The capacity in bytes is rounded up to a power of two, at most 2^31.
+  // The buffer is zeroed, so that its pages are not first touched by `push`.
+  explicit log_ring(std::size_t capacity)
+    : m_capacity(round_capacity(capacity))
+    , m_buffer(new unsigned char[m_capacity]()) {}
+
+  log_ring(const log_ring &) = delete;
+  log_ring & operator=(const log_ring &) = delete;
+
+  std::size_t capacity() const noexcept { return m_capacity; }
+
+  // The number of records which did not fit
+  std::size_t dropped() const noexcept {
+    return m_producer.dropped.load(std::memory_order_relaxed);
+  }
+
+  /***
+   * Producer: append a serialized variant. Returns false if there was not
+   * room, in which case nothing is recorded.
+   */
+  template <typename... Ts>
+  bool push(const variant<Ts...> & v) {
+    using fast_t = std::integral_constant<bool, variant<Ts...>::trivially_copyable_storage
+                                                  && sizeof...(Ts) <= 256>;
+    return this->push_impl(v, fast_t{});
+  }
+
+  /***
+   * Consumer: call `f(byte_source &)` for each pending record, in order.
+   * Returns the number of records.
+   */
+  template <typename F>
+  std::size_t consume(F && f) {
+    std::size_t tail = m_consumer.tail.load(std::memory_order_relaxed);
+    const std::size_t head = m_producer.head.load(std::memory_order_acquire);
+    std::size_t count = 0;
+
+    while (tail != head) {
+      std::uint32_t size;
+      std::memcpy(&size, this->at(tail), header_size);
+      if (size == skip) {
+        tail += m_capacity - (tail & (m_capacity - 1));
+      } else {
+        byte_source src{this->at(tail) + header_size, size};
+        f(src);
+        tail += header_size + padded(size);
+        ++count;
+      }
+      m_consumer.tail.store(tail, std::memory_order_release);
+    }
+    return count;
+  }
+};
+//]
+
+//[ strict_variant_variant_logger
+template <typename V>
+class variant_logger {
+  std::size_t m_id;
+  std::size_t m_ring_capacity;
+
+  std::mutex m_mutex;
+  std::vector<std::unique_ptr<log_ring>> m_rings;
+
+  // Loggers are identified by a number, not their address, so that a thread
+  // does not find the ring of a logger which was destroyed
+  static std::size_t next_id() noexcept {
+    static std::atomic<std::size_t> counter{0};
+    return ++counter;
+  }
+
+  struct ring_entry {
+    std::size_t id;
+    log_ring * ring;
+  };
+
+  log_ring & local_ring() {
+    static thread_local std::vector<ring_entry> entries;
+    for (const ring_entry & e : entries) {
+      if (e.id == m_id) { return *e.ring; }
+    }
+
+    std::unique_ptr<log_ring> ring{new log_ring{m_ring_capacity}};
+    log_ring * result = ring.get();
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_rings.push_back(std::move(ring));
+    }
+    entries.push_back(ring_entry{m_id, result});
+    return *result;
+  }
+
+public:
+  // Each thread which logs gets a ring buffer of `ring_capacity` bytes
+  explicit variant_logger(std::size_t ring_capacity = std::size_t{1} << 16)
+    : m_id(next_id())
+    , m_ring_capacity(ring_capacity) {}
+
+  variant_logger(const variant_logger &) = delete;
+  variant_logger & operator=(const variant_logger &) = delete;
+
+  /***
+   * Record an event. Returns false if it was dropped.
+   */
+  bool log(const V & v) { return this->local_ring().push(v); }
+
+  /***
+   * Deserialize each pending record into `value`, and apply `visitor` to it.
+   * Returns the number of records. May be called by one thread at a time.
+   */
+  template <typename Visitor>
+  std::size_t drain(V & value, Visitor && visitor) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    std::size_t count = 0;
+    for (const auto & ring : m_rings) {
+      count += ring->consume([&](byte_source & src) {
+        if (deserialize(src, value)) { strict_variant::apply_visitor(visitor, value); }
+      });
+    }
+    return count;
+  }
+
+  // The number of events which were dropped
+  std::size_t dropped() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    std::size_t count = 0;
+    for (const auto & ring : m_rings) {
+      count += ring->dropped();
+    }
+    return count;
+  }
+};
+//]
+
+} // end namespace strict_variant
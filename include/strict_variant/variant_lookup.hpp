@@ -0,0 +1,258 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Transparent hash, equality and comparator objects for variant types.
+ *
+ * These support heterogeneous lookup in associative containers keyed by a
+ * variant, so that a key may be looked up without constructing a temporary
+ * variant (and possibly making a dynamic allocation).
+ *
+ * A lookup key may be:
+ * - One of the value types of the variant, modulo `const` and `recursive_wrapper`.
+ * - `const char *`, or (at C++17) `std::string_view`, if one of the value types
+ *   is `std::string`.
+ *
+ * The results are the same as if the key were first placed in the variant, as
+ * that value type. Other key types are a compile-time error.
+ *
+ * Note: Heterogeneous lookup requires C++14 for `std::map` and `std::set`, and
+ * C++20 for the unordered containers.
+ */
+
+#include <strict_variant/mpl/find_with.hpp>
+#include <strict_variant/mpl/std_traits.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_compare.hpp>
+#include <strict_variant/variant_detail.hpp>
+#include <strict_variant/variant_hash.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <type_traits>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace strict_variant {
+
+namespace detail {
+
+/***
+ * Trait which detects string-like key types, which may be looked up against
+ * a `std::string` value type.
+ */
+template <typename K>
+struct is_string_key
+  : std::integral_constant<bool, std::is_same<K, const char *>::value> {};
+
+#if __cplusplus >= 201703L
+template <>
+struct is_string_key<std::string_view> : std::true_type {};
+#endif
+
+/***
+ * Maps a key type to the index of the corresponding value type in a variant.
+ * `value` is the index, `type` is the value type (without wrapper).
+ */
+template <typename V, typename K, typename ENABLE = void>
+struct lookup_slot;
+
+template <typename K, typename... Ts>
+struct lookup_slot<variant<Ts...>, K, mpl::enable_if_t<!is_string_key<K>::value>> {
+  static constexpr std::size_t value =
+    mpl::Find_With<same_modulo_const_ref_wrapper<K>::template prop, Ts...>::value;
+  static_assert(value < sizeof...(Ts),
+                "Lookup key type is not one of the value types of the variant. Construct a "
+                "variant instead.");
+
+  using type = K;
+};
+
+template <typename K, typename... Ts>
+struct lookup_slot<variant<Ts...>, K, mpl::enable_if_t<is_string_key<K>::value>> {
+  static constexpr std::size_t value =
+    mpl::Find_With<same_modulo_const_ref_wrapper<std::string>::template prop, Ts...>::value;
+  static_assert(value < sizeof...(Ts),
+                "String lookup keys require std::string to be one of the value types of the "
+                "variant.");
+
+  using type = std::string;
+};
+
+// Key type used for a lookup argument. String literals and `char *` are looked
+// up as `const char *`.
+template <typename K>
+using lookup_key_t =
+  typename std::conditional<std::is_same<mpl::decay_t<K>, char *>::value, const char *,
+                            mpl::remove_const_t<mpl::decay_t<K>>>::type;
+
+// Compare a value of the variant with a key, three-way.
+// String-like keys are compared using `std::string::compare` if the comparator
+// is `std::less`, which agrees with it, so that no temporary string is needed.
+// Other comparators are passed a temporary string.
+template <template <typename> class ComparatorTemplate, typename T, typename K>
+inline int
+lookup_compare(const T & value, const K & key, std::false_type) {
+  ComparatorTemplate<T> c;
+  return c(value, key) ? -1 : (c(key, value) ? 1 : 0);
+}
+
+template <template <typename> class ComparatorTemplate, typename K>
+inline int
+lookup_string_compare(const std::string & value, const K & key, std::true_type) {
+  return value.compare(key);
+}
+
+template <template <typename> class ComparatorTemplate, typename K>
+inline int
+lookup_string_compare(const std::string & value, const K & key, std::false_type) {
+  return lookup_compare<ComparatorTemplate>(value, std::string{key}, std::false_type{});
+}
+
+template <template <typename> class ComparatorTemplate, typename K>
+inline int
+lookup_compare(const std::string & value, const K & key, std::true_type) {
+  return lookup_string_compare<ComparatorTemplate>(
+    value, key, std::is_same<ComparatorTemplate<std::string>, std::less<std::string>>{});
+}
+
+// Hash a key, as the corresponding value type would be hashed.
+// String-like keys are hashed as `std::string_view`, whose hash is required to
+// be the same as `std::string`. So this is only available at C++17.
+template <template <typename> class HasherTemplate, typename K>
+inline std::size_t
+lookup_hash(const K & key, std::false_type) {
+  return HasherTemplate<K>{}(key);
+}
+
+#if __cplusplus >= 201703L
+template <template <typename> class HasherTemplate, typename K>
+inline std::size_t
+lookup_hash(const K & key, std::true_type) {
+  return HasherTemplate<std::string_view>{}(std::string_view{key});
+}
+#else
+template <template <typename> class HasherTemplate, typename K>
+inline std::size_t
+lookup_hash(const K &, std::true_type) {
+  static_assert(!is_string_key<K>::value,
+                "Hashing a string lookup key without a temporary string requires C++17.");
+  return 0;
+}
+#endif
+
+} // end namespace detail
+
+//[ strict_variant_transparent_variant_hash
+/***
+ * Transparent hasher, gives the same results as `variant_hash`.
+ */
+template <typename T, template <typename> class HasherTemplate = std::hash>
+struct transparent_variant_hash;
+
+template <typename... Ts, template <typename> class HasherTemplate>
+struct transparent_variant_hash<variant<Ts...>, HasherTemplate> {
+  using var_t = variant<Ts...>;
+  using is_transparent = void;
+
+  std::size_t operator()(const var_t & v) const {
+    return variant_hash<var_t, HasherTemplate>{}(v);
+  }
+
+  template <typename K, typename = mpl::enable_if_t<!is_variant<mpl::decay_t<K>>::value>>
+  std::size_t operator()(const K & k) const {
+    using key_t = detail::lookup_key_t<K>;
+    using slot = detail::lookup_slot<var_t, key_t>;
+    return detail::hash_mixer<>::mix(
+      detail::lookup_hash<HasherTemplate>(static_cast<const key_t &>(k),
+                                          detail::is_string_key<key_t>{}),
+      static_cast<unsigned>(slot::value));
+  }
+};
+//]
+
+//[ strict_variant_transparent_variant_equal
+/***
+ * Transparent equality comparison, gives the same results as `operator ==`.
+ */
+template <typename T>
+struct transparent_variant_equal;
+
+template <typename... Ts>
+struct transparent_variant_equal<variant<Ts...>> {
+  using var_t = variant<Ts...>;
+  using is_transparent = void;
+
+  bool operator()(const var_t & a, const var_t & b) const { return a == b; }
+
+  template <typename K, typename = mpl::enable_if_t<!is_variant<mpl::decay_t<K>>::value>>
+  bool operator()(const var_t & v, const K & k) const {
+    using key_t = detail::lookup_key_t<K>;
+    using slot = detail::lookup_slot<var_t, key_t>;
+    if (v.which() != static_cast<int>(slot::value)) { return false; }
+    return v.template get_unchecked<slot::value>() == static_cast<const key_t &>(k);
+  }
+
+  template <typename K, typename = mpl::enable_if_t<!is_variant<mpl::decay_t<K>>::value>>
+  bool operator()(const K & k, const var_t & v) const {
+    return (*this)(v, k);
+  }
+};
+//]
+
+//[ strict_variant_transparent_variant_comparator
+/***
+ * Transparent comparator, gives the same results as `variant_comparator`.
+ * (String-like keys need a temporary string, unless the comparator is
+ * `std::less`.)
+ */
+template <typename T, template <typename> class ComparatorTemplate = std::less,
+          typename WhichComparator_t = std::less<int>>
+struct transparent_variant_comparator;
+
+template <typename... Ts, template <typename> class ComparatorTemplate,
+          typename WhichComparator_t>
+struct transparent_variant_comparator<variant<Ts...>, ComparatorTemplate, WhichComparator_t> {
+  using var_t = variant<Ts...>;
+  using is_transparent = void;
+
+  bool operator()(const var_t & a, const var_t & b) const {
+    return variant_comparator<var_t, ComparatorTemplate, WhichComparator_t>{}(a, b);
+  }
+
+  template <typename K, typename = mpl::enable_if_t<!is_variant<mpl::decay_t<K>>::value>>
+  bool operator()(const var_t & v, const K & k) const {
+    return compare(v, k) < 0;
+  }
+
+  template <typename K, typename = mpl::enable_if_t<!is_variant<mpl::decay_t<K>>::value>>
+  bool operator()(const K & k, const var_t & v) const {
+    return compare(v, k) > 0;
+  }
+
+private:
+  // Negative if v is less than k, positive if greater
+  template <typename K>
+  static int compare(const var_t & v, const K & k) {
+    using key_t = detail::lookup_key_t<K>;
+    using slot = detail::lookup_slot<var_t, key_t>;
+    const int key_which = static_cast<int>(slot::value);
+    if (v.which() != key_which) {
+      WhichComparator_t c;
+      return c(v.which(), key_which) ? -1 : 1;
+    }
+    return detail::lookup_compare<ComparatorTemplate>(
+      v.template get_unchecked<slot::value>(), static_cast<const key_t &>(k),
+      detail::is_string_key<key_t>{});
+  }
+};
+//]
+
+} // end namespace strict_variant
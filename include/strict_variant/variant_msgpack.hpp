@@ -0,0 +1,253 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * MessagePack encoding and decoding of variants, using `codec_traits`.
+ *
+ * Integers, string lengths and container sizes are written in the smallest
+ * form. When reading, a signed integer format with a non-negative value is the
+ * same as an unsigned one. The bin and ext formats are not supported.
+ */
+
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_codec.hpp>
+#include <strict_variant/variant_serialize.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace strict_variant {
+
+//[ strict_variant_msgpack_writer
+template <typename Sink>
+class msgpack_writer {
+  Sink & m_sink;
+
+  void put(unsigned char c) { m_sink.push_back(static_cast<typename Sink::value_type>(c)); }
+
+  void put(unsigned char c, std::uint64_t x, unsigned num_bytes) {
+    this->put(c);
+    detail::put_uint_be(x, num_bytes, m_sink);
+  }
+
+  // A header for a string, array or map: the fixed form `fix` if there are at
+  // most `fix_max` elements, else the smallest of the sized forms. (There is
+  // an 8-bit form only if `c8` is nonzero.)
+  void put_size(std::size_t n, unsigned char fix, std::size_t fix_max, unsigned char c8,
+                unsigned char c16, unsigned char c32) {
+    if (n <= fix_max) {
+      this->put(static_cast<unsigned char>(fix | n));
+    } else if (c8 && n <= 0xffu) {
+      this->put(c8, n, 1);
+    } else if (n <= 0xffffu) {
+      this->put(c16, n, 2);
+    } else {
+      this->put(c32, n, 4);
+    }
+  }
+
+public:
+  explicit msgpack_writer(Sink & sink) noexcept
+    : m_sink(sink) {}
+
+  void nil() { this->put(0xc0); }
+  void boolean(bool b) { this->put(b ? 0xc3 : 0xc2); }
+
+  void uint(std::uint64_t x) {
+    if (x < 0x80u) {
+      this->put(static_cast<unsigned char>(x));
+    } else if (x <= 0xffu) {
+      this->put(0xcc, x, 1);
+    } else if (x <= 0xffffu) {
+      this->put(0xcd, x, 2);
+    } else if (x <= 0xffffffffu) {
+      this->put(0xce, x, 4);
+    } else {
+      this->put(0xcf, x, 8);
+    }
+  }
+
+  void nint(std::int64_t x) {
+    const std::uint64_t bits = static_cast<std::uint64_t>(x);
+    if (x >= -32) {
+      this->put(static_cast<unsigned char>(bits));
+    } else if (x >= INT8_MIN) {
+      this->put(0xd0, bits, 1);
+    } else if (x >= INT16_MIN) {
+      this->put(0xd1, bits, 2);
+    } else if (x >= INT32_MIN) {
+      this->put(0xd2, bits, 4);
+    } else {
+      this->put(0xd3, bits, 8);
+    }
+  }
+
+  void float32(float f) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    this->put(0xca, bits, 4);
+  }
+
+  void float64(double d) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    this->put(0xcb, bits, 8);
+  }
+
+  void string(const char * data, std::size_t size) {
+    this->put_size(size, 0xa0, 31, 0xd9, 0xda, 0xdb);
+    detail::put_bytes(data, size, m_sink);
+  }
+
+  void array(std::size_t n) { this->put_size(n, 0x90, 15, 0, 0xdc, 0xdd); }
+  void map(std::size_t n) { this->put_size(n, 0x80, 15, 0, 0xde, 0xdf); }
+};
+//]
+
+//[ strict_variant_msgpack_reader
+class msgpack_reader : public wire_reader_base {
+  bool get(unsigned num_bytes, std::uint64_t & x) noexcept {
+    return detail::get_uint_be(m_src, num_bytes, x);
+  }
+
+  // A signed integer of `num_bytes` bytes
+  bool get_signed(unsigned num_bytes, wire_item & item) noexcept {
+    std::uint64_t x;
+    if (!this->get(num_bytes, x)) { return false; }
+    const unsigned shift = 64 - 8 * num_bytes;
+    const std::int64_t i = static_cast<std::int64_t>(x << shift) >> shift;
+    if (i < 0) {
+      item.type = wire_type::nint;
+      item.i = i;
+    } else {
+      item.type = wire_type::uint;
+      item.u = static_cast<std::uint64_t>(i);
+    }
+    return true;
+  }
+
+  bool get_string(std::uint64_t n, wire_item & item) noexcept {
+    if (n > m_src.remaining()) { return false; }
+    item.type = wire_type::string;
+    item.u = n;
+    item.str = reinterpret_cast<const char *>(m_src.take(static_cast<std::size_t>(n)));
+    return true;
+  }
+
+  bool get_size(wire_type type, unsigned num_bytes, wire_item & item) noexcept {
+    item.type = type;
+    return this->get(num_bytes, item.u);
+  }
+
+public:
+  using wire_reader_base::wire_reader_base;
+
+  // Read the header of the next item
+  bool next(wire_item & item) noexcept {
+    const unsigned char * p = m_src.take(1);
+    if (!p) { return false; }
+    const unsigned char c = *p;
+
+    if (c <= 0x7f) {
+      item.type = wire_type::uint;
+      item.u = c;
+      return true;
+    } else if (c <= 0x8f) {
+      item.type = wire_type::map;
+      item.u = c & 0x0fu;
+      return true;
+    } else if (c <= 0x9f) {
+      item.type = wire_type::array;
+      item.u = c & 0x0fu;
+      return true;
+    } else if (c <= 0xbf) {
+      return this->get_string(c & 0x1fu, item);
+    } else if (c >= 0xe0) {
+      item.type = wire_type::nint;
+      item.i = static_cast<std::int64_t>(c) - 256;
+      return true;
+    }
+
+    std::uint64_t x;
+    switch (c) {
+      case 0xc0:
+        item.type = wire_type::nil;
+        return true;
+      case 0xc2:
+      case 0xc3:
+        item.type = wire_type::boolean;
+        item.u = c & 1u;
+        return true;
+      case 0xca: {
+        if (!this->get(4, x)) { return false; }
+        const std::uint32_t bits = static_cast<std::uint32_t>(x);
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        item.type = wire_type::floating;
+        item.f = f;
+        return true;
+      }
+      case 0xcb:
+        if (!this->get(8, x)) { return false; }
+        item.type = wire_type::floating;
+        std::memcpy(&item.f, &x, sizeof(x));
+        return true;
+      case 0xcc:
+      case 0xcd:
+      case 0xce:
+      case 0xcf:
+        item.type = wire_type::uint;
+        return this->get(1u << (c - 0xcc), item.u);
+      case 0xd0:
+      case 0xd1:
+      case 0xd2:
+      case 0xd3:
+        return this->get_signed(1u << (c - 0xd0), item);
+      case 0xd9:
+      case 0xda:
+      case 0xdb:
+        return this->get(1u << (c - 0xd9), x) && this->get_string(x, item);
+      case 0xdc:
+        return this->get_size(wire_type::array, 2, item);
+      case 0xdd:
+        return this->get_size(wire_type::array, 4, item);
+      case 0xde:
+        return this->get_size(wire_type::map, 2, item);
+      case 0xdf:
+        return this->get_size(wire_type::map, 4, item);
+      default:
+        return false;
+    }
+  }
+};
+//]
+
+//[ strict_variant_encode_msgpack
+/***
+ * Append the MessagePack encoding of a variant to `sink`.
+ */
+template <typename... Ts, typename Sink>
+inline void
+encode_msgpack(const variant<Ts...> & v, Sink & sink) {
+  msgpack_writer<Sink> w{sink};
+  codec_write(v, w);
+}
+
+/***
+ * Read a MessagePack value from `src`, and construct it in place in `v`.
+ * Returns false if the input is bad, or is not a value of the variant.
+ */
+template <typename... Ts>
+inline bool
+decode_msgpack(byte_source & src, variant<Ts...> & v) {
+  msgpack_reader r{src};
+  return codec_read(r, v);
+}
+//]
+
+} // end namespace strict_variant
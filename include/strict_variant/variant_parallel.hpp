@@ -0,0 +1,226 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Parallel algorithms for ranges of variants, which apply a visitor to each
+ * element on a `thread_pool`.
+ *
+ * The visitor is called concurrently, from several threads, so it must be
+ * safe to call that way. The range is split adaptively, as described in
+ * `thread_pool.hpp`, so it is not necessary that each value type costs about
+ * the same. A `grain` may be given, which is the most elements a thread
+ * handles without checking for idle threads; by default, it is chosen so that
+ * there are about 16 pieces per thread.
+ *
+ * `parallel_fold` evaluates a tree of recursive variants, such as an
+ * expression tree, bottom up, folding subtrees on other threads.
+ *
+ * Programs using these need to link with `-pthread`.
+ */
+
+#include <strict_variant/thread_pool.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+namespace detail {
+
+inline std::size_t
+default_grain(std::size_t n, const thread_pool & pool) noexcept {
+  const std::size_t pieces = std::size_t{16} * pool.concurrency();
+  return n / pieces ? n / pieces : 1;
+}
+
+} // end namespace detail
+
+//[ strict_variant_parallel_visit
+/***
+ * Call `apply_visitor(visitor, *it)` for each element of the range, in
+ * parallel.
+ */
+template <typename RandomIt, typename Visitor>
+void
+parallel_visit(RandomIt first, RandomIt last, Visitor && visitor,
+               thread_pool & pool = thread_pool::default_pool(), std::size_t grain = 0) {
+  const std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+  pool.parallel_for(n, grain ? grain : detail::default_grain(n, pool),
+                    [first, &visitor](std::size_t begin, std::size_t end) {
+                      for (std::size_t i = begin; i != end; ++i) {
+                        apply_visitor(visitor, first[i]);
+                      }
+                    });
+}
+//]
+
+//[ strict_variant_parallel_transform
+/***
+ * Assign `apply_visitor(visitor, first[i])` to `d_first[i]` for each element
+ * of the range, in parallel. Returns the end of the output range.
+ */
+template <typename RandomIt, typename OutputIt, typename Visitor>
+OutputIt
+parallel_transform(RandomIt first, RandomIt last, OutputIt d_first, Visitor && visitor,
+                   thread_pool & pool = thread_pool::default_pool(), std::size_t grain = 0) {
+  const std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+  pool.parallel_for(n, grain ? grain : detail::default_grain(n, pool),
+                    [first, d_first, &visitor](std::size_t begin, std::size_t end) {
+                      for (std::size_t i = begin; i != end; ++i) {
+                        d_first[i] = apply_visitor(visitor, first[i]);
+                      }
+                    });
+  return d_first + static_cast<typename std::iterator_traits<OutputIt>::difference_type>(n);
+}
+//]
+
+//[ strict_variant_parallel_reduce
+/***
+ * Reduce the range, in parallel, to
+ * `combine(...combine(combine(init, r0), r1)..., rn)`
+ * where `ri` is `apply_visitor(visitor, first[i])`, a value of type `T`.
+ *
+ * `combine`, which is `std::plus<T>` by default, must be associative, but
+ * need not be commutative: the pieces are combined in the order of the range.
+ * No identity element is needed.
+ */
+template <typename RandomIt, typename T, typename Visitor, typename Combine = std::plus<T>>
+T
+parallel_reduce(RandomIt first, RandomIt last, T init, Visitor && visitor,
+                Combine && combine = Combine{},
+                thread_pool & pool = thread_pool::default_pool(), std::size_t grain = 0) {
+  const std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+
+  // The result of each piece, and where it begins
+  std::vector<std::pair<std::size_t, T>> partials;
+  std::mutex mutex;
+
+  pool.parallel_for(n, grain ? grain : detail::default_grain(n, pool),
+                    [&](std::size_t begin, std::size_t end) {
+                      T acc = apply_visitor(visitor, first[begin]);
+                      for (std::size_t i = begin + 1; i != end; ++i) {
+                        acc = combine(std::move(acc), apply_visitor(visitor, first[i]));
+                      }
+                      std::lock_guard<std::mutex> lock{mutex};
+                      partials.emplace_back(begin, std::move(acc));
+                    });
+
+  std::sort(partials.begin(), partials.end(),
+            [](const std::pair<std::size_t, T> & a, const std::pair<std::size_t, T> & b) {
+              return a.first < b.first;
+            });
+  for (auto & p : partials) {
+    init = combine(std::move(init), std::move(p.second));
+  }
+  return init;
+}
+//]
+
+//[ strict_variant_parallel_fold
+/***
+ * The handle with which a `parallel_fold` visitor folds the children of a
+ * node. `fold_pair` and `fold_each` may fold the children on other threads.
+ *
+ * Subtrees are split lazily: a child becomes a task only when
+ * `thread_pool::should_split()` is true, which is when every task this thread
+ * made has been stolen. Otherwise the children are folded on this thread, as
+ * by a recursive visitor, for about the cost of one relaxed load. So small or
+ * lopsided subtrees are not split needlessly, and the work balances without
+ * knowing the size of subtrees in advance.
+ */
+template <typename R, typename Visitor>
+class fold_context {
+  Visitor & m_visitor;
+  thread_pool & m_pool;
+
+  struct caller {
+    fold_context & ctx;
+
+    template <typename T>
+    R operator()(const T & t) const {
+      return ctx.m_visitor(t, ctx);
+    }
+  };
+
+public:
+  fold_context(Visitor & visitor, thread_pool & pool) noexcept
+    : m_visitor(visitor)
+    , m_pool(pool) {}
+
+  thread_pool & pool() const noexcept { return m_pool; }
+
+  // Fold a child on this thread
+  template <typename V>
+  R fold(const V & child) {
+    return apply_visitor(caller{*this}, child);
+  }
+
+  // Fold two children, perhaps in parallel
+  template <typename V1, typename V2>
+  std::pair<R, R> fold_pair(const V1 & first, const V2 & second) {
+    if (!m_pool.should_split()) { return std::pair<R, R>(this->fold(first), this->fold(second)); }
+
+    std::pair<R, R> result;
+    m_pool.parallel_for(2, 1, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i != end; ++i) {
+        if (i) {
+          result.second = this->fold(second);
+        } else {
+          result.first = this->fold(first);
+        }
+      }
+    });
+    return result;
+  }
+
+  /***
+   * Fold each child of a random access range, perhaps in parallel, and
+   * assign the results to `out[0]`, `out[1]`, ...
+   */
+  template <typename RandomIt, typename OutputIt>
+  void fold_each(RandomIt first, RandomIt last, OutputIt out) {
+    const std::size_t n = static_cast<std::size_t>(std::distance(first, last));
+    if (n < 2 || !m_pool.should_split()) {
+      for (std::size_t i = 0; i < n; ++i) {
+        out[i] = this->fold(first[i]);
+      }
+      return;
+    }
+
+    m_pool.parallel_for(n, 1, [&](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i != end; ++i) {
+        out[i] = this->fold(first[i]);
+      }
+    });
+  }
+};
+
+/***
+ * Fold a tree of recursive variants to a value of type `R`.
+ *
+ * For the value of each node, `visitor(value, ctx)` is called, where `ctx` is
+ * a `fold_context<R, Visitor>`. It returns the result for the node, usually
+ * by folding its children through `ctx` and combining the results. The
+ * visitor may be called concurrently, from several threads. `R` must be
+ * default constructible and move assignable.
+ */
+template <typename R, typename V, typename Visitor>
+R
+parallel_fold(const V & tree, Visitor && visitor,
+              thread_pool & pool = thread_pool::default_pool()) {
+  fold_context<R, mpl::remove_reference_t<Visitor>> ctx{visitor, pool};
+  return ctx.fold(tree);
+}
+//]
+
+} // end namespace strict_variant
@@ -0,0 +1,49 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Enable relational operators for variant types.
+ *
+ * These use the same ordering as `variant_comparator` and `compare_three_way`:
+ * first by `which`, then by `operator <` of the value types.
+ * After comparing `which`, each operator makes exactly one dispatch.
+ *
+ * This is not brought in by `variant_compare.hpp`, see documentation for
+ * `variant_comparator`.
+ */
+
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_compare.hpp>
+
+namespace strict_variant {
+
+template <typename First, typename... Types>
+inline bool
+operator<(const variant<First, Types...> & lhs, const variant<First, Types...> & rhs) {
+  if (lhs.which() != rhs.which()) { return lhs.which() < rhs.which(); }
+  return variant<First, Types...>::apply_paired_visitor_impl(detail::paired_less{}, lhs, rhs);
+}
+
+template <typename First, typename... Types>
+inline bool
+operator>(const variant<First, Types...> & lhs, const variant<First, Types...> & rhs) {
+  return rhs < lhs;
+}
+
+template <typename First, typename... Types>
+inline bool
+operator<=(const variant<First, Types...> & lhs, const variant<First, Types...> & rhs) {
+  return !(rhs < lhs);
+}
+
+template <typename First, typename... Types>
+inline bool
+operator>=(const variant<First, Types...> & lhs, const variant<First, Types...> & rhs) {
+  return !(lhs < rhs);
+}
+
+} // end namespace strict_variant
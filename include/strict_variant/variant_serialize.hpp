@@ -0,0 +1,465 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Binary serialization of variants.
+ *
+ * `serialize(v, sink)` appends the `which` value and then the contained value
+ * to `sink`. The `which` value is one byte if there are at most 256 value types,
+ * else a LEB128 varint.
+ *
+ * `deserialize(source, v)` reads a value written by `serialize`, and constructs
+ * it in place in `v`, using a table of `emplace<idx>` calls indexed by the tag.
+ * No value is default-constructed first. Returns false if the input is
+ * truncated or malformed, in which case `v` is unchanged or holds the value
+ * that was being read, and the position of `source` is unspecified. Values
+ * nested too deeply, such as a long chain of `recursive_wrapper` nodes, are
+ * malformed, so that reading them cannot exhaust the stack.
+ *
+ * Each value type is written by the trait `serialize_traits<T>`, which is
+ * provided for trivially copyable types other than pointers (copied as raw
+ * bytes, in the byte order of the host), `std::string`, `std::vector`, and
+ * nested variants. `recursive_wrapper` is transparent to the format.
+ * Specialize the trait to support other types.
+ *
+ * A `Sink` is any container with a one-byte `value_type`, `push_back`, and
+ * range `insert`, such as `std::string` or `std::vector<unsigned char>`.
+ */
+
+#include <strict_variant/mpl/std_traits.hpp>
+#include <strict_variant/mpl/ulist.hpp>
+#include <strict_variant/mpl/typelist.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+//[ strict_variant_byte_source
+/***
+ * A view of a buffer of serialized data, which is consumed by reading, and a
+ * limit on the nesting depth of nested variants and vectors.
+ */
+struct byte_source {
+  const unsigned char * pos;
+  const unsigned char * end;
+  unsigned depth_left;
+
+  byte_source(const void * data, std::size_t size, unsigned max_depth = 128) noexcept
+    : pos(static_cast<const unsigned char *>(data))
+    , end(pos + size)
+    , depth_left(max_depth) {}
+
+  std::size_t remaining() const noexcept { return static_cast<std::size_t>(end - pos); }
+
+  // Consume `n` bytes. Returns a pointer to them, or nullptr if there are
+  // not that many.
+  const unsigned char * take(std::size_t n) noexcept {
+    if (n > this->remaining()) { return nullptr; }
+    const unsigned char * result = pos;
+    pos += n;
+    return result;
+  }
+
+  // Called around a nested variant, or the elements of a vector
+  bool enter() noexcept {
+    if (!depth_left) { return false; }
+    --depth_left;
+    return true;
+  }
+  void leave() noexcept { ++depth_left; }
+};
+//]
+
+//[ strict_variant_serialize_traits
+template <typename T, typename ENABLE = void>
+struct serialize_traits;
+// {
+//   template <typename Sink>
+//   static void write(const T &, Sink &);
+//
+//   // Read a value, and construct it by calling `emplace(args...)` exactly
+//   // once. Return false if the input is bad.
+//   template <typename Emplacer>
+//   static bool read(byte_source &, Emplacer && emplace);
+// };
+//]
+
+namespace detail {
+
+template <typename Sink>
+inline void
+put_bytes(const void * data, std::size_t n, Sink & sink) {
+  using byte_t = typename Sink::value_type;
+  static_assert(sizeof(byte_t) == 1, "Sink must have a one-byte value_type");
+  const byte_t * p = static_cast<const byte_t *>(data);
+  sink.insert(sink.end(), p, p + n);
+}
+
+template <typename Sink>
+inline void
+put_varint(std::uint64_t x, Sink & sink) {
+  using byte_t = typename Sink::value_type;
+  while (x >= 0x80u) {
+    sink.push_back(static_cast<byte_t>(static_cast<unsigned char>(x | 0x80u)));
+    x >>= 7;
+  }
+  sink.push_back(static_cast<byte_t>(static_cast<unsigned char>(x)));
+}
+
+inline bool
+get_varint(byte_source & src, std::uint64_t & x) noexcept {
+  x = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    const unsigned char * b = src.take(1);
+    if (!b) { return false; }
+    x |= static_cast<std::uint64_t>(*b & 0x7Fu) << shift;
+    if (!(*b & 0x80u)) { return true; }
+  }
+  return false;
+}
+
+// Encoding of the which value of a variant with `num_types` value types
+template <std::size_t num_types, bool one_byte = (num_types <= 256)>
+struct tag_codec {
+  template <typename Sink>
+  static void write(unsigned which, Sink & sink) {
+    detail::put_varint(which, sink);
+  }
+
+  static bool read(byte_source & src, std::size_t & which) noexcept {
+    std::uint64_t x;
+    if (!detail::get_varint(src, x) || x >= num_types) { return false; }
+    which = static_cast<std::size_t>(x);
+    return true;
+  }
+};
+
+template <std::size_t num_types>
+struct tag_codec<num_types, true> {
+  template <typename Sink>
+  static void write(unsigned which, Sink & sink) {
+    using byte_t = typename Sink::value_type;
+    sink.push_back(static_cast<byte_t>(static_cast<unsigned char>(which)));
+  }
+
+  static bool read(byte_source & src, std::size_t & which) noexcept {
+    const unsigned char * b = src.take(1);
+    if (!b || static_cast<std::size_t>(*b) >= num_types) { return false; }
+    which = *b;
+    return true;
+  }
+};
+
+// A sink which writes into a fixed buffer, and notes if it ran out of room
+class bounded_sink {
+  unsigned char * m_begin;
+  unsigned char * m_pos;
+  unsigned char * m_end;
+  bool m_overflow = false;
+
+public:
+  using value_type = unsigned char;
+  using iterator = unsigned char *;
+
+  bounded_sink(unsigned char * data, std::size_t size) noexcept
+    : m_begin(data)
+    , m_pos(data)
+    , m_end(data + size) {}
+
+  iterator end() const noexcept { return m_pos; }
+
+  void push_back(unsigned char c) noexcept {
+    if (m_pos != m_end) {
+      *m_pos++ = c;
+    } else {
+      m_overflow = true;
+    }
+  }
+
+  void insert(iterator, const unsigned char * first, const unsigned char * last) noexcept {
+    const std::size_t n = static_cast<std::size_t>(last - first);
+    if (n <= static_cast<std::size_t>(m_end - m_pos)) {
+      if (n) { std::memcpy(m_pos, first, n); }
+      m_pos += n;
+    } else {
+      m_overflow = true;
+    }
+  }
+
+  bool overflow() const noexcept { return m_overflow; }
+  std::size_t size() const noexcept { return static_cast<std::size_t>(m_pos - m_begin); }
+};
+
+template <typename Sink>
+struct serialize_visitor {
+  Sink & sink;
+
+  template <typename T>
+  void operator()(const T & t) const {
+    serialize_traits<T>::write(t, sink);
+  }
+};
+
+// Forwards the arguments for a value of type T to an emplacer, preceded by
+// `emplace_tag<T>`, so that the target variant constructs the right type.
+template <typename T, typename Emplacer>
+struct tagged_emplacer {
+  Emplacer & emplace;
+
+  template <typename... Args>
+  void operator()(Args &&... args) const {
+    emplace(emplace_tag<T>{}, std::forward<Args>(args)...);
+  }
+};
+
+// Reads value type `idx` of a list of value types. `recursive_wrapper` is
+// transparent here.
+template <typename TL, typename Emplacer, unsigned idx>
+bool
+read_alternative(byte_source & src, Emplacer & emplace) {
+  using T = unwrap_type_t<mpl::Index_At<TL, idx>>;
+  return serialize_traits<T>::read(src, tagged_emplacer<T, Emplacer>{emplace});
+}
+
+template <typename TL, typename Emplacer, typename UL>
+struct read_table;
+
+template <typename TL, typename Emplacer, unsigned... us>
+struct read_table<TL, Emplacer, mpl::ulist<us...>> {
+  using function_t = bool (*)(byte_source &, Emplacer &);
+
+  static function_t get(std::size_t idx) {
+    static constexpr function_t table[] = {&read_alternative<TL, Emplacer, us>...};
+    return table[idx];
+  }
+};
+
+// Read a tag, and then the corresponding value type, constructing it using
+// `emplace(emplace_tag<T>{}, args...)`.
+template <typename... Ts, typename Emplacer>
+bool
+read_variant(byte_source & src, Emplacer & emplace, variant<Ts...> *) {
+  using table_t = read_table<mpl::TypeList<Ts...>, Emplacer, mpl::count_t<sizeof...(Ts)>>;
+
+  std::size_t which;
+  if (!src.enter()) { return false; }
+  const bool ok =
+    tag_codec<sizeof...(Ts)>::read(src, which) && table_t::get(which)(src, emplace);
+  src.leave();
+  return ok;
+}
+
+// Emplaces into an existing variant
+template <typename V>
+struct variant_emplacer {
+  V & target;
+
+  template <typename T, typename... Args>
+  void operator()(emplace_tag<T>, Args &&... args) const {
+    target.template emplace<T>(std::forward<Args>(args)...);
+  }
+};
+
+// Appends to a vector
+template <typename T>
+struct vector_emplacer {
+  std::vector<T> & target;
+
+  template <typename... Args>
+  void operator()(Args &&... args) const {
+    target.emplace_back(std::forward<Args>(args)...);
+  }
+};
+
+// Holds a value which is being read, without default-constructing it
+template <typename T>
+struct raw_value {
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+  T & get() noexcept { return *reinterpret_cast<T *>(&storage); }
+};
+
+// Pointers are addresses in one process, so they are not copied as raw bytes
+template <typename T>
+struct is_address
+  : std::integral_constant<bool, std::is_pointer<T>::value || std::is_member_pointer<T>::value> {};
+
+// Whether `n` values of `T`, as raw bytes at `p`, are valid. Only `bool` has
+// bit patterns which are not values.
+template <typename T>
+inline bool
+valid_raw_values(const unsigned char *, std::size_t) noexcept {
+  return true;
+}
+
+template <>
+inline bool
+valid_raw_values<bool>(const unsigned char * p, std::size_t n) noexcept {
+  const bool f = false;
+  const bool t = true;
+  for (std::size_t i = 0; i < n; ++i, p += sizeof(bool)) {
+    if (std::memcmp(p, &f, sizeof(bool)) && std::memcmp(p, &t, sizeof(bool))) { return false; }
+  }
+  return true;
+}
+
+} // end namespace detail
+
+// Trivially copyable types are copied as raw bytes. A `bool` must be `false`
+// or `true`; other values of these types are not checked.
+template <typename T>
+struct serialize_traits<T, mpl::enable_if_t<std::is_trivially_copyable<T>::value
+                                            && !is_variant<T>::value>> {
+  static_assert(!detail::is_address<T>::value, "Pointers may not be serialized!");
+
+  template <typename Sink>
+  static void write(const T & t, Sink & sink) {
+    detail::put_bytes(&t, sizeof(T), sink);
+  }
+
+  template <typename Emplacer>
+  static bool read(byte_source & src, Emplacer && emplace) {
+    const unsigned char * p = src.take(sizeof(T));
+    if (!p || !detail::valid_raw_values<T>(p, 1)) { return false; }
+    detail::raw_value<T> v;
+    std::memcpy(&v.storage, p, sizeof(T));
+    emplace(v.get());
+    return true;
+  }
+};
+
+// Strings are a varint length, then the characters
+template <>
+struct serialize_traits<std::string> {
+  template <typename Sink>
+  static void write(const std::string & s, Sink & sink) {
+    detail::put_varint(s.size(), sink);
+    detail::put_bytes(s.data(), s.size(), sink);
+  }
+
+  template <typename Emplacer>
+  static bool read(byte_source & src, Emplacer && emplace) {
+    std::uint64_t n;
+    if (!detail::get_varint(src, n) || n > src.remaining()) { return false; }
+    const unsigned char * p = src.take(static_cast<std::size_t>(n));
+    emplace(reinterpret_cast<const char *>(p), static_cast<std::size_t>(n));
+    return true;
+  }
+};
+
+// Vectors are a varint length, then the elements. If the elements are
+// trivially copyable, they are copied as one block.
+template <typename T>
+struct serialize_traits<std::vector<T>> {
+  static constexpr bool bulk = std::is_trivially_copyable<T>::value && !is_variant<T>::value;
+  static_assert(!detail::is_address<T>::value, "Pointers may not be serialized!");
+
+  template <typename Sink>
+  static void write(const std::vector<T> & vec, Sink & sink) {
+    detail::put_varint(vec.size(), sink);
+    write_elements(vec, sink, std::integral_constant<bool, bulk>{});
+  }
+
+  template <typename Emplacer>
+  static bool read(byte_source & src, Emplacer && emplace) {
+    std::uint64_t n;
+    if (!detail::get_varint(src, n)) { return false; }
+    // Each element is at least one byte
+    if (n > src.remaining()) { return false; }
+
+    std::vector<T> result;
+    if (!read_elements(src, static_cast<std::size_t>(n), result,
+                       std::integral_constant<bool, bulk>{})) {
+      return false;
+    }
+    emplace(std::move(result));
+    return true;
+  }
+
+private:
+  template <typename Sink>
+  static void write_elements(const std::vector<T> & vec, Sink & sink, std::true_type) {
+    detail::put_bytes(vec.data(), vec.size() * sizeof(T), sink);
+  }
+
+  template <typename Sink>
+  static void write_elements(const std::vector<T> & vec, Sink & sink, std::false_type) {
+    for (const T & t : vec) {
+      serialize_traits<T>::write(t, sink);
+    }
+  }
+
+  static bool read_elements(byte_source & src, std::size_t n, std::vector<T> & result,
+                            std::true_type) {
+    if (n > src.remaining() / sizeof(T)) { return false; }
+    const unsigned char * p = src.take(n * sizeof(T));
+    if (!detail::valid_raw_values<T>(p, n)) { return false; }
+    result.resize(n);
+    if (n) { std::memcpy(result.data(), p, n * sizeof(T)); }
+    return true;
+  }
+
+  static bool read_elements(byte_source & src, std::size_t n, std::vector<T> & result,
+                            std::false_type) {
+    if (!src.enter()) { return false; }
+    result.reserve(n);
+    bool ok = true;
+    for (std::size_t i = 0; ok && i < n; ++i) {
+      ok = serialize_traits<T>::read(src, detail::vector_emplacer<T>{result});
+    }
+    src.leave();
+    return ok;
+  }
+};
+
+// Nested variants are a tag and a value. The arguments passed to `emplace`
+// begin with `emplace_tag<T>`, so the nested variant is constructed in place in
+// the enclosing variant, or vector.
+template <typename... Ts>
+struct serialize_traits<variant<Ts...>> {
+  template <typename Sink>
+  static void write(const variant<Ts...> & v, Sink & sink) {
+    detail::tag_codec<sizeof...(Ts)>::write(static_cast<unsigned>(v.which()), sink);
+    strict_variant::apply_visitor(detail::serialize_visitor<Sink>{sink}, v);
+  }
+
+  template <typename Emplacer>
+  static bool read(byte_source & src, Emplacer && emplace) {
+    return detail::read_variant(src, emplace, static_cast<variant<Ts...> *>(nullptr));
+  }
+};
+
+//[ strict_variant_serialize
+/***
+ * Append the serialized form of a variant to `sink`.
+ */
+template <typename... Ts, typename Sink>
+inline void
+serialize(const variant<Ts...> & v, Sink & sink) {
+  serialize_traits<variant<Ts...>>::write(v, sink);
+}
+
+/***
+ * Read a variant from `src`, and construct it in place in `v`.
+ * Returns false if the input is bad.
+ */
+template <typename... Ts>
+inline bool
+deserialize(byte_source & src, variant<Ts...> & v) {
+  detail::variant_emplacer<variant<Ts...>> e{v};
+  return detail::read_variant(src, e, static_cast<variant<Ts...> *>(nullptr));
+}
+//]
+
+} // end namespace strict_variant
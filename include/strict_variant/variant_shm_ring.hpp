@@ -0,0 +1,233 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A lock-free ring buffer of variants, in memory shared between processes.
+ *
+ * `shm_ring<V>` is constructed in a caller-provided buffer, such as a shared
+ * mapping of a file, with `create`, and found in another mapping of the same
+ * memory, at any address, with `attach`. All of its state is in the buffer,
+ * and it holds no pointers.
+ *
+ * Each slot holds a `V` and a `shm_arena` for its payload. A producer
+ * constructs the value in place in a slot, with the slot's arena current, so
+ * that `offset_wrapper` and `offset_array` members are allocated in the slot.
+ * The consumer visits the value in place, and then destroys it. Nothing is
+ * serialized, so every value type must be `is_position_independent`. If a
+ * payload does not fit in the arena, `std::bad_alloc` is thrown, and the slot
+ * is skipped.
+ *
+ * The ring is bounded, and any number of threads, in any number of processes,
+ * may produce (Vyukov's bounded queue), but only one thread may consume at
+ * a time. Pushing fails if the ring is full.
+ */
+
+#include <strict_variant/offset_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace strict_variant {
+
+//[ strict_variant_shm_ring
+template <typename V>
+class shm_ring {
+  static_assert(is_position_independent<V>::value,
+                "The value type of shm_ring must be position independent");
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+                "shm_ring needs lock-free 64-bit atomics, which are address-free");
+
+  static constexpr std::uint64_t magic = 0x676e6972766873ull;
+  static constexpr std::size_t line = 64;
+
+  struct slot {
+    // Equal to the position when the slot is free, and one more when it is full
+    std::atomic<std::uint64_t> seq;
+    // False if the producer failed to construct the value
+    bool valid;
+    typename std::aligned_storage<sizeof(V), alignof(V)>::type storage;
+    // Followed by the payload
+    shm_arena arena;
+
+    slot(std::uint64_t pos, std::size_t payload_size) noexcept
+      : seq(pos)
+      , valid(false)
+      , arena(payload_size) {}
+
+    V & value() noexcept { return *reinterpret_cast<V *>(&storage); }
+  };
+
+  // A check that both processes use the same type
+  static constexpr std::uint64_t type_id = (std::uint64_t{sizeof(V)} << 32) | alignof(V);
+
+  std::uint64_t m_magic;
+  std::uint64_t m_type_id;
+  std::uint64_t m_mask;
+  std::uint64_t m_stride;
+  alignas(line) std::atomic<std::uint64_t> m_enqueue;
+  alignas(line) std::atomic<std::uint64_t> m_dequeue;
+
+  static std::size_t stride(std::size_t payload_size) noexcept {
+    return (sizeof(slot) + payload_size + line - 1) / line * line;
+  }
+
+  static std::size_t round_up_pow2(std::size_t n) noexcept {
+    std::size_t result = 1;
+    while (result < n) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  slot & slot_at(std::uint64_t pos) noexcept {
+    unsigned char * base = reinterpret_cast<unsigned char *>(this) + sizeof(shm_ring);
+    return *reinterpret_cast<slot *>(base + (pos & m_mask) * m_stride);
+  }
+
+  shm_ring(std::size_t slots, std::size_t payload_size) noexcept
+    : m_magic(magic)
+    , m_type_id(type_id)
+    , m_mask(slots - 1)
+    , m_stride(stride(payload_size))
+    , m_enqueue(0)
+    , m_dequeue(0) {
+    for (std::size_t i = 0; i < slots; ++i) {
+      new (&this->slot_at(i)) slot(i, m_stride - sizeof(slot));
+    }
+  }
+
+  // Publishes a slot when the producer is done with it, even if constructing
+  // the value threw
+  struct publisher {
+    slot & s;
+    std::uint64_t pos;
+    bool success;
+
+    ~publisher() {
+      s.valid = success;
+      s.seq.store(pos + 1, std::memory_order_release);
+    }
+  };
+
+  // Claim a slot, and construct the value with the arguments
+  template <typename... Args>
+  bool push_impl(Args &&... args) {
+    std::uint64_t pos = m_enqueue.load(std::memory_order_relaxed);
+    slot * s;
+    for (;;) {
+      s = &this->slot_at(pos);
+      const std::uint64_t seq = s->seq.load(std::memory_order_acquire);
+      const std::int64_t diff = static_cast<std::int64_t>(seq - pos);
+      if (diff == 0) {
+        if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_enqueue.load(std::memory_order_relaxed);
+      }
+    }
+
+    publisher p{*s, pos, false};
+    s->arena.reset();
+    shm_arena::scope scope{s->arena};
+    new (&s->storage) V(std::forward<Args>(args)...);
+    p.success = true;
+    return true;
+  }
+
+  // Releases a slot when the consumer is done with it
+  struct releaser {
+    shm_ring & ring;
+    slot & s;
+    std::uint64_t pos;
+
+    ~releaser() {
+      if (s.valid) { s.value().~V(); }
+      s.seq.store(pos + ring.m_mask + 1, std::memory_order_release);
+      ring.m_dequeue.store(pos + 1, std::memory_order_relaxed);
+    }
+  };
+
+public:
+  shm_ring(const shm_ring &) = delete;
+  shm_ring & operator=(const shm_ring &) = delete;
+
+  // The number of bytes needed for a ring of `slots` values, rounded up to a
+  // power of two, each with `payload_size` bytes of arena
+  static std::size_t required_size(std::size_t slots, std::size_t payload_size) noexcept {
+    return sizeof(shm_ring) + round_up_pow2(slots) * stride(payload_size);
+  }
+
+  /***
+   * Construct a ring in `mem`, which must be aligned to 64 bytes, and hold
+   * `required_size(slots, payload_size)` bytes.
+   */
+  static shm_ring * create(void * mem, std::size_t slots, std::size_t payload_size) noexcept {
+    return new (mem) shm_ring(round_up_pow2(slots), payload_size);
+  }
+
+  /***
+   * Get the ring constructed in `mem`, possibly by another process. Returns
+   * nullptr if it is not a ring of `V`.
+   */
+  static shm_ring * attach(void * mem) noexcept {
+    shm_ring * r = static_cast<shm_ring *>(mem);
+    if (r->m_magic != magic || r->m_type_id != type_id) { return nullptr; }
+    return r;
+  }
+
+  std::size_t capacity() const noexcept { return static_cast<std::size_t>(m_mask + 1); }
+
+  /***
+   * Construct a value of type `T` in a slot, with the arguments. Returns false
+   * if the ring is full.
+   */
+  template <typename T, typename... Args>
+  bool try_emplace(Args &&... args) {
+    return this->push_impl(emplace_tag<T>{}, std::forward<Args>(args)...);
+  }
+
+  // Copy a value into a slot
+  bool try_push(const V & v) { return this->push_impl(v); }
+
+  /***
+   * Call `f` with the next value, as a `V &`, and then destroy it. Returns
+   * false if the ring is empty. Only one thread may consume at a time.
+   */
+  template <typename F>
+  bool try_consume(F && f) {
+    for (;;) {
+      const std::uint64_t pos = m_dequeue.load(std::memory_order_relaxed);
+      slot & s = this->slot_at(pos);
+      if (s.seq.load(std::memory_order_acquire) != pos + 1) { return false; }
+
+      releaser r{*this, s, pos};
+      if (s.valid) {
+        f(s.value());
+        return true;
+      }
+    }
+  }
+
+  // Consume all of the values which are ready. Returns the number of them.
+  template <typename F>
+  std::size_t consume_all(F && f) {
+    std::size_t count = 0;
+    while (this->try_consume(f)) {
+      ++count;
+    }
+    return count;
+  }
+};
+//]
+
+} // end namespace strict_variant
@@ -0,0 +1,255 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * A holder for a value, such as a large or recursive variant, which is read
+ * by many threads and replaced now and then, in the style of RCU.
+ *
+ * Writers build a new value and publish it with one atomic exchange. Readers
+ * visit the value through a `read_guard`, and never block or retry. The value
+ * a guard refers to stays alive until the guard is released, even if it has
+ * been replaced meanwhile.
+ *
+ * Old values are reclaimed by epochs. Each reader has its own record, in a
+ * cache line of its own, in which it announces the epoch when it started to
+ * read. A writer retires the old value with the current epoch, and then
+ * advances the epoch. A retired value is destroyed by a later writer, once
+ * every reader which is reading started in a later epoch. So readers only
+ * write to their own record, and do not contend with one another.
+ *
+ * Each reading thread uses a `reader`, from `make_reader()`. Records are
+ * reused when readers are destroyed. Writers are serialized by a mutex.
+ */
+
+#include <strict_variant/concurrency.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+//[ strict_variant_variant_snapshot
+template <typename V>
+class variant_snapshot {
+  // The epoch a reader started in, or zero if it is not reading
+  struct reader_record {
+    char pad[detail::cache_line_size];
+    std::atomic<std::uint64_t> epoch{0};
+    std::atomic<bool> in_use{true};
+    reader_record * next = nullptr;
+    char pad_end[detail::cache_line_size];
+  };
+
+  struct retired {
+    V * value;
+    std::uint64_t epoch;
+  };
+
+  std::atomic<V *> m_current;
+  std::atomic<std::uint64_t> m_epoch{1};
+  std::atomic<reader_record *> m_readers{nullptr};
+
+  std::mutex m_writer_mutex;
+  std::vector<retired> m_retired;
+
+  reader_record * acquire_record() {
+    for (reader_record * r = m_readers.load(std::memory_order_acquire); r; r = r->next) {
+      bool free = false;
+      if (!r->in_use.load(std::memory_order_relaxed)
+          && r->in_use.compare_exchange_strong(free, true, std::memory_order_acquire)) {
+        return r;
+      }
+    }
+    reader_record * r = new reader_record;
+    r->next = m_readers.load(std::memory_order_relaxed);
+    while (!m_readers.compare_exchange_weak(r->next, r, std::memory_order_release)) {}
+    return r;
+  }
+
+  // Requires the writer mutex
+  void publish_locked(V * v) {
+    V * old = m_current.exchange(v);
+    m_retired.push_back(retired{old, m_epoch.fetch_add(1)});
+    this->reclaim_locked();
+  }
+
+  void reclaim_locked() noexcept {
+    // A value retired in epoch e may be in use by readers which started in
+    // epoch e or before
+    std::uint64_t oldest = m_epoch.load();
+    for (reader_record * r = m_readers.load(); r; r = r->next) {
+      const std::uint64_t e = r->epoch.load();
+      if (e && e < oldest) { oldest = e; }
+    }
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < m_retired.size(); ++i) {
+      if (m_retired[i].epoch < oldest) {
+        delete m_retired[i].value;
+      } else {
+        m_retired[kept++] = m_retired[i];
+      }
+    }
+    m_retired.resize(kept);
+  }
+
+public:
+  using value_type = V;
+
+  class reader;
+
+  /***
+   * A reference to the value which was current when the guard was made.
+   * Movable, but not copyable.
+   */
+  class read_guard {
+    reader * m_reader;
+    const V * m_value;
+
+    friend class reader;
+
+    explicit read_guard(reader & r) noexcept
+      : m_reader(&r)
+      , m_value(r.enter()) {}
+
+  public:
+    read_guard(read_guard && other) noexcept
+      : m_reader(other.m_reader)
+      , m_value(other.m_value) {
+      other.m_reader = nullptr;
+    }
+
+    read_guard(const read_guard &) = delete;
+    read_guard & operator=(const read_guard &) = delete;
+    read_guard & operator=(read_guard &&) = delete;
+
+    ~read_guard() noexcept {
+      if (m_reader) { m_reader->leave(); }
+    }
+
+    const V & operator*() const noexcept { return *m_value; }
+    const V * operator->() const noexcept { return m_value; }
+    const V * get() const noexcept { return m_value; }
+  };
+
+  /***
+   * The handle which one thread uses to read. Guards may be nested.
+   */
+  class reader {
+    variant_snapshot * m_snapshot;
+    reader_record * m_record;
+    unsigned m_depth = 0;
+
+    friend class read_guard;
+    friend class variant_snapshot;
+
+    explicit reader(variant_snapshot & s)
+      : m_snapshot(&s)
+      , m_record(s.acquire_record()) {}
+
+    const V * enter() noexcept {
+      if (!m_depth++) {
+        // Sequentially consistent, so that either a writer sees this epoch,
+        // or this reader sees the writer's value
+        m_record->epoch.store(m_snapshot->m_epoch.load());
+      }
+      return m_snapshot->m_current.load();
+    }
+
+    void leave() noexcept {
+      if (!--m_depth) { m_record->epoch.store(0, std::memory_order_release); }
+    }
+
+  public:
+    reader(reader && other) noexcept
+      : m_snapshot(other.m_snapshot)
+      , m_record(other.m_record)
+      , m_depth(other.m_depth) {
+      other.m_record = nullptr;
+    }
+
+    reader(const reader &) = delete;
+    reader & operator=(const reader &) = delete;
+    reader & operator=(reader &&) = delete;
+
+    ~reader() noexcept {
+      if (m_record) { m_record->in_use.store(false, std::memory_order_release); }
+    }
+
+    read_guard read() noexcept { return read_guard{*this}; }
+  };
+
+  template <typename... Args>
+  explicit variant_snapshot(Args &&... args)
+    : m_current(new V(std::forward<Args>(args)...)) {}
+
+  variant_snapshot(const variant_snapshot &) = delete;
+  variant_snapshot & operator=(const variant_snapshot &) = delete;
+
+  // No reader or writer may be running
+  ~variant_snapshot() noexcept {
+    delete m_current.load();
+    for (const retired & r : m_retired) {
+      delete r.value;
+    }
+    reader_record * r = m_readers.load();
+    while (r) {
+      reader_record * next = r->next;
+      delete r;
+      r = next;
+    }
+  }
+
+  reader make_reader() { return reader{*this}; }
+
+  // Replace the value with a new one, constructed with the arguments
+  template <typename... Args>
+  void emplace(Args &&... args) {
+    V * v = new V(std::forward<Args>(args)...);
+    std::lock_guard<std::mutex> lock{m_writer_mutex};
+    this->publish_locked(v);
+  }
+
+  void store(const V & v) { this->emplace(v); }
+  void store(V && v) { this->emplace(std::move(v)); }
+
+  /***
+   * Replace the value with a modified copy. `f` is called with the copy, as
+   * a `V &`. Concurrent updates are serialized, so none are lost.
+   */
+  template <typename F>
+  void update(F && f) {
+    std::lock_guard<std::mutex> lock{m_writer_mutex};
+    V * v = new V(*m_current.load());
+    try {
+      f(*v);
+    } catch (...) {
+      delete v;
+      throw;
+    }
+    this->publish_locked(v);
+  }
+
+  // Destroy the retired values which no reader can be using
+  void reclaim() {
+    std::lock_guard<std::mutex> lock{m_writer_mutex};
+    this->reclaim_locked();
+  }
+
+  // The number of retired values which are not yet destroyed
+  std::size_t retired_count() {
+    std::lock_guard<std::mutex> lock{m_writer_mutex};
+    return m_retired.size();
+  }
+};
+//]
+
+} // end namespace strict_variant
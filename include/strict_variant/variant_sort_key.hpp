@@ -0,0 +1,199 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Order-preserving byte encoding of variants.
+ *
+ * `encode_sort_key(v, sink)` appends a byte string to `sink`, such that
+ * comparing the byte strings of two variants with `memcmp` (as unsigned bytes,
+ * shorter string first on a tie) gives the same result as
+ * `variant_comparator` with its default template parameters.
+ *
+ * So, keys may be sorted with a radix sort, or stored in an on-disk index and
+ * range-scanned, without dispatching on the variant type again.
+ *
+ * The encoding is:
+ * - The `which` value, big-endian, in one byte if there are at most 256 value
+ *   types, two bytes if at most 65536, else four bytes.
+ * - The encoding of the contained value, from `sort_key_encoder<T>`.
+ *
+ * The value encodings are prefix-free: no encoding is a proper prefix of
+ * another encoding of the same type. So keys may be concatenated, and the
+ * comparison never depends on the lengths of the keys.
+ *
+ * `sort_key_encoder` is provided for integral, enum, `float` and `double`
+ * types, `std::string`, and nested variants. Specialize it to support other
+ * types. A `Sink` is any container with `value_type` one byte wide and with
+ * `push_back`, such as `std::string` or `std::vector<unsigned char>`.
+ */
+
+#include <strict_variant/mpl/std_traits.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+namespace strict_variant {
+
+/***
+ * Trait which encodes a value of type T, so that the order of the byte strings
+ * is the same as the order of `std::less<T>`.
+ */
+//[ strict_variant_sort_key_encoder
+template <typename T, typename ENABLE = void>
+struct sort_key_encoder;
+// {
+//   template <typename Sink>
+//   static void encode(const T &, Sink &);
+// };
+//]
+
+namespace detail {
+
+// Append the low `num_bytes` bytes of x, most significant first.
+template <typename Sink, typename U>
+inline void
+put_big_endian(U x, std::size_t num_bytes, Sink & sink) {
+  static_assert(std::is_unsigned<U>::value, "put_big_endian requires an unsigned type");
+  using byte_t = typename Sink::value_type;
+  static_assert(sizeof(byte_t) == 1, "Sink must have a one-byte value_type");
+  while (num_bytes--) {
+    sink.push_back(static_cast<byte_t>(static_cast<unsigned char>(x >> (num_bytes * CHAR_BIT))));
+  }
+}
+
+// Unsigned integer type with the same size as a floating point type
+template <typename F>
+struct float_bits;
+
+template <>
+struct float_bits<float> {
+  using type = std::uint32_t;
+};
+
+template <>
+struct float_bits<double> {
+  using type = std::uint64_t;
+};
+
+template <typename Sink>
+struct sort_key_visitor {
+  Sink & sink;
+
+  template <typename T>
+  void operator()(const T & t) const {
+    sort_key_encoder<T>::encode(t, sink);
+  }
+};
+
+} // end namespace detail
+
+// Integers are written big-endian, with the sign bit flipped if signed, so
+// that negative numbers come first.
+template <typename T>
+struct sort_key_encoder<T, mpl::enable_if_t<std::is_integral<T>::value>> {
+  template <typename Sink>
+  static void encode(T t, Sink & sink) {
+    using U = typename std::make_unsigned<T>::type;
+    U u = static_cast<U>(t);
+    if (std::is_signed<T>::value) { u ^= static_cast<U>(U(1) << (sizeof(U) * CHAR_BIT - 1)); }
+    detail::put_big_endian(u, sizeof(U), sink);
+  }
+};
+
+// bool is not handled by make_unsigned
+template <>
+struct sort_key_encoder<bool> {
+  template <typename Sink>
+  static void encode(bool b, Sink & sink) {
+    detail::put_big_endian(static_cast<unsigned>(b), 1, sink);
+  }
+};
+
+template <typename T>
+struct sort_key_encoder<T, mpl::enable_if_t<std::is_enum<T>::value>> {
+  template <typename Sink>
+  static void encode(T t, Sink & sink) {
+    using U = typename std::underlying_type<T>::type;
+    sort_key_encoder<U>::encode(static_cast<U>(t), sink);
+  }
+};
+
+// IEEE floats: positive numbers get the sign bit set, negative numbers have
+// all bits inverted. `-0.0` is written as `0.0`, since they are equivalent
+// under `std::less`. All NaNs are written as one NaN, which comes after
+// positive infinity. (`std::less` is not a strict weak order when there are
+// NaNs, so there is no order to preserve for them.)
+template <typename T>
+struct sort_key_encoder<T, mpl::enable_if_t<std::is_floating_point<T>::value>> {
+  static_assert(std::numeric_limits<T>::is_iec559,
+                "sort_key_encoder requires IEEE 754 floating point types");
+
+  template <typename Sink>
+  static void encode(T t, Sink & sink) {
+    using U = typename detail::float_bits<T>::type;
+    constexpr U sign_bit = U(1) << (sizeof(U) * CHAR_BIT - 1);
+
+    if (t == T(0)) {
+      t = T(0);
+    } else if (t != t) {
+      t = std::numeric_limits<T>::quiet_NaN();
+    }
+
+    U u;
+    std::memcpy(&u, &t, sizeof(U));
+    u = (u & sign_bit) ? static_cast<U>(~u) : static_cast<U>(u | sign_bit);
+    detail::put_big_endian(u, sizeof(U), sink);
+  }
+};
+
+// Strings are terminated by `00 01`, with each `00` byte inside the string
+// escaped as `00 FF`. This is prefix-free, and keeps the order of
+// `std::string::compare`, which compares characters as unsigned char.
+template <>
+struct sort_key_encoder<std::string> {
+  template <typename Sink>
+  static void encode(const std::string & s, Sink & sink) {
+    using byte_t = typename Sink::value_type;
+    for (char c : s) {
+      sink.push_back(static_cast<byte_t>(c));
+      if (c == '\0') { sink.push_back(static_cast<byte_t>(0xFF)); }
+    }
+    sink.push_back(static_cast<byte_t>(0x00));
+    sink.push_back(static_cast<byte_t>(0x01));
+  }
+};
+
+template <typename... Ts>
+struct sort_key_encoder<variant<Ts...>> {
+  // Number of bytes used for the `which` value
+  static constexpr std::size_t tag_bytes =
+    sizeof...(Ts) <= 256u ? 1u : (sizeof...(Ts) <= 65536u ? 2u : 4u);
+
+  template <typename Sink>
+  static void encode(const variant<Ts...> & v, Sink & sink) {
+    detail::put_big_endian(static_cast<unsigned>(v.which()), tag_bytes, sink);
+    strict_variant::apply_visitor(detail::sort_key_visitor<Sink>{sink}, v);
+  }
+};
+
+//[ strict_variant_encode_sort_key
+/***
+ * Append the sort key of a variant to a byte sink.
+ */
+template <typename... Ts, typename Sink>
+inline void
+encode_sort_key(const variant<Ts...> & v, Sink & sink) {
+  sort_key_encoder<variant<Ts...>>::encode(v, sink);
+}
+//]
+
+} // end namespace strict_variant
@@ -6,7 +6,9 @@
 #pragma once
 
 #include <new>
+#include <strict_variant/mpl/find_with.hpp>
 #include <strict_variant/mpl/max.hpp>
+#include <strict_variant/mpl/std_traits.hpp>
 #include <strict_variant/mpl/typelist.hpp>
 #include <strict_variant/wrapper.hpp>
 #include <utility>
@@ -50,6 +52,14 @@ struct storage {
   // align = max align of each thing
   static constexpr size_t m_align = mpl::max<Alignof, First, Types...>::value;
 
+  // uniform_size = each thing has the same size, so all of the storage is in use
+  template <typename T>
+  struct Has_Max_Size {
+    static constexpr bool value = (sizeof(T) == m_size);
+  };
+
+  static constexpr bool uniform_size = mpl::All_Have<Has_Max_Size, First, Types...>::value;
+
   /***
    * Storage
    */
@@ -113,5 +123,34 @@ struct storage {
   }
 };
 
+/***
+ * References to the values of two variants, both at the same index.
+ */
+template <typename T>
+struct value_pair {
+  T & first;
+  T & second;
+};
+
+/***
+ * Pair of storages which are known to hold the same type. Has the same
+ * `get_value` interface as `storage`, so that the dispatch mechanism can visit
+ * both values with a single test of `which`.
+ */
+template <typename Storage>
+struct storage_pair {
+  Storage & m_first;
+  Storage & m_second;
+
+  template <size_t index, typename Internal>
+  using value_ref_t = decltype(std::declval<Storage &>().template get_value<index>(Internal{}));
+
+  template <size_t index, typename Internal>
+  value_pair<mpl::remove_reference_t<value_ref_t<index, Internal>>> get_value(Internal) const {
+    return {m_first.template get_value<index>(Internal{}),
+            m_second.template get_value<index>(Internal{})};
+  }
+};
+
 } // end namespace detail
 } // end namespace strict_variant
@@ -0,0 +1,223 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Traversals of trees of recursive variants, which use an explicit stack on
+ * the heap rather than recursion, so that the depth of a tree is limited only
+ * by memory.
+ *
+ * The shape of the tree is given by a `children` visitor. For the value of
+ * each node, `children(value, push)` is called, and calls `push(child)` for
+ * each child, in order. The children are variants of the same type as the
+ * tree. For example,
+ *
+ *   struct expr_children {
+ *     template <typename Push>
+ *     void operator()(const binop & b, Push & push) const {
+ *       push(b.lhs);
+ *       push(b.rhs);
+ *     }
+ *     template <typename T, typename Push>
+ *     void operator()(const T &, Push &) const {}
+ *   };
+ *
+ * `visit_preorder` and `visit_postorder` call an ordinary visitor on each
+ * node. `fold_tree` computes a value for each node from the values of its
+ * children, bottom up.
+ */
+
+#include <strict_variant/mpl/std_traits.hpp>
+#include <strict_variant/variant.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+//[ strict_variant_child_pusher
+/***
+ * The `push` handle passed to a `children` visitor.
+ */
+template <typename V>
+class child_pusher {
+  std::vector<const V *> & m_stack;
+
+public:
+  explicit child_pusher(std::vector<const V *> & stack) noexcept
+    : m_stack(stack) {}
+
+  void operator()(const V & child) { m_stack.push_back(&child); }
+};
+//]
+
+namespace detail {
+
+template <typename Children, typename V>
+struct children_caller {
+  Children & children;
+  child_pusher<V> & push;
+
+  template <typename T>
+  void operator()(const T & t) const {
+    children(t, push);
+  }
+};
+
+// Push the children of `node` onto the stack, the first child on top
+template <typename V, typename Children>
+std::size_t
+push_children(const V & node, Children & children, std::vector<const V *> & stack) {
+  const std::size_t size = stack.size();
+  child_pusher<V> push{stack};
+  apply_visitor(children_caller<Children, V>{children, push}, node);
+  std::reverse(stack.begin() + static_cast<std::ptrdiff_t>(size), stack.end());
+  return stack.size() - size;
+}
+
+} // end namespace detail
+
+//[ strict_variant_visit_preorder
+/***
+ * Call `apply_visitor(visitor, node)` for each node of the tree, parents
+ * before their children.
+ */
+template <typename V, typename Children, typename Visitor>
+void
+visit_preorder(const V & tree, Children && children, Visitor && visitor) {
+  std::vector<const V *> stack{&tree};
+  while (!stack.empty()) {
+    const V * node = stack.back();
+    stack.pop_back();
+    apply_visitor(visitor, *node);
+    detail::push_children(*node, children, stack);
+  }
+}
+//]
+
+//[ strict_variant_visit_postorder
+/***
+ * Call `apply_visitor(visitor, node)` for each node of the tree, children
+ * before their parents.
+ */
+template <typename V, typename Children, typename Visitor>
+void
+visit_postorder(const V & tree, Children && children, Visitor && visitor) {
+  // Nodes whose children are on `pending`, and the size of `pending` when
+  // they were expanded
+  std::vector<std::pair<const V *, std::size_t>> expanded;
+  std::vector<const V *> pending{&tree};
+
+  while (!pending.empty()) {
+    if (!expanded.empty() && expanded.back().second == pending.size()) {
+      apply_visitor(visitor, *expanded.back().first);
+      expanded.pop_back();
+      continue;
+    }
+    const V * node = pending.back();
+    pending.pop_back();
+    expanded.emplace_back(node, pending.size());
+    detail::push_children(*node, children, pending);
+  }
+  while (!expanded.empty()) {
+    apply_visitor(visitor, *expanded.back().first);
+    expanded.pop_back();
+  }
+}
+//]
+
+//[ strict_variant_child_results
+/***
+ * The results for the children of a node, in order, passed to a `fold_tree`
+ * visitor.
+ */
+template <typename R>
+class child_results {
+  const R * m_first;
+  std::size_t m_size;
+
+public:
+  child_results(const R * first, std::size_t size) noexcept
+    : m_first(first)
+    , m_size(size) {}
+
+  std::size_t size() const noexcept { return m_size; }
+  bool empty() const noexcept { return !m_size; }
+  const R * begin() const noexcept { return m_first; }
+  const R * end() const noexcept { return m_first + m_size; }
+  const R & operator[](std::size_t i) const noexcept { return m_first[i]; }
+};
+//]
+
+namespace detail {
+
+template <typename R, typename Visitor>
+struct fold_caller {
+  Visitor & visitor;
+  child_results<R> results;
+
+  template <typename T>
+  R operator()(const T & t) const {
+    return visitor(t, results);
+  }
+};
+
+} // end namespace detail
+
+//[ strict_variant_fold_tree
+/***
+ * Fold a tree to a value of type `R`, bottom up. For the value of each node,
+ * `visitor(value, results)` is called, where `results` is a
+ * `child_results<R>` holding the results for its children, and returns the
+ * result for the node.
+ */
+template <typename R, typename V, typename Children, typename Visitor>
+R
+fold_tree(const V & tree, Children && children, Visitor && visitor) {
+  // Nodes whose children are on `pending`, the size of `pending` when they
+  // were expanded, and their number of children
+  struct frame {
+    const V * node;
+    std::size_t pending_size;
+    std::size_t num_children;
+  };
+
+  std::vector<frame> expanded;
+  std::vector<const V *> pending{&tree};
+  std::vector<R> results;
+
+  const auto finish = [&]() {
+    const frame f = expanded.back();
+    expanded.pop_back();
+    const std::size_t first = results.size() - f.num_children;
+    R r = apply_visitor(
+      detail::fold_caller<R, mpl::remove_reference_t<Visitor>>{
+        visitor, child_results<R>{results.data() + first, f.num_children}},
+      *f.node);
+    results.erase(results.begin() + static_cast<std::ptrdiff_t>(first), results.end());
+    results.push_back(std::move(r));
+  };
+
+  while (!pending.empty()) {
+    if (!expanded.empty() && expanded.back().pending_size == pending.size()) {
+      finish();
+      continue;
+    }
+    const V * node = pending.back();
+    pending.pop_back();
+    const std::size_t size = pending.size();
+    expanded.push_back(frame{node, size, detail::push_children(*node, children, pending)});
+  }
+  while (!expanded.empty()) {
+    finish();
+  }
+  return std::move(results.back());
+}
+//]
+
+} // end namespace strict_variant
@@ -0,0 +1,396 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+/***
+ * Views of serialized variants.
+ *
+ * `variant_view<Ts...>` refers to a `variant<Ts...>` which was written by
+ * `serialize`, inside a buffer (such as a memory-mapped file). It has `which()`
+ * and may be visited using `apply_visitor`, like a variant, but nothing is
+ * deserialized. The visitor is passed a view of the contained value:
+ *
+ * - Trivially copyable types are passed by value. (The serialized form is not
+ *   aligned, so they are copied out with `memcpy`.)
+ * - `std::string` is passed as a `string_ref`.
+ * - `std::vector<T>` is passed as a `vector_ref<T>`, whose elements are views.
+ * - Nested variants are passed as a `variant_view`.
+ * - `recursive_wrapper` is transparent.
+ *
+ * Specialize `view_traits` to support other types.
+ *
+ * `variant_array_view<V>` indexes a buffer holding a sequence of serialized
+ * `V`'s, for random access. Building the index checks the whole buffer, so
+ * views obtained from it may not fail. The buffer must outlive the views.
+ *
+ * Like `deserialize`, `skip` rejects values nested more deeply than the depth
+ * limit of the `byte_source`, so that checking corrupt input cannot exhaust
+ * the stack. A view uses up the same part of the limit as `skip` did.
+ */
+
+#include <strict_variant/mpl/typelist.hpp>
+#include <strict_variant/mpl/ulist.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_dispatch.hpp>
+#include <strict_variant/variant_serialize.hpp>
+#include <strict_variant/variant_storage.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace strict_variant {
+
+//[ strict_variant_view_traits
+template <typename T, typename ENABLE = void>
+struct view_traits;
+// {
+//   using view_type = ...;
+//
+//   // Consume a serialized value. Return false if the input is bad, or nested
+//   // too deeply, as counted by `src.enter()` and `src.leave()`.
+//   static bool skip(byte_source &);
+//
+//   // Make a view of the serialized value at `src.pos`, which `skip` accepted.
+//   static view_type view(const byte_source & src);
+// };
+//]
+
+template <typename... Ts>
+class variant_view;
+
+/***
+ * A view of a serialized string
+ */
+class string_ref {
+  const char * m_data;
+  std::size_t m_size;
+
+public:
+  string_ref(const char * data, std::size_t size) noexcept
+    : m_data(data)
+    , m_size(size) {}
+
+  const char * data() const noexcept { return m_data; }
+  std::size_t size() const noexcept { return m_size; }
+  bool empty() const noexcept { return !m_size; }
+
+  const char * begin() const noexcept { return m_data; }
+  const char * end() const noexcept { return m_data + m_size; }
+
+  std::string str() const { return std::string(m_data, m_size); }
+
+#if __cplusplus >= 201703L
+  operator std::string_view() const noexcept { return std::string_view(m_data, m_size); }
+#endif
+
+  bool operator==(const string_ref & o) const noexcept {
+    return m_size == o.m_size && (!m_size || std::memcmp(m_data, o.m_data, m_size) == 0);
+  }
+  bool operator!=(const string_ref & o) const noexcept { return !(*this == o); }
+};
+
+/***
+ * A view of a serialized vector. The elements are visited in order using the
+ * iterators. If the elements are trivially copyable, they may also be accessed
+ * by index.
+ */
+template <typename T>
+class vector_ref {
+  using traits = view_traits<T>;
+
+  byte_source m_src; // positioned at the first element
+  std::size_t m_size;
+
+public:
+  using value_type = typename traits::view_type;
+
+  vector_ref(const byte_source & src, std::size_t size) noexcept
+    : m_src(src)
+    , m_size(size) {}
+
+  std::size_t size() const noexcept { return m_size; }
+  bool empty() const noexcept { return !m_size; }
+
+  class iterator {
+    byte_source m_src;
+    std::size_t m_idx;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename traits::view_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = value_type;
+
+    iterator(const byte_source & src, std::size_t idx) noexcept
+      : m_src(src)
+      , m_idx(idx) {}
+
+    value_type operator*() const { return traits::view(m_src); }
+
+    iterator & operator++() {
+      traits::skip(m_src);
+      ++m_idx;
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator result{*this};
+      ++*this;
+      return result;
+    }
+
+    bool operator==(const iterator & o) const noexcept { return m_idx == o.m_idx; }
+    bool operator!=(const iterator & o) const noexcept { return m_idx != o.m_idx; }
+  };
+
+  iterator begin() const noexcept { return iterator{m_src, 0}; }
+  iterator end() const noexcept { return iterator{m_src, m_size}; }
+
+  template <typename U = T>
+  mpl::enable_if_t<std::is_trivially_copyable<U>::value && !is_variant<U>::value, value_type>
+  operator[](std::size_t idx) const {
+    byte_source src{m_src};
+    src.pos += idx * sizeof(T);
+    return traits::view(src);
+  }
+};
+
+namespace detail {
+
+// Reads a which value that was already checked
+template <std::size_t num_types>
+inline unsigned
+read_checked_tag(byte_source & src) noexcept {
+  std::size_t which = 0;
+  tag_codec<num_types>::read(src, which);
+  return static_cast<unsigned>(which);
+}
+
+// Skips value type `idx` of a list of value types
+template <typename TL, unsigned idx>
+bool
+skip_alternative(byte_source & src) {
+  return view_traits<unwrap_type_t<mpl::Index_At<TL, idx>>>::skip(src);
+}
+
+template <typename TL, typename UL>
+struct skip_table;
+
+template <typename TL, unsigned... us>
+struct skip_table<TL, mpl::ulist<us...>> {
+  using function_t = bool (*)(byte_source &);
+
+  static function_t get(std::size_t idx) {
+    static constexpr function_t table[] = {&skip_alternative<TL, us>...};
+    return table[idx];
+  }
+};
+
+// Plays the role of the storage of a variant, for the dispatch mechanism in
+// `variant_dispatch.hpp`. `get_value` makes a view of the contained value.
+template <typename... Ts>
+struct serialized_storage {
+  byte_source payload;
+
+  template <unsigned index>
+  typename view_traits<unwrap_type_t<mpl::Index_At<mpl::TypeList<Ts...>, index>>>::view_type
+  get_value(detail::false_) const {
+    return view_traits<unwrap_type_t<mpl::Index_At<mpl::TypeList<Ts...>, index>>>::view(payload);
+  }
+};
+
+} // end namespace detail
+
+//[ strict_variant_variant_view
+/***
+ * A view of a serialized `variant<Ts...>`
+ */
+template <typename... Ts>
+class variant_view {
+  using storage_t = detail::serialized_storage<Ts...>;
+
+  storage_t m_storage;
+  unsigned m_which;
+
+public:
+  /***
+   * Make a view of the serialized variant at `src.pos`. It must have been
+   * accepted by `view_traits<variant<Ts...>>::skip`.
+   */
+  explicit variant_view(const byte_source & src) noexcept
+    : m_storage{src}
+    , m_which(detail::read_checked_tag<sizeof...(Ts)>(m_storage.payload)) {}
+
+  int which() const noexcept { return static_cast<int>(m_which); }
+
+  // Implementation details for apply_visitor
+  using dispatcher_t = detail::visitor_dispatch<detail::false_, sizeof...(Ts)>;
+
+#define APPLY_VISITOR_IMPL_BODY                                                                    \
+  dispatcher_t{}(visitable.m_which, visitable.m_storage, std::forward<Visitor>(visitor))
+
+  template <typename Visitor, typename Visitable>
+  static auto apply_visitor_impl(Visitor && visitor, Visitable && visitable)
+    -> decltype(APPLY_VISITOR_IMPL_BODY) {
+    static_assert(std::is_same<const variant_view, const mpl::remove_reference_t<Visitable>>::value,
+                  "Misuse of apply_visitor_impl!");
+    return APPLY_VISITOR_IMPL_BODY;
+  }
+
+#undef APPLY_VISITOR_IMPL_BODY
+
+  template <typename V>
+  auto visit(V && v) const -> decltype(apply_visitor_impl(std::forward<V>(v), *this)) {
+    return apply_visitor_impl(std::forward<V>(v), *this);
+  }
+};
+//]
+
+// Trivially copyable types are copied out of the buffer
+template <typename T>
+struct view_traits<T, mpl::enable_if_t<std::is_trivially_copyable<T>::value
+                                       && !is_variant<T>::value>> {
+  static_assert(!detail::is_address<T>::value, "Pointers may not be serialized!");
+
+  using view_type = T;
+
+  static bool skip(byte_source & src) noexcept {
+    const unsigned char * p = src.take(sizeof(T));
+    return p && detail::valid_raw_values<T>(p, 1);
+  }
+
+  static view_type view(const byte_source & src) noexcept {
+    detail::raw_value<T> v;
+    std::memcpy(&v.storage, src.pos, sizeof(T));
+    return v.get();
+  }
+};
+
+template <>
+struct view_traits<std::string> {
+  using view_type = string_ref;
+
+  static bool skip(byte_source & src) noexcept {
+    std::uint64_t n;
+    return detail::get_varint(src, n) && n <= src.remaining()
+           && src.take(static_cast<std::size_t>(n));
+  }
+
+  static view_type view(const byte_source & src) noexcept {
+    byte_source s{src};
+    std::uint64_t n;
+    detail::get_varint(s, n);
+    return string_ref{reinterpret_cast<const char *>(s.pos), static_cast<std::size_t>(n)};
+  }
+};
+
+template <typename T>
+struct view_traits<std::vector<T>> {
+  using view_type = vector_ref<T>;
+
+  static bool skip(byte_source & src) {
+    std::uint64_t n;
+    if (!detail::get_varint(src, n)) { return false; }
+    if (std::is_trivially_copyable<T>::value && !is_variant<T>::value) {
+      if (n > src.remaining() / sizeof(T)) { return false; }
+      const unsigned char * p = src.take(static_cast<std::size_t>(n) * sizeof(T));
+      return detail::valid_raw_values<T>(p, static_cast<std::size_t>(n));
+    }
+    // Each element is at least one byte
+    if (n > src.remaining() || !src.enter()) { return false; }
+    bool ok = true;
+    for (std::uint64_t i = 0; ok && i < n; ++i) {
+      ok = view_traits<T>::skip(src);
+    }
+    src.leave();
+    return ok;
+  }
+
+  static view_type view(const byte_source & src) noexcept {
+    byte_source s{src};
+    std::uint64_t n;
+    detail::get_varint(s, n);
+    if (!std::is_trivially_copyable<T>::value || is_variant<T>::value) { s.enter(); }
+    return view_type{s, static_cast<std::size_t>(n)};
+  }
+};
+
+template <typename... Ts>
+struct view_traits<variant<Ts...>> {
+  using view_type = variant_view<Ts...>;
+
+  static bool skip(byte_source & src) {
+    using table_t = detail::skip_table<mpl::TypeList<Ts...>, mpl::count_t<sizeof...(Ts)>>;
+
+    std::size_t which;
+    if (!src.enter()) { return false; }
+    const bool ok = detail::tag_codec<sizeof...(Ts)>::read(src, which) && table_t::get(which)(src);
+    src.leave();
+    return ok;
+  }
+
+  // `skip` accepted the value, so there is a level left to enter
+  static view_type view(const byte_source & src) noexcept {
+    byte_source s{src};
+    s.enter();
+    return view_type{s};
+  }
+};
+
+//[ strict_variant_variant_array_view
+/***
+ * An index of a buffer holding a sequence of variants of type `V`, written by
+ * `serialize`, giving random access to views of them.
+ */
+template <typename V>
+class variant_array_view {
+  const unsigned char * m_end = nullptr;
+  std::vector<const unsigned char *> m_index;
+
+public:
+  using view_type = typename view_traits<V>::view_type;
+
+  /***
+   * Index the buffer. Returns false if it does not hold a sequence of
+   * serialized `V`'s, in which case the view is empty.
+   */
+  bool assign(const void * data, std::size_t size) {
+    m_index.clear();
+    byte_source src{data, size};
+    m_end = src.end;
+    while (src.remaining()) {
+      const unsigned char * pos = src.pos;
+      if (!view_traits<V>::skip(src)) {
+        m_index.clear();
+        return false;
+      }
+      m_index.push_back(pos);
+    }
+    return true;
+  }
+
+  std::size_t size() const noexcept { return m_index.size(); }
+  bool empty() const noexcept { return m_index.empty(); }
+
+  view_type operator[](std::size_t idx) const noexcept {
+    const unsigned char * pos = m_index[idx];
+    return view_traits<V>::view(byte_source{pos, static_cast<std::size_t>(m_end - pos)});
+  }
+};
+//]
+
+} // end namespace strict_variant
@@ -0,0 +1,148 @@
+//  (C) Copyright 2016 - 2018 Christopher Beck
+
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_algorithm.hpp>
+#include <strict_variant/variant_compare.hpp>
+#include <strict_variant/variant_relational_ops.hpp>
+#include <strict_variant/variant_stream_ops.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Test algorithms over ranges of variants
+
+using namespace strict_variant;
+
+template <typename V>
+void
+test_ranges_equal(std::vector<V> a) {
+  std::vector<V> b = a;
+  TEST_TRUE(ranges_equal(a.data(), a.data() + a.size(), b.data()));
+  TEST_TRUE(ranges_equal(a.begin(), a.end(), b.begin()));
+  TEST_TRUE(ranges_equal(a.data(), a.data(), b.data()));
+
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    V temp = b[i];
+    b[i] = a[(i + 1) % a.size()];
+    TEST_FALSE(ranges_equal(a.data(), a.data() + a.size(), b.data()));
+    TEST_FALSE(ranges_equal(a.begin(), a.end(), b.begin()));
+    b[i] = temp;
+    TEST_TRUE(ranges_equal(a.data(), a.data() + a.size(), b.data()));
+  }
+}
+
+UNIT_TEST(ranges_equal_bitwise) {
+  using var_t = variant<int, unsigned int>;
+  static_assert(is_bitwise_comparable<var_t>::value, "failed a unit test");
+
+  test_ranges_equal<var_t>({var_t{1}, var_t{1u}, var_t{2}, var_t{-1}, var_t{0u}});
+}
+
+UNIT_TEST(ranges_equal_padded) {
+  using var_t = variant<long long, unsigned long long>;
+  static_assert(!is_bitwise_comparable<var_t>::value, "failed a unit test");
+
+  test_ranges_equal<var_t>({var_t{1ll}, var_t{1ull}, var_t{2ll}, var_t{-1ll}, var_t{0ull}});
+}
+
+UNIT_TEST(ranges_equal_general) {
+  using var_t = variant<int, recursive_wrapper<std::string>, double>;
+
+  test_ranges_equal<var_t>({var_t{1}, var_t{"a"}, var_t{1.0}, var_t{"b"}, var_t{2}});
+
+  std::list<var_t> l{var_t{1}, var_t{"a"}};
+  std::vector<var_t> v{var_t{1}, var_t{"a"}};
+  TEST_TRUE(ranges_equal(l.begin(), l.end(), v.begin()));
+  v[1] = "b";
+  TEST_FALSE(ranges_equal(l.begin(), l.end(), v.begin()));
+}
+
+// Check strict_variant::sort_by_which against std::sort with variant_comparator
+template <template <typename> class ComparatorTemplate = std::less, typename V>
+bool
+sorts_like_comparator(std::vector<V> vec, unsigned num_threads) {
+  std::vector<V> expected = vec;
+  std::sort(expected.begin(), expected.end(), variant_comparator<V, ComparatorTemplate>{});
+  strict_variant::sort_by_which<ComparatorTemplate>(vec.begin(), vec.end(), num_threads);
+  return vec == expected;
+}
+
+using sort_var_t = variant<int, recursive_wrapper<std::string>, double>;
+
+std::vector<sort_var_t>
+make_sort_input(std::size_t n, unsigned skew) {
+  std::mt19937 rng{422911};
+  std::vector<sort_var_t> vec;
+  for (std::size_t i = 0; i < n; ++i) {
+    const unsigned x = static_cast<unsigned>(rng() % 1000);
+    if (rng() % skew) {
+      vec.emplace_back(static_cast<int>(x) - 500);
+    } else if (x % 2) {
+      vec.emplace_back(std::to_string(x));
+    } else {
+      vec.emplace_back(x / 7.0);
+    }
+  }
+  return vec;
+}
+
+UNIT_TEST(sort_small) {
+  TEST_TRUE(sorts_like_comparator(std::vector<sort_var_t>{}, 1));
+  TEST_TRUE(sorts_like_comparator(std::vector<sort_var_t>{sort_var_t{"a"}}, 1));
+  TEST_TRUE(sorts_like_comparator(
+    std::vector<sort_var_t>{sort_var_t{2.0}, sort_var_t{"b"}, sort_var_t{1}, sort_var_t{"a"},
+                            sort_var_t{1.0}, sort_var_t{0}, sort_var_t{3}},
+    1));
+  TEST_TRUE(sorts_like_comparator<std::greater>(
+    std::vector<sort_var_t>{sort_var_t{2.0}, sort_var_t{"b"}, sort_var_t{1}, sort_var_t{"a"},
+                            sort_var_t{1.0}, sort_var_t{0}, sort_var_t{3}},
+    1));
+}
+
+UNIT_TEST(sort_large) {
+  // Large enough to sort the buckets in parallel
+  for (unsigned skew : {1u, 2u, 100u}) {
+    for (unsigned threads : {1u, 2u, 4u}) {
+      TEST_TRUE(sorts_like_comparator(make_sort_input(100000, skew), threads));
+    }
+  }
+}
+
+// A comparator which throws, to check that exceptions from workers propagate
+template <typename T>
+struct throwing_less {
+  bool operator()(const T &, const T &) const { throw std::runtime_error("throwing_less"); }
+};
+
+UNIT_TEST(sort_exception) {
+  std::vector<sort_var_t> vec = make_sort_input(100000, 2);
+  bool caught = false;
+  try {
+    strict_variant::sort_by_which<throwing_less>(vec.begin(), vec.end(), 4);
+  } catch (std::runtime_error &) { caught = true; }
+  TEST_TRUE(caught);
+}
+
+// The usual idiom for calling sort finds only std::sort by ADL
+UNIT_TEST(sort_adl) {
+  std::vector<strict_variant::variant<int, double>> vec{2.5, 1, 0.5};
+  using std::sort;
+  sort(vec.begin(), vec.end());
+  TEST_EQ(1, *strict_variant::get<int>(&vec[0]));
+}
+
+int
+main() {
+  std::cout << "Variant algorithm tests:" << std::endl;
+  return test_registrar::run_tests();
+}
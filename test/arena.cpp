@@ -0,0 +1,140 @@
+#include <strict_variant/arena_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace strict_variant {
+
+// An expression tree, whose nodes are in an arena
+struct binop;
+using expr_t = variant<int, arena_wrapper<binop>>;
+
+struct binop {
+  char op;
+  expr_t lhs;
+  expr_t rhs;
+};
+
+struct eval_visitor {
+  int operator()(int i) const { return i; }
+  int operator()(const binop & b) const {
+    const int l = apply_visitor(*this, b.lhs);
+    const int r = apply_visitor(*this, b.rhs);
+    return b.op == '-' ? l - r : l * r;
+  }
+};
+
+// (0 - 1) * ((1 - 2) * (... * 1)). Moving a variant moves the value in the
+// wrapper, which would copy the tree into the arena, so the tree is built
+// from the root.
+expr_t
+make_expr(int n) {
+  expr_t result{1};
+  expr_t * tail = &result;
+  for (int i = 0; i < n; ++i) {
+    tail->emplace<binop>(binop{'*', expr_t{binop{'-', expr_t{i}, expr_t{i + 1}}}, expr_t{1}});
+    tail = &get<binop>(tail)->rhs;
+  }
+  return result;
+}
+
+UNIT_TEST(arena_scoped) {
+  bump_arena arena{256};
+  {
+    arena_scope scope{arena};
+    const expr_t e = make_expr(3);
+    TEST_EQ(-1, apply_visitor(eval_visitor{}, e));
+    TEST_TRUE(arena.bytes_used() >= 6 * sizeof(binop));
+
+    // Copies are allocated from the arena too
+    const std::size_t used = arena.bytes_used();
+    const expr_t copy{e};
+    TEST_EQ(-1, apply_visitor(eval_visitor{}, copy));
+    TEST_TRUE(arena.bytes_used() > used);
+  }
+  arena.release();
+  TEST_EQ(0, arena.bytes_used());
+
+  // The arena is reused, and grows beyond its first block
+  {
+    arena_scope scope{arena};
+    const expr_t e = make_expr(1000);
+    TEST_EQ(1, apply_visitor(eval_visitor{}, e));
+  }
+  arena.release();
+}
+
+UNIT_TEST(arena_nested_scopes) {
+  bump_arena outer;
+  bump_arena inner;
+  arena_scope s1{outer};
+  {
+    arena_scope s2{inner};
+    expr_t e{binop{'-', expr_t{1}, expr_t{2}}};
+    TEST_EQ(sizeof(binop), inner.bytes_used());
+    TEST_EQ(0, outer.bytes_used());
+  }
+  expr_t e{binop{'-', expr_t{1}, expr_t{2}}};
+  TEST_EQ(sizeof(binop), outer.bytes_used());
+}
+
+UNIT_TEST(arena_thread_default) {
+  {
+    const expr_t e = make_expr(11);
+    TEST_EQ(-1, apply_visitor(eval_visitor{}, e));
+  }
+  TEST_TRUE(thread_arena::get().bytes_used() > 0);
+  thread_arena::get().release();
+  TEST_EQ(0, thread_arena::get().bytes_used());
+}
+
+// Nodes are not destroyed, and are aligned
+struct alignas(32) aligned_node {
+  static int destroyed;
+
+  double value;
+
+  explicit aligned_node(double v)
+    : value(v) {}
+  aligned_node(const aligned_node &) = default;
+  ~aligned_node() noexcept { ++destroyed; }
+};
+
+int aligned_node::destroyed = 0;
+
+UNIT_TEST(arena_no_destructors) {
+  bump_arena arena;
+  arena_scope scope{arena};
+  {
+    variant<int, arena_wrapper<aligned_node>> v{aligned_node{1.5}};
+    for (int i = 0; i < 10; ++i) {
+      char * c = static_cast<char *>(arena.allocate(1, 1));
+      *c = 'x';
+      v.emplace<aligned_node>(2.5);
+      TEST_EQ(0u, reinterpret_cast<std::uintptr_t>(get<aligned_node>(&v)) % 32);
+    }
+    TEST_EQ(2.5, get<aligned_node>(&v)->value);
+  }
+  // Only the temporary was destroyed
+  TEST_EQ(1, aligned_node::destroyed);
+}
+
+UNIT_TEST(arena_large_allocation) {
+  bump_arena arena{64};
+  void * p = arena.allocate(100000, 8);
+  TEST_TRUE(p != nullptr);
+  void * q = arena.allocate(8, 8);
+  TEST_TRUE(q != p);
+  TEST_EQ(100008, arena.bytes_used());
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Arena tests:" << std::endl;
+  return test_registrar::run_tests();
+}
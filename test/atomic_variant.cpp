@@ -0,0 +1,135 @@
+#include <strict_variant/atomic_variant.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace strict_variant {
+
+enum class Mode : std::uint8_t { off, on, automatic };
+
+struct triple {
+  std::int64_t a;
+  std::int64_t b;
+  std::int64_t c;
+};
+
+using small_t = atomic_variant<std::int32_t, float, Mode>;
+using large_t = atomic_variant<std::int32_t, triple>;
+
+static_assert(small_t::is_always_lock_free, "Expected a lock-free atomic_variant");
+static_assert(!large_t::is_always_lock_free, "Expected a seqlock");
+
+UNIT_TEST(atomic_variant_small) {
+  small_t a{Mode::on};
+  TEST_TRUE(a.is_lock_free());
+  TEST_TRUE(a.load() == small_t::value_type{Mode::on});
+
+  a.store(std::int32_t{5});
+  TEST_TRUE(a.load() == small_t::value_type{std::int32_t{5}});
+
+  small_t::value_type old = a.exchange(1.5f);
+  TEST_EQ(5, *get<std::int32_t>(&old));
+  TEST_TRUE(a.load() == small_t::value_type{1.5f});
+
+  // The type is compared, as well as the value
+  small_t::value_type expected{std::int32_t{0}};
+  a.store(Mode::off);
+  TEST_FALSE(a.compare_exchange_strong(expected, Mode::automatic));
+  TEST_TRUE(expected == small_t::value_type{Mode::off});
+  TEST_TRUE(a.compare_exchange_strong(expected, Mode::automatic));
+  TEST_TRUE(a.load() == small_t::value_type{Mode::automatic});
+
+  small_t b;
+  TEST_TRUE(b.load() == small_t::value_type{std::int32_t{0}});
+}
+
+UNIT_TEST(atomic_variant_large) {
+  large_t a{triple{1, 2, 3}};
+  TEST_FALSE(a.is_lock_free());
+  TEST_EQ(3, a.load().get_unchecked<triple>().c);
+
+  large_t::value_type old = a.exchange(std::int32_t{7});
+  TEST_EQ(2, get<triple>(&old)->b);
+  TEST_EQ(7, a.load().get_unchecked<std::int32_t>());
+
+  large_t::value_type expected{triple{1, 2, 3}};
+  TEST_FALSE(a.compare_exchange_strong(expected, triple{4, 5, 6}));
+  TEST_EQ(7, *get<std::int32_t>(&expected));
+  TEST_TRUE(a.compare_exchange_weak(expected, triple{4, 5, 6}));
+  TEST_EQ(6, a.load().get_unchecked<triple>().c);
+}
+
+// Each writer increments the counter, with a CAS loop, and readers check that
+// values are never torn
+template <typename A, typename Make, typename Check>
+bool
+contend(A & a, Make make, Check check) {
+  constexpr int num_writers = 3;
+  constexpr int num_readers = 3;
+  constexpr int increments = 5000;
+
+  std::atomic<bool> torn{false};
+  std::atomic<int> writing{num_writers};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_writers; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < increments; ++i) {
+        typename A::value_type expected = a.load();
+        while (!a.compare_exchange_weak(expected, make(check(expected) + 1))) {}
+      }
+      --writing;
+    });
+  }
+  for (int t = 0; t < num_readers; ++t) {
+    threads.emplace_back([&]() {
+      while (writing.load()) {
+        if (check(a.load()) < 0) { torn = true; }
+      }
+    });
+  }
+  for (std::thread & t : threads) {
+    t.join();
+  }
+  return !torn && check(a.load()) == num_writers * increments;
+}
+
+UNIT_TEST(atomic_variant_contention) {
+  // Odd counts are floats, and even counts are ints
+  small_t small{std::int32_t{0}};
+  TEST_TRUE(contend(small,
+                    [](std::int64_t n) {
+                      return n % 2 ? small_t::value_type{static_cast<float>(n)}
+                                   : small_t::value_type{static_cast<std::int32_t>(n)};
+                    },
+                    [](const small_t::value_type & v) -> std::int64_t {
+                      if (const float * f = get<float>(&v)) { return static_cast<std::int64_t>(*f); }
+                      if (const std::int32_t * i = get<std::int32_t>(&v)) { return *i; }
+                      return -1;
+                    }));
+
+  // The fields of a triple are equal
+  large_t large{std::int32_t{0}};
+  TEST_TRUE(contend(large,
+                    [](std::int64_t n) {
+                      return n % 2 ? large_t::value_type{triple{n, n, n}}
+                                   : large_t::value_type{static_cast<std::int32_t>(n)};
+                    },
+                    [](const large_t::value_type & v) -> std::int64_t {
+                      if (const triple * t = get<triple>(&v)) {
+                        return (t->a == t->b && t->b == t->c) ? t->a : -1;
+                      }
+                      return *get<std::int32_t>(&v);
+                    }));
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Atomic variant tests:" << std::endl;
+  return test_registrar::run_tests();
+}
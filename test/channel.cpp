@@ -0,0 +1,207 @@
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_channel.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace strict_variant {
+
+struct ping {
+  int from;
+  int seq;
+};
+
+struct text {
+  int from;
+  std::string body;
+};
+
+// Counts live instances, and may throw when constructed
+struct tracked {
+  static int live;
+
+  explicit tracked(bool fail) {
+    if (fail) { throw std::runtime_error("tracked"); }
+    ++live;
+  }
+  tracked(const tracked &) { ++live; }
+  tracked(tracked &&) noexcept { ++live; }
+  tracked & operator=(const tracked &) = default;
+  tracked & operator=(tracked &&) noexcept = default;
+  ~tracked() noexcept { --live; }
+};
+
+int tracked::live = 0;
+
+using msg_t = variant<ping, text, tracked>;
+
+struct record_visitor {
+  std::vector<std::string> & out;
+
+  void operator()(const ping & p) const {
+    out.push_back("ping " + std::to_string(p.from) + " " + std::to_string(p.seq));
+  }
+  void operator()(const text & t) const { out.push_back("text " + t.body); }
+  void operator()(const tracked &) const { out.push_back("tracked"); }
+};
+
+struct throw_visitor {
+  template <typename T>
+  void operator()(const T &) const {
+    throw std::runtime_error("handler");
+  }
+};
+
+UNIT_TEST(channel_basic) {
+  channel<msg_t> c{3};
+  TEST_EQ(4, c.capacity());
+
+  std::vector<std::string> out;
+  TEST_TRUE(c.try_emplace<ping>(ping{0, 1}));
+  TEST_TRUE(c.try_emplace<text>(text{0, "hello"}));
+  TEST_TRUE(c.try_push(msg_t{ping{0, 2}}));
+  TEST_TRUE(c.try_emplace<tracked>(false));
+  TEST_FALSE(c.try_emplace<ping>(ping{0, 3}));
+  TEST_EQ(1, tracked::live);
+
+  TEST_EQ(2, c.drain(record_visitor{out}, 2));
+  TEST_EQ(2, c.drain(record_visitor{out}));
+  TEST_EQ(0, c.drain(record_visitor{out}));
+  TEST_EQ(4, out.size());
+  TEST_EQ("ping 0 1", out[0]);
+  TEST_EQ("text hello", out[1]);
+  TEST_EQ("ping 0 2", out[2]);
+  TEST_EQ("tracked", out[3]);
+  TEST_EQ(0, tracked::live);
+
+  // A constructor which throws leaves a slot which is skipped
+  bool thrown = false;
+  try {
+    c.try_emplace<tracked>(true);
+  } catch (std::runtime_error &) {
+    thrown = true;
+  }
+  TEST_TRUE(thrown);
+  TEST_TRUE(c.try_emplace<ping>(ping{0, 4}));
+  TEST_EQ(2, c.drain(record_visitor{out}));
+  TEST_EQ("ping 0 4", out.back());
+  TEST_EQ(5, out.size());
+
+  // Messages which are not consumed are destroyed with the channel
+  {
+    channel<msg_t> d{8};
+    d.emplace<tracked>(false);
+    d.emplace<tracked>(false);
+    TEST_EQ(2, tracked::live);
+  }
+  TEST_EQ(0, tracked::live);
+}
+
+UNIT_TEST(channel_grouped) {
+  channel<msg_t> c{16};
+  std::vector<std::string> out;
+
+  c.emplace<text>(text{0, "a"});
+  c.emplace<ping>(ping{0, 1});
+  c.emplace<tracked>(false);
+  c.emplace<text>(text{0, "b"});
+  c.emplace<ping>(ping{0, 2});
+  c.emplace<ping>(ping{0, 3});
+
+  TEST_EQ(6, c.drain_grouped(record_visitor{out}));
+  TEST_EQ(6, out.size());
+  TEST_EQ("ping 0 1", out[0]);
+  TEST_EQ("ping 0 2", out[1]);
+  TEST_EQ("ping 0 3", out[2]);
+  TEST_EQ("text a", out[3]);
+  TEST_EQ("text b", out[4]);
+  TEST_EQ("tracked", out[5]);
+  TEST_EQ(0, tracked::live);
+
+  // A batch is limited by `max`
+  for (int i = 0; i < 5; ++i) {
+    c.emplace<ping>(ping{0, i});
+  }
+  TEST_EQ(3, c.drain_grouped(record_visitor{out}, 3));
+  TEST_EQ(2, c.drain_grouped(record_visitor{out}));
+
+  // If the handler throws, the rest of the batch is discarded
+  c.emplace<ping>(ping{0, 0});
+  c.emplace<tracked>(false);
+  bool thrown = false;
+  try {
+    c.drain_grouped(throw_visitor{});
+  } catch (std::runtime_error &) {
+    thrown = true;
+  }
+  TEST_TRUE(thrown);
+  TEST_EQ(0, tracked::live);
+  TEST_EQ(0, c.drain(record_visitor{out}));
+}
+
+UNIT_TEST(channel_producers) {
+  constexpr int num_threads = 4;
+  constexpr int per_thread = 20000;
+  channel<msg_t> c{64};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&c, t]() {
+      for (int i = 0; i < per_thread; ++i) {
+        if (i % 8 == 7) {
+          c.emplace<text>(text{t, std::to_string(i)});
+        } else {
+          c.emplace<ping>(ping{t, i});
+        }
+      }
+    });
+  }
+
+  // Messages of one type from one producer stay in order
+  std::vector<int> next_ping(num_threads, -1);
+  std::vector<int> next_text(num_threads, -1);
+  bool in_order = true;
+  int total = 0;
+  struct check_visitor {
+    std::vector<int> & next_ping;
+    std::vector<int> & next_text;
+    bool & in_order;
+
+    void operator()(const ping & p) const {
+      int & n = next_ping[static_cast<std::size_t>(p.from)];
+      in_order = in_order && p.seq > n;
+      n = p.seq;
+    }
+    void operator()(const text & t) const {
+      int & n = next_text[static_cast<std::size_t>(t.from)];
+      const int seq = std::stoi(t.body);
+      in_order = in_order && seq > n;
+      n = seq;
+    }
+    void operator()(const tracked &) const { in_order = false; }
+  };
+  bool grouped = false;
+  while (total < num_threads * per_thread) {
+    check_visitor v{next_ping, next_text, in_order};
+    total += static_cast<int>(grouped ? c.drain_grouped(v) : c.drain(v, 100));
+    grouped = !grouped;
+  }
+  for (std::thread & t : threads) {
+    t.join();
+  }
+  TEST_TRUE(in_order);
+  TEST_EQ(num_threads * per_thread, total);
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Variant channel tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -0,0 +1,175 @@
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_chars.hpp>
+#include <strict_variant/variant_stream_ops.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <limits>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+namespace strict_variant {
+
+template <typename V>
+std::string
+format(const V & v) {
+  char buf[64];
+  const to_chars_result r = to_chars(buf, buf + sizeof(buf), v);
+  if (r.ec != std::errc{}) { return "error"; }
+  return std::string(buf, r.ptr);
+}
+
+template <typename V>
+std::errc
+parse(const std::string & str, V & v) {
+  const from_chars_result r = from_chars(str.data(), str.data() + str.size(), v);
+  if (r.ec == std::errc{} && r.ptr != str.data() + str.size()) { return std::errc::io_error; }
+  return r.ec;
+}
+
+UNIT_TEST(to_chars) {
+  using var_t = variant<bool, int, unsigned long long, double, std::string>;
+
+  TEST_EQ("true", format(var_t{true}));
+  TEST_EQ("false", format(var_t{false}));
+  TEST_EQ("0", format(var_t{0}));
+  TEST_EQ("-17", format(var_t{-17}));
+  TEST_EQ("-2147483648", format(var_t{std::numeric_limits<int>::min()}));
+  TEST_EQ("18446744073709551615", format(var_t{std::numeric_limits<unsigned long long>::max()}));
+  TEST_EQ("1.5", format(var_t{1.5}));
+  TEST_EQ("asdf", format(var_t{"asdf"}));
+  TEST_EQ("", format(var_t{""}));
+
+  // Not enough room
+  char buf[3];
+  to_chars_result r = to_chars(buf, buf + sizeof(buf), var_t{1234});
+  TEST_TRUE(r.ec == std::errc::value_too_large);
+  TEST_TRUE(r.ptr == buf + sizeof(buf));
+  r = to_chars(buf, buf + sizeof(buf), var_t{123});
+  TEST_TRUE(r.ec == std::errc{});
+  TEST_TRUE(r.ptr == buf + 3);
+
+  // The same as the ostream path, for these values
+  const var_t values[] = {var_t{true}, var_t{42}, var_t{-42}, var_t{"str"}};
+  for (const var_t & v : values) {
+    std::ostringstream ss;
+    ss << std::boolalpha << v;
+    TEST_EQ(ss.str(), format(v));
+  }
+}
+
+UNIT_TEST(floating_round_trip) {
+  variant<double> d{0.0};
+  variant<float> f{0.0f};
+  const double doubles[] = {0.1, -2.5e-300, 1.0 / 3, 123456789.125,
+                            std::numeric_limits<double>::max()};
+  for (double x : doubles) {
+    TEST_TRUE(parse(format(variant<double>{x}), d) == std::errc{});
+    TEST_EQ(x, *get<double>(&d));
+  }
+  const float floats[] = {0.1f, 3.0e38f, 1.0f / 3};
+  for (float x : floats) {
+    TEST_TRUE(parse(format(variant<float>{x}), f) == std::errc{});
+    TEST_EQ(x, *get<float>(&f));
+  }
+}
+
+UNIT_TEST(from_chars) {
+  using var_t = variant<bool, int, long long, double, std::string>;
+  var_t v{false};
+
+  TEST_TRUE(parse("true", v) == std::errc{});
+  TEST_EQ(0, v.which());
+  TEST_EQ(true, *get<bool>(&v));
+
+  TEST_TRUE(parse("-123", v) == std::errc{});
+  TEST_EQ(1, v.which());
+  TEST_EQ(-123, *get<int>(&v));
+
+  TEST_TRUE(parse("-0", v) == std::errc{});
+  TEST_EQ(0, *get<int>(&v));
+
+  // Too large for int, so it is a long long
+  TEST_TRUE(parse("-9223372036854775808", v) == std::errc{});
+  TEST_EQ(2, v.which());
+  TEST_EQ(std::numeric_limits<long long>::min(), *get<long long>(&v));
+
+  TEST_TRUE(parse("2.5e3", v) == std::errc{});
+  TEST_EQ(3, v.which());
+  TEST_EQ(2500.0, *get<double>(&v));
+
+  TEST_TRUE(parse(".5", v) == std::errc{});
+  TEST_EQ(0.5, *get<double>(&v));
+
+  // Anything else is a string
+  const char * strings[] = {"", "True", "12a", "-", "1e", "1.5.", "+1", " 1", "inf", "0x10"};
+  for (const char * s : strings) {
+    TEST_TRUE(parse(s, v) == std::errc{});
+    TEST_EQ(4, v.which());
+    TEST_EQ(s, *get<std::string>(&v));
+  }
+
+  // A number too large for any integer type is a string, when there is one
+  TEST_TRUE(parse("99999999999999999999", v) == std::errc{});
+  TEST_EQ(4, v.which());
+}
+
+UNIT_TEST(from_chars_conversion_rules) {
+  // `short` and `int` would be ambiguous, so `unsigned short` picks `unsigned`
+  variant<unsigned int, long> a{0u};
+  TEST_TRUE(parse("5", a) == std::errc{});
+  TEST_EQ(0, a.which());
+  TEST_EQ(5u, *get<unsigned int>(&a));
+
+  // The variant would convert a negative `short` to `unsigned`, but the value
+  // must fit
+  TEST_TRUE(parse("-5", a) == std::errc{});
+  TEST_EQ(1, a.which());
+  TEST_EQ(-5L, *get<long>(&a));
+
+  variant<unsigned int> b{0u};
+  TEST_TRUE(parse("5", b) == std::errc{});
+  TEST_EQ(5u, *get<unsigned int>(&b));
+  TEST_TRUE(parse("-5", b) == std::errc::result_out_of_range);
+  TEST_TRUE(parse("4294967296", b) == std::errc::result_out_of_range);
+  TEST_EQ(5u, *get<unsigned int>(&b));
+
+  // The smallest accepted type is chosen, as by the variant's constructor
+  variant<long long, long> c{0L};
+  TEST_TRUE(parse("7", c) == std::errc{});
+  TEST_EQ(1, c.which());
+
+  // Integers may be read as floating point, if no integer type is accepted
+  variant<double, std::string> d{0.0};
+  TEST_TRUE(parse("7", d) == std::errc{});
+  TEST_EQ(7.0, *get<double>(&d));
+
+  // But not the other way around
+  variant<int> e{0};
+  TEST_TRUE(parse("7.0", e) == std::errc::invalid_argument);
+  TEST_TRUE(parse("true", e) == std::errc::invalid_argument);
+  TEST_TRUE(parse("x", e) == std::errc::invalid_argument);
+  TEST_EQ(0, *get<int>(&e));
+
+  // `bool` does not take numbers, and is not taken by numbers
+  variant<bool, std::string> f{true};
+  TEST_TRUE(parse("1", f) == std::errc{});
+  TEST_EQ(1, f.which());
+  TEST_TRUE(parse("false", f) == std::errc{});
+  TEST_EQ(0, f.which());
+
+  // A string may be in a recursive_wrapper
+  variant<int, recursive_wrapper<std::string>> g{0};
+  TEST_TRUE(parse("abc", g) == std::errc{});
+  TEST_EQ("abc", *get<std::string>(&g));
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Variant chars tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -0,0 +1,286 @@
+#include <strict_variant/alloc_wrapper.hpp>
+#include <strict_variant/pool_allocator.hpp>
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_cbor.hpp>
+#include <strict_variant/variant_codec.hpp>
+#include <strict_variant/variant_msgpack.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace strict_variant {
+
+// A JSON-like value. A struct derived from the variant, so that it may refer
+// to itself.
+struct json;
+using json_base = variant<std::nullptr_t, bool, int64_t, double, std::string,
+                          recursive_wrapper<std::vector<json>>,
+                          recursive_wrapper<std::map<std::string, json>>>;
+
+struct json : json_base {
+  using json_base::json_base;
+};
+
+template <>
+struct codec_traits<json> : codec_traits<json_base> {};
+
+using json_array = std::vector<json>;
+using json_object = std::map<std::string, json>;
+
+json
+make_document() {
+  json_object inner;
+  inner.emplace("name", json{std::string("sensor")});
+  inner.emplace("ok", json{true});
+  inner.emplace("none", json{nullptr});
+
+  json_array readings;
+  readings.emplace_back(int64_t{1});
+  readings.emplace_back(int64_t{-200});
+  readings.emplace_back(int64_t{1} << 40);
+  readings.emplace_back(2.5);
+  readings.emplace_back(std::string(40, 'x'));
+
+  json_object doc;
+  doc.emplace("inner", json{std::move(inner)});
+  doc.emplace("readings", json{std::move(readings)});
+  doc.emplace("empty", json{json_array{}});
+  return json{std::move(doc)};
+}
+
+template <typename V>
+std::string
+to_msgpack(const V & v) {
+  std::string buffer;
+  encode_msgpack(v, buffer);
+  return buffer;
+}
+
+template <typename V>
+std::string
+to_cbor(const V & v) {
+  std::string buffer;
+  encode_cbor(v, buffer);
+  return buffer;
+}
+
+UNIT_TEST(msgpack_encoding) {
+  TEST_EQ(std::string("\x05", 1), to_msgpack(json{int64_t{5}}));
+  TEST_EQ(std::string("\xff", 1), to_msgpack(json{int64_t{-1}}));
+  TEST_EQ(std::string("\xd0\xdf", 2), to_msgpack(json{int64_t{-33}}));
+  TEST_EQ(std::string("\xcc\xc8", 2), to_msgpack(json{int64_t{200}}));
+  TEST_EQ(std::string("\xcd\x01\x00", 3), to_msgpack(json{int64_t{256}}));
+  TEST_EQ(std::string("\xc0", 1), to_msgpack(json{nullptr}));
+  TEST_EQ(std::string("\xc3", 1), to_msgpack(json{true}));
+  TEST_EQ(std::string("\xcb\x3f\xf8\0\0\0\0\0\0", 9), to_msgpack(json{1.5}));
+  TEST_EQ(std::string("\xa1\x61", 2), to_msgpack(json{std::string("a")}));
+  TEST_EQ(std::string("\xd9\x20", 2) + std::string(32, 'x'),
+          to_msgpack(json{std::string(32, 'x')}));
+  TEST_EQ(std::string("\x92\x01\x02", 3), to_msgpack(json{json_array{json{int64_t{1}}, json{int64_t{2}}}}));
+  TEST_EQ(std::string("\x81\xa1\x61\x01", 4),
+          to_msgpack(json{json_object{{"a", json{int64_t{1}}}}}));
+}
+
+UNIT_TEST(cbor_encoding) {
+  TEST_EQ(std::string("\x05", 1), to_cbor(json{int64_t{5}}));
+  TEST_EQ(std::string("\x20", 1), to_cbor(json{int64_t{-1}}));
+  TEST_EQ(std::string("\x18\x18", 2), to_cbor(json{int64_t{24}}));
+  TEST_EQ(std::string("\x19\x01\xf4", 3), to_cbor(json{int64_t{500}}));
+  TEST_EQ(std::string("\x38\x63", 2), to_cbor(json{int64_t{-100}}));
+  TEST_EQ(std::string("\xf6", 1), to_cbor(json{nullptr}));
+  TEST_EQ(std::string("\xf5", 1), to_cbor(json{true}));
+  TEST_EQ(std::string("\xfb\x3f\xf8\0\0\0\0\0\0", 9), to_cbor(json{1.5}));
+  TEST_EQ(std::string("\x61\x61", 2), to_cbor(json{std::string("a")}));
+  TEST_EQ(std::string("\x82\x01\x02", 3), to_cbor(json{json_array{json{int64_t{1}}, json{int64_t{2}}}}));
+  TEST_EQ(std::string("\xa1\x61\x61\x01", 4), to_cbor(json{json_object{{"a", json{int64_t{1}}}}}));
+}
+
+// Encode, then decode, and check that the value is the same, and that all of
+// the input was used. Then check that each proper prefix is rejected.
+template <typename Encode, typename Decode>
+bool
+round_trip(const json & doc, Encode && encode, Decode && decode) {
+  const std::string buffer = encode(doc);
+
+  json result{nullptr};
+  byte_source src{buffer.data(), buffer.size()};
+  if (!decode(src, result) || src.remaining() || !(result == doc)) { return false; }
+
+  for (std::size_t n = 0; n < buffer.size(); ++n) {
+    byte_source prefix{buffer.data(), n};
+    if (decode(prefix, result)) { return false; }
+  }
+  return true;
+}
+
+UNIT_TEST(codec_round_trip) {
+  const json doc = make_document();
+
+  TEST_TRUE(round_trip(doc, to_msgpack<json>,
+                       [](byte_source & src, json & j) { return decode_msgpack(src, j); }));
+  TEST_TRUE(round_trip(doc, to_cbor<json>,
+                       [](byte_source & src, json & j) { return decode_cbor(src, j); }));
+
+  // Several values in one buffer
+  std::string buffer;
+  encode_cbor(json{int64_t{1}}, buffer);
+  encode_cbor(doc, buffer);
+  byte_source src{buffer.data(), buffer.size()};
+  json result{nullptr};
+  TEST_TRUE(decode_cbor(src, result));
+  TEST_TRUE(result == json{int64_t{1}});
+  TEST_TRUE(decode_cbor(src, result));
+  TEST_TRUE(result == doc);
+  TEST_EQ(0, src.remaining());
+}
+
+UNIT_TEST(codec_alternatives) {
+  // The first value type which accepts the wire type is used
+  using var_t = variant<int32_t, int64_t, std::string>;
+
+  std::string buffer;
+  encode_msgpack(var_t{int64_t{5}}, buffer);
+  encode_msgpack(var_t{int64_t{1} << 40}, buffer);
+
+  byte_source src{buffer.data(), buffer.size()};
+  var_t result{"asdf"};
+  TEST_TRUE(decode_msgpack(src, result));
+  TEST_EQ(0, result.which());
+  TEST_EQ(5, *get<int32_t>(&result));
+
+  // Out of range for int32_t, which is an error
+  TEST_FALSE(decode_msgpack(src, result));
+
+  // No value type accepts a float
+  buffer.clear();
+  encode_msgpack(variant<double>{1.5}, buffer);
+  byte_source src2{buffer.data(), buffer.size()};
+  TEST_FALSE(decode_msgpack(src2, result));
+
+  // Half precision CBOR float
+  const unsigned char half[] = {0xf9, 0x3e, 0x00};
+  byte_source src3{half, sizeof(half)};
+  json j{nullptr};
+  TEST_TRUE(decode_cbor(src3, j));
+  TEST_EQ(1.5, *get<double>(&j));
+
+  // Float, in single precision
+  buffer.clear();
+  encode_cbor(variant<float>{0.25f}, buffer);
+  TEST_EQ(5, buffer.size());
+  variant<float> f{0.0f};
+  byte_source src4{buffer.data(), buffer.size()};
+  TEST_TRUE(decode_cbor(src4, f));
+  TEST_EQ(0.25f, *get<float>(&f));
+
+  // A double which is out of range for float is an error, but infinity is not
+  buffer.clear();
+  encode_cbor(variant<double>{1e300}, buffer);
+  encode_cbor(variant<double>{-std::numeric_limits<double>::infinity()}, buffer);
+  byte_source src5{buffer.data(), buffer.size()};
+  TEST_FALSE(decode_cbor(src5, f));
+  TEST_EQ(0.25f, *get<float>(&f));
+  TEST_TRUE(decode_cbor(src5, f));
+  TEST_EQ(-std::numeric_limits<float>::infinity(), *get<float>(&f));
+}
+
+UNIT_TEST(codec_bad_input) {
+  json j{nullptr};
+
+  // Deep nesting is rejected, rather than overflowing the stack
+  const std::string deep_msgpack(1000, '\x91');
+  byte_source src{deep_msgpack.data(), deep_msgpack.size()};
+  TEST_FALSE(decode_msgpack(src, j));
+
+  const std::string deep_cbor(1000, '\x81');
+  byte_source src2{deep_cbor.data(), deep_cbor.size()};
+  TEST_FALSE(decode_cbor(src2, j));
+
+  // A huge array length is rejected, rather than allocated
+  const unsigned char huge[] = {0xdd, 0xff, 0xff, 0xff, 0xff, 0x01};
+  byte_source src3{huge, sizeof(huge)};
+  TEST_FALSE(decode_msgpack(src3, j));
+
+  // Unsupported items: msgpack bin, and a CBOR tag
+  const unsigned char bin[] = {0xc4, 0x01, 0x00};
+  byte_source src4{bin, sizeof(bin)};
+  TEST_FALSE(decode_msgpack(src4, j));
+
+  const unsigned char tag[] = {0xc1, 0x01};
+  byte_source src5{tag, sizeof(tag)};
+  TEST_FALSE(decode_cbor(src5, j));
+}
+
+UNIT_TEST(codec_depth_balanced) {
+  // A failed read of an array or map gives back its level of depth, so that a
+  // trait may try something else, with the same reader
+  const unsigned char data[] = {0x91, 0xa1, 'x', 0x81, 0xa1, 'x', 0xa1, 'x', 0x91, 0x01};
+  byte_source src{data, sizeof(data)};
+  msgpack_reader r{src, 1};
+
+  std::vector<std::vector<int32_t>> out;
+  detail::vector_emplacer<std::vector<int32_t>> emplace{out};
+  wire_item item;
+  TEST_TRUE(r.next(item));
+  TEST_FALSE(codec_traits<std::vector<int32_t>>::read(r, item, emplace));
+
+  std::map<std::string, int32_t> m;
+  TEST_TRUE(r.next(item));
+  TEST_FALSE((codec_traits<std::map<std::string, int32_t>>::read(
+    r, item, [&m](std::map<std::string, int32_t> && x) { m = std::move(x); })));
+
+  TEST_TRUE(r.next(item));
+  TEST_TRUE(codec_traits<std::vector<int32_t>>::read(r, item, emplace));
+  TEST_EQ(1, out.size());
+  TEST_EQ(1, out[0][0]);
+}
+
+// The same JSON-like value, with arrays and objects allocated by a pool
+struct pooled_json;
+using pooled_array = std::vector<pooled_json>;
+using pooled_object = std::map<std::string, pooled_json>;
+using pooled_json_base = variant<std::nullptr_t, bool, int64_t, double, std::string,
+                                 alloc_wrapper<pooled_array, pool_allocator<pooled_array>>,
+                                 alloc_wrapper<pooled_object, pool_allocator<pooled_object>>>;
+
+struct pooled_json : pooled_json_base {
+  using pooled_json_base::pooled_json_base;
+};
+
+template <>
+struct codec_traits<pooled_json> : codec_traits<pooled_json_base> {};
+
+UNIT_TEST(pool_allocator) {
+  {
+    pool_allocator<int64_t> a;
+    int64_t * p = a.allocate(1);
+    a.deallocate(p, 1);
+    TEST_TRUE(a.allocate(1) == p);
+    a.deallocate(p, 1);
+  }
+
+  const std::string buffer = to_msgpack(make_document());
+
+  // Decoding again reuses the nodes of the first result
+  pooled_json result{nullptr};
+  for (int i = 0; i < 2; ++i) {
+    byte_source src{buffer.data(), buffer.size()};
+    TEST_TRUE(decode_msgpack(src, result));
+    TEST_EQ(6, result.which());
+    TEST_EQ(buffer, to_msgpack(result));
+  }
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Variant codec tests:" << std::endl;
+  return test_registrar::run_tests();
+}
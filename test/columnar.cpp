@@ -0,0 +1,208 @@
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_columnar.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace strict_variant {
+
+using var_t = variant<int32_t, double, std::string, recursive_wrapper<std::vector<int64_t>>>;
+
+// Describes the values passed by the reader
+struct describe_visitor {
+  std::vector<std::string> & out;
+
+  void operator()(int32_t i) const { out.push_back("int " + std::to_string(i)); }
+  void operator()(double d) const { out.push_back("double " + std::to_string(d)); }
+  void operator()(const string_ref & s) const { out.push_back("string " + s.str()); }
+  void operator()(const vector_ref<int64_t> & v) const {
+    std::string result = "ints";
+    for (int64_t i : v) {
+      result += " " + std::to_string(i);
+    }
+    out.push_back(result);
+  }
+};
+
+// Describes the original values, in the same way
+struct describe_value_visitor {
+  std::vector<std::string> & out;
+
+  void operator()(const std::string & s) const { out.push_back("string " + s); }
+  void operator()(const std::vector<int64_t> & v) const {
+    std::string result = "ints";
+    for (int64_t i : v) {
+      result += " " + std::to_string(i);
+    }
+    out.push_back(result);
+  }
+
+  template <typename T>
+  void operator()(const T & t) const {
+    describe_visitor{out}(t);
+  }
+};
+
+std::vector<std::string>
+describe_all(const std::vector<var_t> & vals) {
+  std::vector<std::string> result;
+  for (const var_t & v : vals) {
+    apply_visitor(describe_value_visitor{result}, v);
+  }
+  return result;
+}
+
+template <typename V>
+std::string
+write_all(const std::vector<V> & vals) {
+  columnar_writer<V> w;
+  for (const V & v : vals) {
+    w.push_back(v);
+  }
+  std::string buffer;
+  w.write(buffer);
+  return buffer;
+}
+
+UNIT_TEST(columnar_round_trip) {
+  std::vector<var_t> vals;
+  for (int i = 0; i < 500; ++i) {
+    // Runs of different lengths
+    switch ((i / 7 + i % 3) % 4) {
+      case 0:
+        vals.emplace_back(int32_t{i * (i % 2 ? -3 : 5)});
+        break;
+      case 1:
+        vals.emplace_back(i * 0.25);
+        break;
+      case 2:
+        vals.emplace_back(std::string(static_cast<std::size_t>(i % 13), 'x'));
+        break;
+      default:
+        vals.emplace_back(std::vector<int64_t>(static_cast<std::size_t>(i % 4), -i));
+    }
+  }
+  vals.emplace_back(std::numeric_limits<int32_t>::min());
+  vals.emplace_back(std::numeric_limits<int32_t>::max());
+
+  const std::string buffer = write_all(vals);
+  columnar_reader<var_t> r;
+  TEST_TRUE(r.assign(buffer.data(), buffer.size()));
+  TEST_EQ(vals.size(), r.size());
+
+  std::vector<std::string> result;
+  TEST_TRUE(r.for_each(describe_visitor{result}));
+  TEST_TRUE(describe_all(vals) == result);
+
+  // By column, the values of each type stay in order
+  std::vector<var_t> by_type;
+  for (int which = 0; which < 4; ++which) {
+    std::size_t count = 0;
+    for (const var_t & v : vals) {
+      if (v.which() == which) {
+        by_type.push_back(v);
+        ++count;
+      }
+    }
+    TEST_EQ(count, r.column_size(static_cast<std::size_t>(which)));
+  }
+  result.clear();
+  TEST_TRUE(r.scan(describe_visitor{result}));
+  TEST_TRUE(describe_all(by_type) == result);
+}
+
+UNIT_TEST(columnar_size) {
+  using int_var_t = variant<int64_t, double>;
+
+  // A long run of slowly increasing integers is about a byte per value
+  std::vector<int_var_t> vals;
+  for (int64_t i = 0; i < 1000; ++i) {
+    vals.emplace_back(int64_t{1000000000} + i * 10);
+  }
+  vals.emplace_back(1.5);
+  const std::string buffer = write_all(vals);
+  TEST_TRUE(buffer.size() < 1100);
+
+  columnar_reader<int_var_t> r;
+  TEST_TRUE(r.assign(buffer.data(), buffer.size()));
+  int64_t sum = 0;
+  double dsum = 0;
+  struct visitor {
+    int64_t & sum;
+    double & dsum;
+    void operator()(int64_t i) const { sum += i; }
+    void operator()(double d) const { dsum += d; }
+  };
+  TEST_TRUE(r.scan(visitor{sum, dsum}));
+  TEST_EQ(int64_t{1000} * 1000000000 + 4995000, sum);
+  TEST_EQ(1.5, dsum);
+}
+
+UNIT_TEST(columnar_empty) {
+  const std::string buffer = write_all(std::vector<var_t>{});
+  columnar_reader<var_t> r;
+  TEST_TRUE(r.assign(buffer.data(), buffer.size()));
+  TEST_TRUE(r.empty());
+
+  std::vector<std::string> result;
+  TEST_TRUE(r.for_each(describe_visitor{result}));
+  TEST_TRUE(result.empty());
+
+  // More values may be added after writing
+  columnar_writer<var_t> w;
+  w.push_back(var_t{1});
+  std::string first;
+  w.write(first);
+  w.push_back(var_t{2});
+  w.push_back(var_t{2.5});
+  std::string second;
+  w.write(second);
+  TEST_TRUE(r.assign(second.data(), second.size()));
+  TEST_TRUE(r.for_each(describe_visitor{result}));
+  TEST_EQ(3, result.size());
+  TEST_EQ("int 2", result[1]);
+
+  w.clear();
+  TEST_EQ(0, w.size());
+}
+
+UNIT_TEST(columnar_malformed) {
+  std::vector<var_t> vals{var_t{1}, var_t{2}, var_t{std::string("asdf")}, var_t{0.5}};
+  const std::string buffer = write_all(vals);
+  columnar_reader<var_t> r;
+
+  // Every truncation is rejected
+  for (std::size_t n = 0; n < buffer.size(); ++n) {
+    TEST_FALSE(r.assign(buffer.data(), n));
+    TEST_TRUE(r.empty());
+  }
+  TEST_FALSE(r.assign((buffer + "x").data(), buffer.size() + 1));
+
+  // A different variant type
+  columnar_reader<variant<int32_t, double>> other;
+  TEST_FALSE(other.assign(buffer.data(), buffer.size()));
+
+  // A bad value in a column is found while visiting. The string column is
+  // "\x01" "\x04" "asdf": make its length too long, keeping the column size.
+  std::string bad = buffer;
+  const std::size_t pos = bad.find("asdf");
+  TEST_TRUE(pos != std::string::npos);
+  bad[pos - 1] = 5;
+  TEST_TRUE(r.assign(bad.data(), bad.size()));
+  std::vector<std::string> result;
+  TEST_FALSE(r.for_each(describe_visitor{result}));
+  TEST_FALSE(r.scan(describe_visitor{result}));
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Variant columnar tests:" << std::endl;
+  return test_registrar::run_tests();
+}
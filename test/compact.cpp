@@ -0,0 +1,177 @@
+#include <strict_variant/arena_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_compact.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+// An expression tree, whose nodes are in an arena
+struct binop;
+using expr_t = variant<int, arena_wrapper<binop>>;
+
+struct binop {
+  char op;
+  expr_t lhs;
+  expr_t rhs;
+};
+
+struct eval_visitor {
+  int operator()(int i) const { return i; }
+  int operator()(const binop & b) const {
+    const int l = apply_visitor(*this, b.lhs);
+    const int r = apply_visitor(*this, b.rhs);
+    return b.op == '-' ? l - r : l * r;
+  }
+};
+
+// Records the address of each node, in preorder
+struct address_visitor {
+  std::vector<std::uintptr_t> * addresses;
+
+  void operator()(int) const {}
+  void operator()(const binop & b) const {
+    addresses->push_back(reinterpret_cast<std::uintptr_t>(&b));
+    apply_visitor(*this, b.lhs);
+    apply_visitor(*this, b.rhs);
+  }
+};
+
+std::vector<std::uintptr_t>
+addresses(const expr_t & e) {
+  std::vector<std::uintptr_t> result;
+  apply_visitor(address_visitor{&result}, e);
+  return result;
+}
+
+// A balanced tree of `depth`, whose nodes are allocated in an order which is
+// not depth-first, interleaved with other allocations
+void
+make_scattered(expr_t & e, int depth, bump_arena & arena) {
+  arena_scope scope{arena};
+  std::vector<std::pair<expr_t *, int>> pending{{&e, depth}};
+  for (std::size_t i = 0; !pending.empty(); ++i) {
+    std::swap(pending[i % pending.size()], pending.back());
+    const std::pair<expr_t *, int> p = pending.back();
+    pending.pop_back();
+    arena.allocate(24, 8);
+    if (!p.second) {
+      *p.first = static_cast<int>(i % 7);
+      continue;
+    }
+    p.first->emplace<binop>(binop{i % 2 ? '-' : '*', expr_t{0}, expr_t{0}});
+    binop * b = get<binop>(p.first);
+    pending.emplace_back(&b->lhs, p.second - 1);
+    pending.emplace_back(&b->rhs, p.second - 1);
+  }
+}
+
+UNIT_TEST(compact_same_to_visitors) {
+  bump_arena arena;
+  expr_t e{0};
+  make_scattered(e, 10, arena);
+  const int value = apply_visitor(eval_visitor{}, e);
+
+  const compact_tree<expr_t> c = compact(e);
+  TEST_EQ(value, apply_visitor(eval_visitor{}, c.get()));
+  TEST_EQ(addresses(e).size(), addresses(c.get()).size());
+  TEST_EQ(1023, addresses(c.get()).size());
+}
+
+UNIT_TEST(compact_contiguous) {
+  bump_arena arena;
+  expr_t e{0};
+  make_scattered(e, 8, arena);
+
+  const compact_tree<expr_t> c = compact(e);
+  TEST_EQ(sizeof(expr_t) + 255 * sizeof(binop), c.bytes_used());
+
+  // The nodes follow the root, in depth-first order, without gaps
+  const std::vector<std::uintptr_t> a = addresses(c.get());
+  std::uintptr_t expected = reinterpret_cast<std::uintptr_t>(&c.get()) + sizeof(expr_t);
+  for (std::uintptr_t p : a) {
+    expected = (expected + alignof(binop) - 1) & ~std::uintptr_t{alignof(binop) - 1};
+    TEST_EQ(expected, p);
+    expected += sizeof(binop);
+  }
+
+  // The source was not in that order
+  const std::vector<std::uintptr_t> b = addresses(e);
+  bool ordered = true;
+  for (std::size_t i = 1; i < b.size(); ++i) {
+    ordered = ordered && b[i - 1] < b[i];
+  }
+  TEST_TRUE(!ordered);
+}
+
+UNIT_TEST(compact_move) {
+  bump_arena arena;
+  expr_t e{0};
+  make_scattered(e, 4, arena);
+
+  compact_tree<expr_t> c = compact(e);
+  const std::vector<std::uintptr_t> a = addresses(c.get());
+  const compact_tree<expr_t> d{std::move(c)};
+  TEST_TRUE(a == addresses(d.get()));
+  TEST_EQ(apply_visitor(eval_visitor{}, e), apply_visitor(eval_visitor{}, d.get()));
+}
+
+UNIT_TEST(compact_leaf) {
+  const expr_t e{5};
+  const compact_tree<expr_t> c = compact(e);
+  TEST_EQ(5, *get<int>(&c.get()));
+  TEST_EQ(sizeof(expr_t), c.bytes_used());
+}
+
+// Nodes of several types and alignments
+struct alignas(16) wide;
+struct narrow;
+using mixed_t = variant<char, arena_wrapper<wide>, arena_wrapper<narrow>>;
+
+struct alignas(16) wide {
+  double x;
+  mixed_t next;
+};
+
+struct narrow {
+  char c;
+  mixed_t next;
+};
+
+struct sum_visitor {
+  double operator()(char c) const { return c; }
+  double operator()(const wide & w) const { return w.x + apply_visitor(*this, w.next); }
+  double operator()(const narrow & n) const { return n.c + apply_visitor(*this, n.next); }
+};
+
+UNIT_TEST(compact_mixed) {
+  bump_arena arena;
+  arena_scope scope{arena};
+  mixed_t m{'a'};
+  mixed_t * tail = &m;
+  for (int i = 0; i < 100; ++i) {
+    if (i % 3) {
+      tail->emplace<narrow>(narrow{'b', 'c'});
+      tail = &get<narrow>(tail)->next;
+    } else {
+      tail->emplace<wide>(wide{0.5, 'd'});
+      tail = &get<wide>(tail)->next;
+    }
+  }
+
+  const compact_tree<mixed_t> c = compact(m);
+  TEST_EQ(apply_visitor(sum_visitor{}, m), apply_visitor(sum_visitor{}, c.get()));
+  TEST_EQ(0u, reinterpret_cast<std::uintptr_t>(get<wide>(&c.get())) % 16);
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Compact tests:" << std::endl;
+  return test_registrar::run_tests();
+}
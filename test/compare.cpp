@@ -5,6 +5,7 @@
 
 #include <strict_variant/variant.hpp>
 #include <strict_variant/variant_compare.hpp>
+#include <strict_variant/variant_relational_ops.hpp>
 #include <strict_variant/variant_stream_ops.hpp>
 
 #include "test_harness/test_harness.hpp"
@@ -13,6 +14,7 @@
 #include <set>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 // Test that variant_comparator works
 
@@ -79,6 +81,39 @@ UNIT_TEST(std_less_specialization_example) {
   TEST_FALSE(s.count(var_t(70)));
 }
 
+// Test that compare_three_way and the relational operators agree with
+// variant_comparator
+
+UNIT_TEST(compare_three_way) {
+  using var_t = variant<int, recursive_wrapper<std::string>, double>;
+
+  std::vector<var_t> vec{var_t{0},   var_t{1},    var_t{-1},     var_t{"asdf"},
+                         var_t{""},  var_t{"zz"}, var_t{0.5},    var_t{-2.0},
+                         var_t{1.0}, var_t{1},    var_t{"asdf"}, var_t{0.5}};
+
+  variant_comparator<var_t> less;
+
+  for (const var_t & a : vec) {
+    for (const var_t & b : vec) {
+      const int c = compare_three_way(a, b);
+      TEST_EQ(less(a, b), c < 0);
+      TEST_EQ(less(b, a), c > 0);
+      TEST_EQ(a == b, c == 0);
+      TEST_EQ(a != b, c != 0);
+
+      TEST_EQ(less(a, b), a < b);
+      TEST_EQ(less(b, a), a > b);
+      TEST_EQ(!less(b, a), a <= b);
+      TEST_EQ(!less(a, b), a >= b);
+    }
+  }
+
+  TEST_TRUE(var_t{5} < var_t{"a"});
+  TEST_TRUE(var_t{"a"} < var_t{"b"});
+  TEST_TRUE(var_t{"b"} < var_t{0.0});
+  TEST_EQ(0, compare_three_way(var_t{"b"}, var_t{"b"}));
+}
+
 int
 main() {
 
@@ -0,0 +1,175 @@
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace strict_variant {
+
+// A list, and a tree with two kinds of nodes, whose wrappers are destroyed
+// iteratively. Each node counts the live nodes.
+struct cons;
+using list_t = variant<int, recursive_wrapper<cons>>;
+
+struct cons {
+  static int live;
+
+  int head;
+  list_t tail;
+
+  cons(int h, list_t t)
+    : head(h)
+    , tail(std::move(t)) {
+    ++live;
+  }
+  cons(cons && other)
+    : head(other.head)
+    , tail(std::move(other.tail)) {
+    ++live;
+  }
+  ~cons() noexcept { --live; }
+};
+
+int cons::live = 0;
+
+struct counter {
+  static int live;
+
+  counter() noexcept { ++live; }
+  counter(const counter &) noexcept { ++live; }
+  counter & operator=(const counter &) noexcept = default;
+  ~counter() noexcept { --live; }
+};
+
+int counter::live = 0;
+
+struct unary;
+struct nary;
+using tree_t = variant<std::string, recursive_wrapper<unary>, recursive_wrapper<nary>>;
+
+struct unary {
+  tree_t child;
+  counter c;
+};
+
+struct nary {
+  std::vector<tree_t> children;
+  counter c;
+};
+
+struct link;
+
+namespace detail {
+
+template <>
+struct destroy_iteratively<cons> : std::true_type {};
+template <>
+struct destroy_iteratively<unary> : std::true_type {};
+template <>
+struct destroy_iteratively<nary> : std::true_type {};
+template <>
+struct destroy_iteratively<link> : std::true_type {};
+
+} // end namespace detail
+
+// A list with static storage duration, which is destroyed at exit, after the
+// thread locals of the main thread
+using chain_t = variant<int, recursive_wrapper<link>>;
+
+struct link {
+  static int live;
+
+  chain_t next;
+
+  explicit link(chain_t n)
+    : next(std::move(n)) {
+    ++live;
+  }
+  link(link && other)
+    : next(std::move(other.next)) {
+    ++live;
+  }
+  ~link() noexcept { --live; }
+};
+
+int link::live = 0;
+
+chain_t
+make_chain(int length) {
+  chain_t c{0};
+  chain_t * tail = &c;
+  for (int i = 0; i < length; ++i) {
+    tail->emplace<link>(link{chain_t{i}});
+    tail = &get<link>(tail)->next;
+  }
+  return c;
+}
+
+// Destroyed after `static_chain`, so it can check that every link was freed
+struct static_chain_check {
+  ~static_chain_check() {
+    if (link::live) {
+      std::cout << "static_chain was not destroyed!" << std::endl;
+      std::_Exit(1);
+    }
+  }
+} static_chain_checker;
+
+chain_t static_chain = make_chain(10);
+
+// Builds the list from the head, since moving a variant moves the value in a
+// recursive_wrapper, which recurses
+void
+append(list_t *& tail, int head) {
+  tail->emplace<cons>(cons{head, list_t{0}});
+  tail = &get<cons>(tail)->tail;
+}
+
+UNIT_TEST(destroy_deep_list) {
+  constexpr int length = 1000000;
+  {
+    list_t list{0};
+    list_t * tail = &list;
+    for (int i = 0; i < length; ++i) {
+      append(tail, i);
+    }
+    TEST_EQ(length, cons::live);
+  }
+  TEST_EQ(0, cons::live);
+}
+
+UNIT_TEST(destroy_deep_tree) {
+  // Chains of unary nodes, each ending in a wide node of short chains, and
+  // continuing from its last child
+  {
+    tree_t tree{std::string("leaf")};
+    tree_t * tail = &tree;
+    for (int i = 0; i < 1000; ++i) {
+      for (int j = 0; j < 1000; ++j) {
+        tail->emplace<unary>(unary{tree_t{std::string("leaf")}, counter{}});
+        tail = &get<unary>(tail)->child;
+      }
+      nary n{{}, counter{}};
+      n.children.resize(4, tree_t{unary{tree_t{std::string(100, 'x')}, counter{}}});
+      n.children.emplace_back(std::string("end"));
+      tail->emplace<nary>(std::move(n));
+      tail = &get<nary>(tail)->children.back();
+    }
+    TEST_EQ(1000 * (1000 + 1 + 4), counter::live);
+  }
+  TEST_EQ(0, counter::live);
+}
+
+UNIT_TEST(destroy_static) { TEST_EQ(10, link::live); }
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Destroy tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -0,0 +1,222 @@
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_event_log.hpp>
+#include <strict_variant/variant_view.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace strict_variant {
+
+using event_t = variant<int32_t, double, std::string, recursive_wrapper<std::vector<int32_t>>>;
+
+// Describes the views passed by replay
+struct describe_visitor {
+  std::vector<std::string> & out;
+
+  void operator()(int32_t i) const { out.push_back("int " + std::to_string(i)); }
+  void operator()(double d) const { out.push_back("double " + std::to_string(d)); }
+  void operator()(const string_ref & s) const { out.push_back("string " + s.str()); }
+  void operator()(const vector_ref<int32_t> & v) const {
+    out.push_back("ints " + std::to_string(v.size()));
+  }
+};
+
+std::string
+describe(const event_t & e) {
+  struct visitor {
+    std::string operator()(int32_t i) const { return "int " + std::to_string(i); }
+    std::string operator()(double d) const { return "double " + std::to_string(d); }
+    std::string operator()(const std::string & s) const { return "string " + s; }
+    std::string operator()(const std::vector<int32_t> & v) const {
+      return "ints " + std::to_string(v.size());
+    }
+  };
+  return apply_visitor(visitor{}, e);
+}
+
+// A temporary directory, removed with its segments
+struct temp_dir {
+  std::string path;
+
+  temp_dir() {
+    char name[] = "/tmp/strict_variant_event_log_XXXXXX";
+    path = ::mkdtemp(name);
+  }
+
+  ~temp_dir() {
+    for (std::size_t i = 0; ::unlink(detail::segment_path(path, i).c_str()) == 0; ++i) {}
+    ::rmdir(path.c_str());
+  }
+};
+
+event_t
+make_event(int i) {
+  switch (i % 4) {
+    case 0:
+      return event_t{int32_t{i}};
+    case 1:
+      return event_t{i * 0.5};
+    case 2:
+      return event_t{std::string(static_cast<std::size_t>(i % 50), 'x')};
+    default:
+      return event_t{std::vector<int32_t>(static_cast<std::size_t>(i % 30), i)};
+  }
+}
+
+UNIT_TEST(event_log_round_trip) {
+  temp_dir dir;
+  std::vector<std::string> expected;
+
+  event_log_options options;
+  options.segment_size = 1;
+  options.commit_every = 16;
+
+  {
+    event_log_writer<event_t> w{options};
+    TEST_TRUE(w.open(dir.path));
+    for (int i = 0; i < 1000; ++i) {
+      const event_t e = make_event(i);
+      TEST_TRUE(w.append(e));
+      expected.push_back(describe(e));
+    }
+    // Segments are one page, so there are several
+    TEST_TRUE(w.segment() > 2);
+    TEST_TRUE(w.close());
+  }
+
+  // Reopening continues after the last record
+  options.sync = event_log_sync::fdatasync;
+  {
+    event_log_writer<event_t> w{options};
+    TEST_TRUE(w.open(dir.path));
+    for (int i = 1000; i < 1100; ++i) {
+      const event_t e = make_event(i);
+      TEST_TRUE(w.append(e));
+      expected.push_back(describe(e));
+    }
+    TEST_TRUE(w.commit());
+
+    // Larger than a segment
+    TEST_FALSE(w.append(event_t{std::string(1 << 16, 'x')}));
+    TEST_TRUE(w.last_error() == std::errc::value_too_large);
+  }
+
+  std::vector<std::string> result;
+  std::error_code ec;
+  TEST_EQ(expected.size(), replay_event_log<event_t>(dir.path, describe_visitor{result}, ec));
+  TEST_FALSE(ec);
+  TEST_TRUE(expected == result);
+}
+
+UNIT_TEST(event_log_errors) {
+  std::error_code ec;
+  std::vector<std::string> result;
+  TEST_EQ(0, replay_event_log<event_t>("/nonexistent/dir", describe_visitor{result}, ec));
+  TEST_TRUE(ec == std::errc::no_such_file_or_directory);
+
+  event_log_writer<event_t> w;
+  TEST_FALSE(w.open("/nonexistent/dir"));
+  TEST_TRUE(w.last_error() == std::errc::no_such_file_or_directory);
+  TEST_FALSE(w.append(event_t{1}));
+}
+
+UNIT_TEST(event_log_allocated) {
+  temp_dir dir;
+
+  // The segment is not sparse, so writing through the mapping cannot fail
+  event_log_options options;
+  options.segment_size = std::size_t{1} << 20;
+  event_log_writer<event_t> w{options};
+  TEST_TRUE(w.open(dir.path));
+
+  struct stat st;
+  TEST_EQ(0, ::stat(detail::segment_path(dir.path, 0).c_str(), &st));
+  TEST_EQ(options.segment_size, static_cast<std::size_t>(st.st_size));
+  TEST_TRUE(static_cast<std::size_t>(st.st_blocks) * 512 >= options.segment_size);
+}
+
+// A recursive event type, for corrupt input
+struct chain;
+using chain_t = variant<int32_t, recursive_wrapper<chain>>;
+
+struct chain {
+  std::vector<chain_t> children;
+};
+
+template <>
+struct view_traits<chain> : view_traits<std::vector<chain_t>> {};
+
+struct chain_depth {
+  std::size_t operator()(int32_t) const { return 0; }
+  std::size_t operator()(const vector_ref<chain_t> & children) const {
+    std::size_t result = 0;
+    for (const variant_view<int32_t, recursive_wrapper<chain>> & c : children) {
+      result = std::max(result, apply_visitor(*this, c));
+    }
+    return result + 1;
+  }
+};
+
+struct depth_visitor {
+  std::vector<std::size_t> & out;
+
+  template <typename T>
+  void operator()(const T & t) const {
+    out.push_back(chain_depth{}(t));
+  }
+};
+
+UNIT_TEST(event_log_corrupt_depth) {
+  temp_dir dir;
+
+  // A record of a chain of depth 2, then one nested far too deeply to check
+  // recursively. Each level is a tag and a vector length.
+  std::string segment;
+  for (std::size_t depth : {std::size_t{2}, std::size_t{1000000}}) {
+    std::string record;
+    for (std::size_t i = 0; i < depth; ++i) {
+      record += "\1\1";
+    }
+    record += std::string("\0\5\0\0\0", 5);
+    const std::uint32_t length = static_cast<std::uint32_t>(record.size());
+    segment.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    segment += record;
+  }
+  {
+    std::FILE * f = std::fopen(detail::segment_path(dir.path, 0).c_str(), "wb");
+    TEST_TRUE(f != nullptr);
+    TEST_EQ(1, std::fwrite(segment.data(), segment.size(), 1, f));
+    std::fclose(f);
+  }
+
+  // Replay stops at the corrupt record
+  std::error_code ec;
+  std::vector<std::size_t> depths;
+  TEST_EQ(1, replay_event_log<chain_t>(dir.path, depth_visitor{depths}, ec));
+  TEST_FALSE(ec);
+  TEST_EQ(1, depths.size());
+  TEST_EQ(2, depths[0]);
+
+  // Opening for writing scans the segment too
+  event_log_writer<chain_t> w;
+  TEST_TRUE(w.open(dir.path));
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Variant event log tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -4,9 +4,11 @@
 
 #include "test_harness/test_harness.hpp"
 
+#include <set>
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace strict_variant {
 
@@ -65,6 +67,50 @@ UNIT_TEST(copying) {
   }
 }
 
+UNIT_TEST(which_is_mixed) {
+  using var_t = variant<int, long>;
+  std::hash<var_t> h;
+
+  // Each of these would collide with `hash(value) + 31 * which`
+  TEST_NE(h(var_t{31}), h(var_t{0l}));
+  TEST_NE(h(var_t{0}), h(var_t{0l}));
+
+  std::set<std::size_t> hashes;
+  for (int i = 0; i < 1000; ++i) {
+    hashes.insert(h(var_t{i}));
+    hashes.insert(h(var_t{static_cast<long>(i)}));
+  }
+  TEST_EQ(2000, hashes.size());
+}
+
+UNIT_TEST(hash_batch) {
+  using var_t = variant<std::string, int, double>;
+
+  std::vector<var_t> vec;
+  for (int i = 0; i < 200; ++i) {
+    if (i % 3 == 0) {
+      vec.emplace_back(std::to_string(i));
+    } else if (i % 3 == 1) {
+      vec.emplace_back(i);
+    } else {
+      vec.emplace_back(static_cast<double>(i));
+    }
+  }
+
+  std::vector<std::size_t> out(vec.size());
+  auto end = hash_batch(vec.begin(), vec.end(), out.begin());
+  TEST_TRUE(end == out.end());
+
+  std::hash<var_t> h;
+  for (std::size_t i = 0; i < vec.size(); ++i) {
+    TEST_EQ(h(vec[i]), out[i]);
+  }
+
+  std::vector<std::size_t> out2;
+  hash_batch(vec.begin(), vec.end(), std::back_inserter(out2));
+  TEST_TRUE(out == out2);
+}
+
 } // end namespace strict_variant
 
 int
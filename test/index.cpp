@@ -0,0 +1,303 @@
+#include <strict_variant/index_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+// An expression tree, whose nodes are in an index_pool
+struct binop;
+using expr_t = variant<int, index_wrapper<binop>>;
+
+struct binop {
+  char op;
+  expr_t lhs;
+  expr_t rhs;
+};
+
+struct eval_visitor {
+  int operator()(int i) const { return i; }
+  int operator()(const binop & b) const {
+    const int l = apply_visitor(*this, b.lhs);
+    const int r = apply_visitor(*this, b.rhs);
+    return b.op == '-' ? l - r : l * r;
+  }
+};
+
+// (0 - 1) * ((1 - 2) * (... * 1)). Moving a variant moves the value in the
+// wrapper, which would copy the subtree, so the tree is built from the root.
+expr_t
+make_expr(int n) {
+  expr_t result{1};
+  expr_t * tail = &result;
+  for (int i = 0; i < n; ++i) {
+    tail->emplace<binop>(binop{'*', expr_t{binop{'-', expr_t{i}, expr_t{i + 1}}}, expr_t{1}});
+    tail = &get<binop>(tail)->rhs;
+  }
+  return result;
+}
+
+UNIT_TEST(index_wrapper_size) {
+  static_assert(sizeof(index_wrapper<binop>) == 4, "an index is 32 bits");
+  TEST_TRUE(sizeof(expr_t) <= 8);
+}
+
+UNIT_TEST(index_scoped) {
+  index_pool<binop> pool;
+  index_pool<binop>::scope scope{pool};
+  {
+    const expr_t e = make_expr(3);
+    TEST_EQ(-1, apply_visitor(eval_visitor{}, e));
+    TEST_EQ(6, pool.live_count());
+
+    // Copies are created in the pool too
+    const expr_t copy{e};
+    TEST_EQ(-1, apply_visitor(eval_visitor{}, copy));
+    TEST_EQ(12, pool.live_count());
+  }
+  TEST_EQ(0, pool.live_count());
+
+  // Freed slots are reused
+  const std::size_t slots = pool.slot_count();
+  {
+    const expr_t e = make_expr(3);
+    TEST_EQ(slots, pool.slot_count());
+  }
+
+  // The pool grows beyond its first chunk
+  {
+    const expr_t e = make_expr(5000);
+    TEST_EQ(1, apply_visitor(eval_visitor{}, e));
+    TEST_EQ(10000, pool.live_count());
+    TEST_TRUE(pool.memory_usage() >= 10000 * sizeof(binop));
+  }
+  TEST_EQ(0, pool.live_count());
+}
+
+UNIT_TEST(index_nested_scopes) {
+  index_pool<binop> outer;
+  index_pool<binop> inner;
+  index_pool<binop>::scope s1{outer};
+  {
+    index_pool<binop>::scope s2{inner};
+    expr_t e{binop{'-', expr_t{1}, expr_t{2}}};
+    TEST_EQ(1, inner.live_count());
+    TEST_EQ(0, outer.live_count());
+    TEST_EQ(-1, apply_visitor(eval_visitor{}, e));
+  }
+  expr_t e{binop{'-', expr_t{1}, expr_t{2}}};
+  TEST_EQ(1, outer.live_count());
+  TEST_EQ(0, inner.live_count());
+}
+
+UNIT_TEST(index_thread_default) {
+  index_pool<binop> & pool = index_pool<binop>::get();
+  const std::size_t live = pool.live_count();
+  {
+    const expr_t e = make_expr(11);
+    TEST_EQ(-1, apply_visitor(eval_visitor{}, e));
+    TEST_EQ(live + 22, pool.live_count());
+  }
+  TEST_EQ(live, pool.live_count());
+}
+
+// Destroyed after `static_expr`, at exit, after the thread locals of the main
+// thread, so it can check that the thread's own pool is still usable
+struct static_expr_check {
+  ~static_expr_check() {
+    if (index_pool<binop>::get().live_count()) {
+      std::cout << "static_expr was not destroyed!" << std::endl;
+      std::_Exit(1);
+    }
+  }
+} static_expr_checker;
+
+const expr_t static_expr = make_expr(3);
+
+UNIT_TEST(index_static) {
+  TEST_EQ(-1, apply_visitor(eval_visitor{}, static_expr));
+  TEST_TRUE(index_pool<binop>::get().live_count() >= 6);
+}
+
+UNIT_TEST(index_swap) {
+  index_pool<binop> pool;
+  index_pool<binop>::scope scope{pool};
+  expr_t a = make_expr(3);
+  expr_t b = make_expr(11);
+  const binop * na = get<binop>(&a);
+  const binop * nb = get<binop>(&b);
+
+  // Swapping exchanges the indices, and creates no nodes
+  a.swap(b);
+  TEST_EQ(nb, get<binop>(&a));
+  TEST_EQ(na, get<binop>(&b));
+  TEST_EQ(-1, apply_visitor(eval_visitor{}, a));
+  TEST_EQ(-1, apply_visitor(eval_visitor{}, b));
+  TEST_EQ(28, pool.live_count());
+
+  // Assigning an int destroys the nodes
+  a = 5;
+  TEST_EQ(6, pool.live_count());
+}
+
+// Counts live nodes, which own a string
+struct named {
+  static int live;
+
+  std::string name;
+  variant<int, index_wrapper<named>> next;
+
+  named(std::string n, variant<int, index_wrapper<named>> x)
+    : name(std::move(n))
+    , next(std::move(x)) {
+    ++live;
+  }
+  named(const named & other)
+    : name(other.name)
+    , next(other.next) {
+    ++live;
+  }
+  ~named() noexcept { --live; }
+};
+
+int named::live = 0;
+
+UNIT_TEST(index_compact) {
+  index_pool<binop> pool;
+  index_pool<binop>::scope scope{pool};
+
+  // Interleave the nodes of a tree with those of another, then free those
+  expr_t e{1};
+  {
+    expr_t other{1};
+    expr_t * tail = &e;
+    expr_t * other_tail = &other;
+    for (int i = 0; i < 100; ++i) {
+      tail->emplace<binop>(binop{'-', expr_t{i}, expr_t{1}});
+      tail = &get<binop>(tail)->rhs;
+      other_tail->emplace<binop>(binop{'*', expr_t{i}, expr_t{1}});
+      other_tail = &get<binop>(other_tail)->rhs;
+    }
+  }
+  TEST_EQ(100, pool.live_count());
+  TEST_EQ(200, pool.slot_count());
+  const int value = apply_visitor(eval_visitor{}, e);
+
+  pool.compact(e);
+  TEST_EQ(100, pool.live_count());
+  TEST_EQ(100, pool.slot_count());
+  TEST_EQ(value, apply_visitor(eval_visitor{}, e));
+
+  // Nodes are in depth-first order
+  const expr_t * t = &e;
+  for (std::uint32_t i = 0; i < 100; ++i) {
+    TEST_EQ(&pool[i], get<binop>(t));
+    TEST_EQ(static_cast<int>(i), *get<int>(&get<binop>(t)->lhs));
+    t = &get<binop>(t)->rhs;
+  }
+
+  // Values which own resources are copied and destroyed
+  index_pool<named> names;
+  index_pool<named>::scope s2{names};
+  {
+    variant<int, index_wrapper<named>> n{named{"a", named{"b", 0}}};
+    TEST_EQ(2, named::live);
+    names.compact(n);
+    TEST_EQ(2, named::live);
+    TEST_EQ("b", get<named>(&get<named>(&n)->next)->name);
+  }
+  TEST_EQ(0, named::live);
+  TEST_EQ(0, names.live_count());
+}
+
+// A node whose copy constructor throws, on the copy numbered `throw_at`
+struct fragile {
+  static int copies;
+  static int throw_at;
+
+  int tag;
+  variant<int, index_wrapper<fragile>> lhs;
+  variant<int, index_wrapper<fragile>> rhs;
+
+  fragile(int t, variant<int, index_wrapper<fragile>> l, variant<int, index_wrapper<fragile>> r)
+    : tag(t)
+    , lhs(std::move(l))
+    , rhs(std::move(r)) {}
+  fragile(const fragile & other)
+    : tag(other.tag)
+    , lhs(other.lhs)
+    , rhs(other.rhs) {
+    if (++copies == throw_at) { throw std::runtime_error("fragile"); }
+  }
+};
+
+int fragile::copies = 0;
+int fragile::throw_at = 0;
+
+struct tag_sum {
+  int operator()(int) const { return 0; }
+  int operator()(const fragile & f) const {
+    return f.tag + apply_visitor(*this, f.lhs) + apply_visitor(*this, f.rhs);
+  }
+};
+
+UNIT_TEST(index_compact_throws) {
+  using tree_t = variant<int, index_wrapper<fragile>>;
+  index_pool<fragile> pool;
+  index_pool<fragile>::scope scope{pool};
+
+  // A balanced tree of 7 nodes, with a list of one more under it
+  tree_t t{0};
+  std::vector<std::pair<tree_t *, int>> pending{{&t, 3}};
+  int tag = 0;
+  while (!pending.empty()) {
+    const std::pair<tree_t *, int> p = pending.back();
+    pending.pop_back();
+    if (!p.second) { continue; }
+    p.first->emplace<fragile>(fragile{++tag, 0, 0});
+    fragile * f = get<fragile>(p.first);
+    pending.emplace_back(&f->lhs, p.second - 1);
+    pending.emplace_back(&f->rhs, p.second - 1);
+  }
+  fragile * leftmost = get<fragile>(&t);
+  while (fragile * f = get<fragile>(&leftmost->lhs)) {
+    leftmost = f;
+  }
+  leftmost->lhs.emplace<fragile>(fragile{++tag, 0, 0});
+  TEST_EQ(8, pool.live_count());
+  const int sum = apply_visitor(tag_sum{}, t);
+  TEST_EQ(36, sum);
+
+  fragile::copies = 0;
+  fragile::throw_at = 4;
+  bool thrown = false;
+  try {
+    pool.compact(t);
+  } catch (const std::runtime_error &) { thrown = true; }
+  TEST_TRUE(thrown);
+  TEST_EQ(8, pool.live_count());
+  TEST_EQ(sum, apply_visitor(tag_sum{}, t));
+
+  // A later compaction succeeds
+  fragile::throw_at = 0;
+  pool.compact(t);
+  TEST_EQ(8, pool.live_count());
+  TEST_EQ(8, pool.slot_count());
+  TEST_EQ(sum, apply_visitor(tag_sum{}, t));
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Index tests:" << std::endl;
+  return test_registrar::run_tests();
+}
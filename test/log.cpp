@@ -0,0 +1,163 @@
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_log.hpp>
+#include <strict_variant/variant_serialize.hpp>
+#include <strict_variant/variant_stream_ops.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace strict_variant {
+
+using event_t = variant<int32_t, double, std::string, recursive_wrapper<std::vector<int32_t>>>;
+
+// Collects the values which are drained
+struct collect_visitor {
+  std::vector<event_t> & out;
+
+  template <typename T>
+  void operator()(const T & t) const {
+    out.emplace_back(t);
+  }
+};
+
+UNIT_TEST(log_ring) {
+  log_ring ring{100};
+  TEST_EQ(128, ring.capacity());
+
+  // Records of different sizes wrap around the buffer many times
+  std::vector<event_t> expected;
+  std::vector<event_t> result;
+  for (int i = 0; i < 200; ++i) {
+    event_t e{int32_t{i}};
+    if (i % 3 == 1) { e = std::string(static_cast<std::size_t>(i % 37), 'x'); }
+    if (i % 3 == 2) { e = std::vector<int32_t>(static_cast<std::size_t>(i % 5), i); }
+    TEST_TRUE(ring.push(e));
+    expected.push_back(e);
+
+    if (i % 2) {
+      ring.consume([&](byte_source & src) {
+        event_t v{0};
+        TEST_TRUE(deserialize(src, v));
+        TEST_EQ(0, src.remaining());
+        result.push_back(v);
+      });
+    }
+  }
+  TEST_EQ(0, ring.dropped());
+  TEST_EQ(expected.size(), result.size());
+  TEST_TRUE(expected == result);
+}
+
+UNIT_TEST(log_ring_trivially_copyable) {
+  // Copied without a dispatch, and read back with deserialize
+  using small_t = variant<int16_t, double, bool>;
+  log_ring ring{64};
+
+  std::vector<small_t> expected;
+  std::vector<small_t> result;
+  for (int i = 0; i < 100; ++i) {
+    small_t e{static_cast<int16_t>(i)};
+    if (i % 3 == 1) { e = i * 0.5; }
+    if (i % 3 == 2) { e = (i % 2 == 0); }
+    TEST_TRUE(ring.push(e));
+    expected.push_back(e);
+
+    ring.consume([&](byte_source & src) {
+      small_t v{int16_t{0}};
+      TEST_TRUE(deserialize(src, v));
+      TEST_EQ(0, src.remaining());
+      result.push_back(v);
+    });
+  }
+  TEST_TRUE(expected == result);
+}
+
+UNIT_TEST(log_ring_full) {
+  log_ring ring{64};
+
+  // 4 + 1 + 4 bytes per record, padded to 12
+  int pushed = 0;
+  while (ring.push(event_t{int32_t{pushed}})) {
+    ++pushed;
+  }
+  TEST_EQ(5, pushed);
+  TEST_EQ(1, ring.dropped());
+
+  // Too large to ever fit
+  TEST_FALSE(ring.push(event_t{std::string(100, 'x')}));
+  TEST_EQ(2, ring.dropped());
+
+  // After consuming, there is room again
+  TEST_EQ(5, ring.consume([](byte_source &) {}));
+  TEST_TRUE(ring.push(event_t{int32_t{1}}));
+  TEST_EQ(1, ring.consume([](byte_source &) {}));
+  TEST_EQ(0, ring.consume([](byte_source &) {}));
+}
+
+UNIT_TEST(variant_logger) {
+  using printable_t = variant<int32_t, double, std::string>;
+  variant_logger<printable_t> logger{1 << 12};
+  TEST_TRUE(logger.log(printable_t{1}));
+  TEST_TRUE(logger.log(printable_t{2.5}));
+  TEST_TRUE(logger.log(printable_t{"asdf"}));
+
+  // Formatted later, with the usual visitors
+  std::ostringstream ss;
+  printable_t value{0};
+  TEST_EQ(3, logger.drain(value, printer_visitor{ss}));
+  TEST_EQ("12.5asdf", ss.str());
+  TEST_EQ(0, logger.drain(value, printer_visitor{ss}));
+}
+
+UNIT_TEST(variant_logger_threads) {
+  constexpr int num_threads = 4;
+  constexpr int per_thread = 10000;
+
+  variant_logger<event_t> logger{1 << 10};
+  std::vector<event_t> result;
+  event_t value{0};
+
+  // Each thread logs its number and a sequence; the background thread drains
+  // concurrently, and checks that each thread's events are in order.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&logger, t]() {
+      for (int i = 0; i < per_thread; ++i) {
+        while (!logger.log(event_t{std::vector<int32_t>{t, i}})) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  std::size_t total = 0;
+  while (total < num_threads * per_thread) {
+    total += logger.drain(value, collect_visitor{result});
+  }
+  for (std::thread & t : threads) {
+    t.join();
+  }
+
+  TEST_EQ(static_cast<std::size_t>(num_threads * per_thread), result.size());
+  std::vector<int32_t> next(num_threads, 0);
+  bool in_order = true;
+  for (const event_t & e : result) {
+    const std::vector<int32_t> & v = *get<std::vector<int32_t>>(&e);
+    in_order = in_order && v[1] == next[static_cast<std::size_t>(v[0])]++;
+  }
+  TEST_TRUE(in_order);
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Variant log tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -0,0 +1,164 @@
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_compare.hpp>
+#include <strict_variant/variant_hash.hpp>
+#include <strict_variant/variant_lookup.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace strict_variant {
+
+using var_t = variant<int, long, std::string>;
+using hash_t = transparent_variant_hash<var_t>;
+using equal_t = transparent_variant_equal<var_t>;
+using less_t = transparent_variant_comparator<var_t>;
+
+static_assert(std::is_same<hash_t::is_transparent, void>::value, "");
+static_assert(std::is_same<equal_t::is_transparent, void>::value, "");
+static_assert(std::is_same<less_t::is_transparent, void>::value, "");
+
+UNIT_TEST(lookup_hash) {
+  hash_t h;
+  variant_hash<var_t> vh;
+
+  TEST_EQ(h(5), vh(var_t{5}));
+  TEST_EQ(h(5L), vh(var_t{5L}));
+  TEST_EQ(h(std::string{"asdf"}), vh(var_t{"asdf"}));
+  TEST_EQ(h(var_t{"asdf"}), vh(var_t{"asdf"}));
+  TEST_NE(h(5), h(5L));
+
+#if __cplusplus >= 201703L
+  TEST_EQ(h(std::string_view{"asdf"}), vh(var_t{"asdf"}));
+  TEST_EQ(h("asdf"), vh(var_t{"asdf"}));
+#endif
+}
+
+UNIT_TEST(lookup_equal) {
+  equal_t eq;
+
+  TEST_TRUE(eq(var_t{5}, 5));
+  TEST_TRUE(eq(5, var_t{5}));
+  TEST_FALSE(eq(var_t{5}, 5L));
+  TEST_FALSE(eq(var_t{5L}, 5));
+  TEST_FALSE(eq(var_t{5}, 6));
+  TEST_TRUE(eq(var_t{"asdf"}, "asdf"));
+  TEST_TRUE(eq(var_t{"asdf"}, std::string{"asdf"}));
+  TEST_FALSE(eq(var_t{"asdf"}, "jkl"));
+  TEST_FALSE(eq(var_t{5}, "asdf"));
+  TEST_TRUE(eq(var_t{5}, var_t{5}));
+
+#if __cplusplus >= 201703L
+  TEST_TRUE(eq(var_t{"asdf"}, std::string_view{"asdf"}));
+#endif
+
+  // Keys are matched modulo recursive_wrapper
+  using rvar_t = variant<int, recursive_wrapper<std::string>>;
+  transparent_variant_equal<rvar_t> req;
+  transparent_variant_hash<rvar_t> rh;
+  TEST_TRUE(req(rvar_t{"asdf"}, std::string{"asdf"}));
+  TEST_EQ(rh(std::string{"asdf"}), variant_hash<rvar_t>{}(rvar_t{"asdf"}));
+}
+
+// Check that the transparent comparator agrees with variant_comparator, for
+// all pairs drawn from a small list.
+UNIT_TEST(lookup_order) {
+  less_t lt;
+  variant_comparator<var_t> vc;
+
+  std::vector<var_t> vals{var_t{-1}, var_t{0}, var_t{7},     var_t{-1L},
+                          var_t{3L}, var_t{""}, var_t{"abc"}, var_t{"abd"}};
+
+  for (const auto & a : vals) {
+    for (const auto & b : vals) {
+      TEST_EQ(vc(a, b), lt(a, b));
+      switch (b.which()) {
+        case 0:
+          TEST_EQ(vc(a, b), lt(a, get_unchecked<int>(b)));
+          TEST_EQ(vc(b, a), lt(get_unchecked<int>(b), a));
+          break;
+        case 1:
+          TEST_EQ(vc(a, b), lt(a, get_unchecked<long>(b)));
+          TEST_EQ(vc(b, a), lt(get_unchecked<long>(b), a));
+          break;
+        default:
+          TEST_EQ(vc(a, b), lt(a, get_unchecked<std::string>(b)));
+          TEST_EQ(vc(b, a), lt(get_unchecked<std::string>(b), a));
+          TEST_EQ(vc(a, b), lt(a, get_unchecked<std::string>(b).c_str()));
+          TEST_EQ(vc(b, a), lt(get_unchecked<std::string>(b).c_str(), a));
+          break;
+      }
+    }
+  }
+}
+
+// String keys are ordered by the comparator too, not by std::string::compare
+UNIT_TEST(lookup_order_custom) {
+  transparent_variant_comparator<var_t, std::greater> gt;
+  variant_comparator<var_t, std::greater> vc;
+
+  std::vector<var_t> vals{var_t{""}, var_t{"abc"}, var_t{"abd"}, var_t{1}};
+  for (const auto & a : vals) {
+    for (const auto & b : vals) {
+      if (b.which() != 2) { continue; }
+      const std::string & key = get_unchecked<std::string>(b);
+      TEST_EQ(vc(a, b), gt(a, key.c_str()));
+      TEST_EQ(vc(b, a), gt(key.c_str(), a));
+#if __cplusplus >= 201703L
+      TEST_EQ(vc(a, b), gt(a, std::string_view{key}));
+      TEST_EQ(vc(b, a), gt(std::string_view{key}, a));
+#endif
+    }
+  }
+}
+
+// Heterogeneous lookup in std::set requires C++14
+#if __cplusplus >= 201402L
+UNIT_TEST(lookup_set) {
+  std::set<var_t, less_t> s{var_t{1}, var_t{2L}, var_t{"asdf"}};
+
+  TEST_TRUE(s.find(1) != s.end());
+  TEST_TRUE(s.find(2L) != s.end());
+  TEST_TRUE(s.find("asdf") != s.end());
+  TEST_TRUE(s.find(2) == s.end());
+  TEST_TRUE(s.find(1L) == s.end());
+  TEST_TRUE(s.find("jkl") == s.end());
+  TEST_EQ(1, s.count(1));
+
+  std::map<var_t, int, less_t> m;
+  m[var_t{"asdf"}] = 5;
+  TEST_EQ(5, m.find("asdf")->second);
+#if __cplusplus >= 201703L
+  TEST_EQ(5, m.find(std::string_view{"asdf"})->second);
+#endif
+}
+#endif
+
+// Heterogeneous lookup in unordered containers requires C++20
+#if __cplusplus > 201703L && defined(__cpp_lib_generic_unordered_lookup)
+UNIT_TEST(lookup_unordered_set) {
+  std::unordered_set<var_t, hash_t, equal_t> s{var_t{1}, var_t{2L}, var_t{"asdf"}};
+
+  TEST_TRUE(s.find(1) != s.end());
+  TEST_TRUE(s.find(2L) != s.end());
+  TEST_TRUE(s.find("asdf") != s.end());
+  TEST_TRUE(s.find(2) == s.end());
+  TEST_TRUE(s.find(1L) == s.end());
+}
+#endif
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Variant lookup tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -0,0 +1,256 @@
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/thread_pool.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_parallel.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace strict_variant {
+
+using value_t = variant<int, std::string>;
+
+std::vector<value_t>
+make_values(int n) {
+  std::vector<value_t> result;
+  for (int i = 0; i < n; ++i) {
+    if (i % 3) {
+      result.emplace_back(i);
+    } else {
+      result.emplace_back(std::string(static_cast<std::size_t>(i % 7), 'x'));
+    }
+  }
+  return result;
+}
+
+struct count_visitor {
+  std::atomic<int> & ints;
+  std::atomic<int> & strings;
+
+  void operator()(int) const { ++ints; }
+  void operator()(const std::string &) const { ++strings; }
+};
+
+struct size_visitor {
+  std::size_t operator()(int i) const { return static_cast<std::size_t>(i); }
+  std::size_t operator()(const std::string & s) const { return s.size(); }
+};
+
+struct string_visitor {
+  std::string operator()(int i) const { return std::to_string(i) + ","; }
+  std::string operator()(const std::string & s) const { return s + ","; }
+};
+
+UNIT_TEST(parallel_visit) {
+  for (unsigned threads : {1u, 4u}) {
+    thread_pool pool{threads};
+    for (int n : {0, 1, 2, 1000}) {
+      const auto values = make_values(n);
+      std::atomic<int> ints{0};
+      std::atomic<int> strings{0};
+      parallel_visit(values.begin(), values.end(), count_visitor{ints, strings}, pool);
+      TEST_EQ(n - (n + 2) / 3, ints.load());
+      TEST_EQ((n + 2) / 3, strings.load());
+    }
+  }
+}
+
+UNIT_TEST(parallel_transform) {
+  thread_pool pool{4};
+  const auto values = make_values(1000);
+  std::vector<std::size_t> sizes(values.size());
+  auto end = parallel_transform(values.begin(), values.end(), sizes.begin(), size_visitor{}, pool);
+  TEST_TRUE(end == sizes.end());
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    TEST_EQ(apply_visitor(size_visitor{}, values[i]), sizes[i]);
+  }
+}
+
+UNIT_TEST(parallel_reduce) {
+  for (unsigned threads : {1u, 4u}) {
+    thread_pool pool{threads};
+    const auto values = make_values(1000);
+
+    std::size_t serial_sum = 0;
+    std::string serial_string;
+    for (const value_t & v : values) {
+      serial_sum += apply_visitor(size_visitor{}, v);
+      serial_string += apply_visitor(string_visitor{}, v);
+    }
+
+    TEST_EQ(serial_sum, parallel_reduce(values.begin(), values.end(), std::size_t{0},
+                                        size_visitor{}, std::plus<std::size_t>{}, pool, 3));
+
+    // Concatenation is not commutative, so the order of pieces matters
+    TEST_EQ("start," + serial_string,
+            parallel_reduce(values.begin(), values.end(), std::string("start,"),
+                            string_visitor{}, std::plus<std::string>{}, pool, 5));
+
+    TEST_EQ("init", parallel_reduce(values.begin(), values.begin(), std::string("init"),
+                                    string_visitor{}, std::plus<std::string>{}, pool));
+  }
+}
+
+struct throw_visitor {
+  void operator()(int i) const {
+    if (i == 500) { throw std::runtime_error("500"); }
+  }
+  void operator()(const std::string &) const {}
+};
+
+UNIT_TEST(parallel_exception) {
+  thread_pool pool{4};
+  const auto values = make_values(1000);
+  std::string what;
+  try {
+    parallel_visit(values.begin(), values.end(), throw_visitor{}, pool, 10);
+  } catch (std::runtime_error & e) { what = e.what(); }
+  TEST_EQ("500", what);
+
+  // The pool is still usable
+  std::atomic<int> ints{0};
+  std::atomic<int> strings{0};
+  parallel_visit(values.begin(), values.end(), count_visitor{ints, strings}, pool);
+  TEST_EQ(1000, ints + strings);
+}
+
+UNIT_TEST(parallel_nested) {
+  thread_pool pool{4};
+  const auto values = make_values(100);
+  std::atomic<std::size_t> total{0};
+  pool.parallel_for(50, 1, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i != end; ++i) {
+      total += parallel_reduce(values.begin(), values.end(), std::size_t{0}, size_visitor{},
+                               std::plus<std::size_t>{}, pool, 4);
+    }
+  });
+
+  std::size_t serial_sum = 0;
+  for (const value_t & v : values) {
+    serial_sum += apply_visitor(size_visitor{}, v);
+  }
+  TEST_EQ(50 * serial_sum, total.load());
+}
+
+// An expression tree
+struct binop;
+struct sum;
+using expr_t = variant<int, recursive_wrapper<binop>, recursive_wrapper<sum>>;
+
+struct binop {
+  char op;
+  expr_t lhs;
+  expr_t rhs;
+};
+
+struct sum {
+  std::vector<expr_t> terms;
+};
+
+// A balanced tree of `+` and `-`, over the leaves `first, first + 1, ...`
+expr_t
+make_balanced(int first, int depth) {
+  if (!depth) { return expr_t{first}; }
+  const int half = 1 << (depth - 1);
+  std::vector<expr_t> terms;
+  terms.emplace_back(make_balanced(first, depth - 1));
+  terms.emplace_back(binop{'-', make_balanced(first + half, depth - 1), expr_t{1}});
+  return expr_t{sum{std::move(terms)}};
+}
+
+// A left spine of `-`, with a balanced tree on each right side
+expr_t
+make_skewed(int length) {
+  expr_t result{0};
+  for (int i = 0; i < length; ++i) {
+    result = expr_t{binop{'-', std::move(result), make_balanced(i, 6)}};
+  }
+  return result;
+}
+
+struct eval_visitor {
+  template <typename Ctx>
+  long operator()(int i, Ctx &) const {
+    return i;
+  }
+
+  template <typename Ctx>
+  long operator()(const binop & b, Ctx & ctx) const {
+    const auto r = ctx.fold_pair(b.lhs, b.rhs);
+    if (b.op == '/' && !r.second) { throw std::runtime_error("division by zero"); }
+    switch (b.op) {
+      case '-': return r.first - r.second;
+      case '/': return r.first / r.second;
+      default: return r.first + r.second;
+    }
+  }
+
+  template <typename Ctx>
+  long operator()(const sum & s, Ctx & ctx) const {
+    std::vector<long> results(s.terms.size());
+    ctx.fold_each(s.terms.begin(), s.terms.end(), results.begin());
+    long total = 0;
+    for (long r : results) {
+      total += r;
+    }
+    return total;
+  }
+};
+
+struct serial_eval {
+  long operator()(int i) const { return i; }
+  long operator()(const binop & b) const {
+    const long l = apply_visitor(*this, b.lhs);
+    const long r = apply_visitor(*this, b.rhs);
+    return b.op == '-' ? l - r : l + r;
+  }
+  long operator()(const sum & s) const {
+    long total = 0;
+    for (const expr_t & e : s.terms) {
+      total += apply_visitor(*this, e);
+    }
+    return total;
+  }
+};
+
+UNIT_TEST(parallel_fold) {
+  const expr_t balanced = make_balanced(0, 12);
+  const expr_t skewed = make_skewed(200);
+  for (unsigned threads : {1u, 4u}) {
+    thread_pool pool{threads};
+    TEST_EQ(apply_visitor(serial_eval{}, balanced),
+            parallel_fold<long>(balanced, eval_visitor{}, pool));
+    TEST_EQ(apply_visitor(serial_eval{}, skewed),
+            parallel_fold<long>(skewed, eval_visitor{}, pool));
+    TEST_EQ(7, parallel_fold<long>(expr_t{7}, eval_visitor{}, pool));
+  }
+}
+
+UNIT_TEST(parallel_fold_exception) {
+  thread_pool pool{4};
+  std::vector<expr_t> terms;
+  for (int i = 0; i < 64; ++i) {
+    terms.emplace_back(make_balanced(i, 6));
+  }
+  terms.emplace_back(binop{'/', expr_t{1}, expr_t{0}});
+  const expr_t tree{sum{std::move(terms)}};
+
+  std::string what;
+  try {
+    parallel_fold<long>(tree, eval_visitor{}, pool);
+  } catch (std::runtime_error & e) { what = e.what(); }
+  TEST_EQ("division by zero", what);
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Parallel tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -0,0 +1,285 @@
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_serialize.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace strict_variant {
+
+// Serialize and deserialize a list of values, as one buffer
+template <typename V>
+bool
+round_trip(const std::vector<V> & vals) {
+  std::string buffer;
+  for (const V & v : vals) {
+    serialize(v, buffer);
+  }
+
+  byte_source src{buffer.data(), buffer.size()};
+  for (const V & v : vals) {
+    V result{vals.front()};
+    if (!deserialize(src, result) || !(result == v)) { return false; }
+  }
+  return src.remaining() == 0;
+}
+
+// Every proper prefix of the serialized form is rejected
+template <typename V>
+bool
+rejects_truncation(const V & v) {
+  std::vector<unsigned char> buffer;
+  serialize(v, buffer);
+  for (std::size_t n = 0; n < buffer.size(); ++n) {
+    byte_source src{buffer.data(), n};
+    V result{v};
+    if (deserialize(src, result)) { return false; }
+  }
+  return true;
+}
+
+UNIT_TEST(serialize_trivial) {
+  using var_t = variant<int8_t, int32_t, uint64_t, double, bool>;
+
+  std::vector<var_t> vals{var_t{int8_t{-5}}, var_t{int32_t{70000}}, var_t{uint64_t{1} << 40},
+                          var_t{2.5}, var_t{true}};
+  TEST_TRUE(round_trip(vals));
+
+  // One byte tag, then raw bytes
+  std::string buffer;
+  serialize(var_t{int32_t{1}}, buffer);
+  TEST_EQ(5, buffer.size());
+  TEST_EQ(1, buffer[0]);
+
+  for (const var_t & v : vals) {
+    TEST_TRUE(rejects_truncation(v));
+  }
+
+  // Bad tag
+  const unsigned char bad[] = {7, 0, 0, 0, 0, 0, 0, 0, 0};
+  byte_source src{bad, sizeof(bad)};
+  var_t result{int8_t{0}};
+  TEST_FALSE(deserialize(src, result));
+
+  // A bool which is neither false nor true
+  const unsigned char bad_bool[] = {4, 2};
+  byte_source bool_src{bad_bool, sizeof(bad_bool)};
+  TEST_FALSE(deserialize(bool_src, result));
+  TEST_EQ(0, *get<int8_t>(&result));
+}
+
+// Counts constructions, to check that deserialize constructs in place
+struct counted {
+  static int default_constructions;
+  static int constructions;
+
+  std::string value;
+
+  counted() { ++default_constructions; }
+  explicit counted(const char * data, std::size_t size)
+    : value(data, size) {
+    ++constructions;
+  }
+  counted(const counted &) = default;
+  counted(counted &&) = default;
+  counted & operator=(const counted &) = default;
+  counted & operator=(counted &&) = default;
+
+  bool operator==(const counted & o) const { return value == o.value; }
+};
+
+int counted::default_constructions = 0;
+int counted::constructions = 0;
+
+template <>
+struct serialize_traits<counted> {
+  template <typename Sink>
+  static void write(const counted & c, Sink & sink) {
+    serialize_traits<std::string>::write(c.value, sink);
+  }
+
+  template <typename Emplacer>
+  static bool read(byte_source & src, Emplacer && emplace) {
+    return serialize_traits<std::string>::read(src, emplace);
+  }
+};
+
+UNIT_TEST(serialize_extension) {
+  using var_t = variant<int, counted>;
+
+  counted c{"asdf", 4};
+  std::string buffer;
+  serialize(var_t{c}, buffer);
+
+  counted::constructions = 0;
+  var_t result{5};
+  byte_source src{buffer.data(), buffer.size()};
+  TEST_TRUE(deserialize(src, result));
+  TEST_EQ(1, result.which());
+  TEST_EQ("asdf", get<counted>(&result)->value);
+  TEST_EQ(1, counted::constructions);
+  TEST_EQ(0, counted::default_constructions);
+}
+
+UNIT_TEST(serialize_containers) {
+  using var_t = variant<int, std::string, std::vector<int>, std::vector<std::string>>;
+
+  std::vector<var_t> vals{
+    var_t{5},
+    var_t{std::string{}},
+    var_t{std::string("a\0b", 3)},
+    var_t{std::vector<int>{}},
+    var_t{std::vector<int>{1, 2, 3}},
+    var_t{std::vector<std::string>{"a", "", "bc"}},
+  };
+  TEST_TRUE(round_trip(vals));
+
+  for (const var_t & v : vals) {
+    TEST_TRUE(rejects_truncation(v));
+  }
+
+  // A huge length is rejected, rather than allocated
+  std::string buffer;
+  buffer.push_back(2);
+  detail::put_varint(uint64_t{1} << 40, buffer);
+  byte_source src{buffer.data(), buffer.size()};
+  var_t result{5};
+  TEST_FALSE(deserialize(src, result));
+}
+
+// A recursive type: a tree of ints
+struct node;
+using tree_t = variant<int, recursive_wrapper<node>>;
+
+struct node {
+  std::vector<tree_t> children;
+  bool operator==(const node & o) const { return children == o.children; }
+};
+
+template <>
+struct serialize_traits<node> {
+  template <typename Sink>
+  static void write(const node & n, Sink & sink) {
+    serialize_traits<std::vector<tree_t>>::write(n.children, sink);
+  }
+
+  template <typename Emplacer>
+  static bool read(byte_source & src, Emplacer && emplace) {
+    struct make_node {
+      Emplacer & emplace;
+      void operator()(std::vector<tree_t> && children) const {
+        emplace(node{std::move(children)});
+      }
+    };
+    return serialize_traits<std::vector<tree_t>>::read(src, make_node{emplace});
+  }
+};
+
+UNIT_TEST(serialize_recursive) {
+  tree_t leaf{1};
+  tree_t inner{node{{tree_t{2}, tree_t{3}}}};
+  tree_t root{node{{leaf, inner, tree_t{node{}}}}};
+
+  TEST_TRUE(round_trip(std::vector<tree_t>{leaf, inner, root}));
+  TEST_TRUE(rejects_truncation(root));
+}
+
+// A chain of `depth` nodes, each with one child, ending in a leaf. Each node
+// is a tag and a vector length, so this is two bytes per level.
+std::string
+deep_chain(std::size_t depth) {
+  std::string buffer;
+  for (std::size_t i = 0; i < depth; ++i) {
+    buffer += '\1';
+    buffer += '\1';
+  }
+  serialize(tree_t{7}, buffer);
+  return buffer;
+}
+
+UNIT_TEST(serialize_depth_limit) {
+  // Each node nests a variant and a vector, so 63 nodes fit in the default
+  // limit of 128
+  {
+    const std::string buffer = deep_chain(63);
+    byte_source src{buffer.data(), buffer.size()};
+    tree_t result{0};
+    TEST_TRUE(deserialize(src, result));
+    TEST_EQ(0, src.remaining());
+  }
+  {
+    const std::string buffer = deep_chain(64);
+    byte_source src{buffer.data(), buffer.size()};
+    tree_t result{0};
+    TEST_FALSE(deserialize(src, result));
+  }
+
+  // Far too deep to read recursively
+  {
+    const std::string buffer = deep_chain(2000000);
+    byte_source src{buffer.data(), buffer.size()};
+    tree_t result{0};
+    TEST_FALSE(deserialize(src, result));
+  }
+
+  // The limit may be raised
+  {
+    const std::string buffer = deep_chain(200);
+    byte_source src{buffer.data(), buffer.size(), 1000};
+    tree_t result{0};
+    TEST_TRUE(deserialize(src, result));
+    TEST_EQ(1000, src.depth_left);
+  }
+}
+
+UNIT_TEST(serialize_nested) {
+  using inner_t = variant<int, std::string>;
+  using var_t = variant<double, inner_t>;
+
+  std::vector<var_t> vals{var_t{1.5}, var_t{emplace_tag<inner_t>{}, 5},
+                          var_t{emplace_tag<inner_t>{}, "asdf"}};
+  TEST_TRUE(round_trip(vals));
+
+  std::string buffer;
+  serialize(vals[1], buffer);
+  TEST_EQ(6, buffer.size());
+}
+
+// Variants with more than 256 value types use a varint tag. (A variant with
+// that many types is very slow to compile, so test the tag encoding directly.)
+UNIT_TEST(serialize_varint_tag) {
+  using codec_t = detail::tag_codec<300>;
+
+  for (unsigned which : {0u, 127u, 128u, 299u}) {
+    std::string buffer;
+    codec_t::write(which, buffer);
+    TEST_EQ((which < 128 ? 1 : 2), buffer.size());
+
+    byte_source src{buffer.data(), buffer.size()};
+    std::size_t result = 1000;
+    TEST_TRUE(codec_t::read(src, result));
+    TEST_EQ(which, result);
+    TEST_EQ(0, src.remaining());
+  }
+
+  // Out of range, and truncated
+  std::string buffer;
+  codec_t::write(300, buffer);
+  byte_source src{buffer.data(), buffer.size()};
+  std::size_t result;
+  TEST_FALSE(codec_t::read(src, result));
+
+  byte_source src2{buffer.data(), 1};
+  TEST_FALSE(codec_t::read(src2, result));
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Variant serialization tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -0,0 +1,269 @@
+#include <strict_variant/offset_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_shm_ring.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace strict_variant {
+
+// A list, whose nodes are in the arena
+struct nil {};
+struct cons;
+using list_t = variant<nil, offset_wrapper<cons>>;
+
+struct cons {
+  int32_t head;
+  list_t tail;
+};
+
+struct order {
+  uint64_t id;
+  offset_array<char> note;
+};
+
+template <>
+struct is_position_independent<cons> : std::true_type {};
+
+template <>
+struct is_position_independent<order> : std::true_type {};
+
+using msg_t = variant<int32_t, offset_array<char>, order, offset_wrapper<cons>>;
+
+static_assert(is_position_independent<msg_t>::value, "msg_t is position independent");
+
+// What the wrappers hold must be position independent too
+static_assert(!is_position_independent<variant<int, offset_wrapper<std::string>>>::value,
+              "a string holds a pointer");
+static_assert(!is_position_independent<offset_array<std::string>>::value,
+              "a string holds a pointer");
+
+// Pointers are trivially copyable, but are addresses in one process
+static_assert(!is_position_independent<variant<int, const char *>>::value,
+              "a pointer is not position independent");
+static_assert(!is_position_independent<int cons::*>::value,
+              "a member pointer is not position independent");
+static_assert(!is_position_independent<offset_array<void *[2]>>::value,
+              "an array of pointers is not position independent");
+
+// The list 1, 2, ..., n, for n > 0
+cons
+make_list(int32_t n) {
+  list_t tail{nil{}};
+  for (int32_t i = n; i > 1; --i) {
+    tail = cons{i, std::move(tail)};
+  }
+  return cons{1, std::move(tail)};
+}
+
+struct describe_visitor {
+  std::string operator()(int32_t i) const { return "int " + std::to_string(i); }
+  std::string operator()(const offset_array<char> & s) const {
+    return "string " + std::string(s.begin(), s.end());
+  }
+  std::string operator()(const order & o) const {
+    return "order " + std::to_string(o.id) + " " + std::string(o.note.begin(), o.note.end());
+  }
+  std::string operator()(const cons & c) const {
+    std::string result = "list";
+    const list_t * l = &c.tail;
+    result += " " + std::to_string(c.head);
+    while (const cons * next = get<cons>(l)) {
+      result += " " + std::to_string(next->head);
+      l = &next->tail;
+    }
+    return result;
+  }
+};
+
+std::string
+describe(const msg_t & m) {
+  return apply_visitor(describe_visitor{}, m);
+}
+
+// Two mappings, at different addresses, of a temporary file
+struct double_mapping {
+  std::size_t size;
+  void * first = nullptr;
+  void * second = nullptr;
+
+  explicit double_mapping(std::size_t n)
+    : size(n) {
+    char name[] = "/tmp/strict_variant_shm_ring_XXXXXX";
+    const int fd = ::mkstemp(name);
+    ::unlink(name);
+    if (fd < 0 || ::ftruncate(fd, static_cast<off_t>(size)) != 0) { return; }
+    first = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    second = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+  }
+
+  ~double_mapping() {
+    ::munmap(first, size);
+    ::munmap(second, size);
+  }
+};
+
+UNIT_TEST(offset_wrapper_private) {
+  // Without an arena, values are on the heap, and behave as usual
+  msg_t a{order{7, std::string("abc")}};
+  msg_t b{a};
+  TEST_EQ("order 7 abc", describe(b));
+
+  msg_t c{std::move(b)};
+  TEST_EQ("order 7 abc", describe(c));
+
+  msg_t d{make_list(4)};
+  TEST_EQ("list 1 2 3 4", describe(d));
+  d = c;
+  TEST_EQ("order 7 abc", describe(d));
+  d = offset_array<char>{'x', 'y'};
+  TEST_EQ("string xy", describe(d));
+  d = 5;
+  TEST_EQ("int 5", describe(d));
+}
+
+UNIT_TEST(offset_wrapper_relocation) {
+  // A value and its arena, in one buffer, may be read after copying the buffer
+  struct alignas(64) block {
+    unsigned char bytes[4096];
+  };
+  std::vector<block> first(1), second(1);
+  unsigned char * buffer = first[0].bytes;
+
+  shm_arena * arena = shm_arena::create(buffer + 64, sizeof(block) - 64);
+  TEST_TRUE(arena != nullptr);
+  msg_t * m;
+  {
+    shm_arena::scope scope{*arena};
+    m = new (buffer) msg_t{make_list(10)};
+  }
+  TEST_TRUE(arena->used() >= 10 * sizeof(cons));
+
+  std::memcpy(second[0].bytes, buffer, sizeof(block));
+  m->~msg_t();
+  std::memset(buffer, 0, sizeof(block));
+  TEST_EQ("list 1 2 3 4 5 6 7 8 9 10",
+          describe(*reinterpret_cast<const msg_t *>(second[0].bytes)));
+
+  // An arena which is too small
+  shm_arena * small = shm_arena::create(buffer, 128);
+  shm_arena::scope scope{*small};
+  bool thrown = false;
+  try {
+    cons c = make_list(100);
+  } catch (std::bad_alloc &) {
+    thrown = true;
+  }
+  TEST_TRUE(thrown);
+}
+
+UNIT_TEST(shm_ring_two_mappings) {
+  using ring_t = shm_ring<msg_t>;
+  double_mapping mem{ring_t::required_size(8, 1024)};
+  TEST_TRUE(mem.first != MAP_FAILED && mem.second != MAP_FAILED);
+  TEST_TRUE(mem.first != mem.second);
+
+  ring_t * producer = ring_t::create(mem.first, 5, 1024);
+  ring_t * consumer = ring_t::attach(mem.second);
+  TEST_TRUE(consumer != nullptr);
+  TEST_EQ(8, consumer->capacity());
+
+  std::vector<std::string> result;
+  auto collect = [&result](const msg_t & m) { result.push_back(describe(m)); };
+
+  TEST_TRUE(producer->try_emplace<int32_t>(5));
+  TEST_TRUE(producer->try_emplace<offset_array<char>>(std::string("hello")));
+  TEST_TRUE(producer->try_emplace<order>(order{12, std::string("note")}));
+  TEST_TRUE(producer->try_push(msg_t{make_list(3)}));
+  TEST_EQ(4, consumer->consume_all(collect));
+  TEST_EQ(4, result.size());
+  TEST_EQ("int 5", result[0]);
+  TEST_EQ("string hello", result[1]);
+  TEST_EQ("order 12 note", result[2]);
+  TEST_EQ("list 1 2 3", result[3]);
+
+  // The ring is bounded
+  int pushed = 0;
+  while (producer->try_emplace<int32_t>(pushed)) {
+    ++pushed;
+  }
+  TEST_EQ(8, pushed);
+  TEST_TRUE(consumer->try_consume(collect));
+  TEST_TRUE(producer->try_emplace<int32_t>(100));
+  TEST_EQ(8, consumer->consume_all(collect));
+  TEST_EQ("int 100", result.back());
+
+  // A payload which does not fit in a slot is skipped
+  bool thrown = false;
+  try {
+    producer->try_emplace<offset_array<char>>(std::string(2000, 'x'));
+  } catch (std::bad_alloc &) {
+    thrown = true;
+  }
+  TEST_TRUE(thrown);
+  TEST_TRUE(producer->try_emplace<int32_t>(101));
+  TEST_TRUE(consumer->try_consume(collect));
+  TEST_EQ("int 101", result.back());
+  TEST_FALSE(consumer->try_consume(collect));
+
+  // Not a ring
+  std::vector<uint64_t> zeros(64);
+  TEST_TRUE(ring_t::attach(zeros.data()) == nullptr);
+}
+
+UNIT_TEST(shm_ring_producers) {
+  using ring_t = shm_ring<msg_t>;
+  constexpr int num_threads = 4;
+  constexpr int per_thread = 20000;
+
+  double_mapping mem{ring_t::required_size(64, 256)};
+  ring_t * producer = ring_t::create(mem.first, 64, 256);
+  ring_t * consumer = ring_t::attach(mem.second);
+
+  // Each thread sends its number and a sequence, in a list
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([producer, t]() {
+      for (int32_t i = 0; i < per_thread; ++i) {
+        while (!producer->try_emplace<cons>(cons{t, cons{i, nil{}}})) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  std::vector<int32_t> next(num_threads, 0);
+  bool in_order = true;
+  int total = 0;
+  while (total < num_threads * per_thread) {
+    total += static_cast<int>(consumer->consume_all([&](const msg_t & m) {
+      const cons & c = *get<cons>(&m);
+      const cons & seq = *get<cons>(&c.tail);
+      in_order = in_order && seq.head == next[static_cast<std::size_t>(c.head)]++;
+    }));
+  }
+  for (std::thread & t : threads) {
+    t.join();
+  }
+  TEST_TRUE(in_order);
+  TEST_FALSE(consumer->try_consume([](const msg_t &) {}));
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Variant shared memory ring tests:" << std::endl;
+  return test_registrar::run_tests();
+}
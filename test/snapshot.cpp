@@ -0,0 +1,158 @@
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_snapshot.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace strict_variant {
+
+// Counts live instances
+struct tracked {
+  static std::atomic<int> live;
+  int value;
+
+  explicit tracked(int v)
+    : value(v) {
+    ++live;
+  }
+  tracked(const tracked & other)
+    : value(other.value) {
+    ++live;
+  }
+  tracked(tracked && other) noexcept
+    : value(other.value) {
+    ++live;
+  }
+  tracked & operator=(const tracked &) = default;
+  tracked & operator=(tracked &&) noexcept = default;
+  ~tracked() noexcept { --live; }
+};
+
+std::atomic<int> tracked::live{0};
+
+using value_t = variant<tracked, std::string>;
+
+UNIT_TEST(snapshot_basic) {
+  {
+    variant_snapshot<value_t> s{tracked{1}};
+    auto r = s.make_reader();
+
+    {
+      auto g = r.read();
+      TEST_EQ(1, get<tracked>(&*g)->value);
+
+      // The old value lives until the guard is released
+      s.store(value_t{std::string("two")});
+      TEST_EQ(1, get<tracked>(g.get())->value);
+      TEST_EQ(1, tracked::live);
+      TEST_EQ(1, s.retired_count());
+
+      // Nested guards see the new value
+      auto g2 = r.read();
+      TEST_EQ("two", *get<std::string>(g2.get()));
+    }
+    s.reclaim();
+    TEST_EQ(0, s.retired_count());
+    TEST_EQ(0, tracked::live);
+
+    // Updates apply to a copy of the current value
+    s.emplace(tracked{3});
+    s.update([](value_t & v) { get<tracked>(&v)->value += 1; });
+    TEST_EQ(4, get<tracked>(r.read().get())->value);
+    TEST_EQ(1, tracked::live);
+  }
+  TEST_EQ(0, tracked::live);
+}
+
+UNIT_TEST(snapshot_readers) {
+  variant_snapshot<value_t> s{std::string("a")};
+  {
+    auto r1 = s.make_reader();
+    auto r2 = s.make_reader();
+    auto g = r1.read();
+    s.store(value_t{std::string("b")});
+    TEST_EQ("b", *get<std::string>(r2.read().get()));
+    s.reclaim();
+    TEST_EQ(1, s.retired_count());
+  }
+  // Records of destroyed readers are reused, and are not reading
+  auto r3 = s.make_reader();
+  s.reclaim();
+  TEST_EQ(0, s.retired_count());
+  TEST_EQ("b", *get<std::string>(r3.read().get()));
+}
+
+// A routing table, as a tree, in which each leaf holds the version number
+struct branch;
+using tree_t = variant<int, recursive_wrapper<branch>>;
+
+struct branch {
+  tree_t left;
+  tree_t right;
+};
+
+tree_t
+make_tree(int depth, int version) {
+  if (!depth) { return tree_t{version}; }
+  return tree_t{branch{make_tree(depth - 1, version), make_tree(depth - 1, version)}};
+}
+
+// Returns -1 if the leaves differ
+struct leaf_visitor {
+  int operator()(int v) const { return v; }
+  int operator()(const branch & b) const {
+    const int l = apply_visitor(*this, b.left);
+    const int r = apply_visitor(*this, b.right);
+    return l == r ? l : -1;
+  }
+};
+
+UNIT_TEST(snapshot_concurrent) {
+  constexpr int num_readers = 4;
+  constexpr int num_versions = 300;
+
+  variant_snapshot<tree_t> s{make_tree(6, 0)};
+  std::atomic<bool> done{false};
+  std::atomic<bool> consistent{true};
+
+  std::vector<std::thread> readers;
+  for (int t = 0; t < num_readers; ++t) {
+    readers.emplace_back([&]() {
+      auto r = s.make_reader();
+      int last = 0;
+      while (!done.load()) {
+        auto g = r.read();
+        const int v = apply_visitor(leaf_visitor{}, *g);
+        // Versions are whole, and never go back
+        if (v < last) { consistent = false; }
+        last = v;
+      }
+    });
+  }
+
+  for (int v = 1; v <= num_versions; ++v) {
+    s.store(make_tree(6, v));
+  }
+  done = true;
+  for (std::thread & t : readers) {
+    t.join();
+  }
+  TEST_TRUE(consistent);
+  s.reclaim();
+  TEST_EQ(0, s.retired_count());
+  TEST_EQ(num_versions, apply_visitor(leaf_visitor{}, *s.make_reader().read()));
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Variant snapshot tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -0,0 +1,163 @@
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_compare.hpp>
+#include <strict_variant/variant_relational_ops.hpp>
+#include <strict_variant/variant_sort_key.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace strict_variant {
+
+template <typename V>
+std::string
+sort_key(const V & v) {
+  std::string result;
+  encode_sort_key(v, result);
+  return result;
+}
+
+// Check that the order of the sort keys is the same as variant_comparator,
+// for all pairs in the list.
+template <typename V>
+bool
+check_order(const std::vector<V> & vals) {
+  variant_comparator<V> vc;
+  for (const auto & a : vals) {
+    for (const auto & b : vals) {
+      const std::string ka = sort_key(a);
+      const std::string kb = sort_key(b);
+      if (vc(a, b) != (ka < kb)) { return false; }
+      if ((!vc(a, b) && !vc(b, a)) != (ka == kb)) { return false; }
+    }
+  }
+  return true;
+}
+
+UNIT_TEST(sort_key_integers) {
+  using var_t = variant<int8_t, uint16_t, int32_t, int64_t, uint64_t, bool, char>;
+
+  std::vector<var_t> vals{
+    var_t{int8_t{-128}},
+    var_t{int8_t{-1}},
+    var_t{int8_t{0}},
+    var_t{int8_t{127}},
+    var_t{uint16_t{0}},
+    var_t{uint16_t{255}},
+    var_t{uint16_t{256}},
+    var_t{uint16_t{65535}},
+    var_t{std::numeric_limits<int32_t>::min()},
+    var_t{int32_t{-70000}},
+    var_t{int32_t{-1}},
+    var_t{int32_t{0}},
+    var_t{int32_t{1}},
+    var_t{int32_t{70000}},
+    var_t{std::numeric_limits<int32_t>::max()},
+    var_t{std::numeric_limits<int64_t>::min()},
+    var_t{int64_t{-1}},
+    var_t{int64_t{1} << 40},
+    var_t{uint64_t{0}},
+    var_t{std::numeric_limits<uint64_t>::max()},
+    var_t{false},
+    var_t{true},
+    var_t{'a'},
+    var_t{'z'},
+  };
+
+  TEST_TRUE(check_order(vals));
+
+  // Tag first, then big-endian value with flipped sign bit
+  TEST_EQ(std::string("\x02\x80\x00\x00\x01", 5), sort_key(var_t{int32_t{1}}));
+}
+
+UNIT_TEST(sort_key_floats) {
+  using var_t = variant<float, double>;
+
+  const double inf = std::numeric_limits<double>::infinity();
+  std::vector<var_t> vals{
+    var_t{-std::numeric_limits<float>::infinity()},
+    var_t{-1.5f},
+    var_t{-std::numeric_limits<float>::denorm_min()},
+    var_t{0.0f},
+    var_t{-0.0f},
+    var_t{std::numeric_limits<float>::min()},
+    var_t{1.0f},
+    var_t{1e30f},
+    var_t{-inf},
+    var_t{-std::numeric_limits<double>::max()},
+    var_t{-2.0},
+    var_t{-0.5},
+    var_t{-0.0},
+    var_t{0.0},
+    var_t{0.5},
+    var_t{2.0},
+    var_t{inf},
+  };
+
+  TEST_TRUE(check_order(vals));
+  TEST_EQ(sort_key(var_t{0.0}), sort_key(var_t{-0.0}));
+
+  // NaNs are all placed after infinity
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  TEST_EQ(sort_key(var_t{nan}), sort_key(var_t{-nan}));
+  TEST_TRUE(sort_key(var_t{inf}) < sort_key(var_t{nan}));
+}
+
+UNIT_TEST(sort_key_strings) {
+  using var_t = variant<int, std::string>;
+
+  std::vector<var_t> vals{
+    var_t{5},
+    var_t{""},
+    var_t{std::string("\0", 1)},
+    var_t{std::string("\0\0", 2)},
+    var_t{std::string("\0\x01", 2)},
+    var_t{std::string("\x01", 1)},
+    var_t{"a"},
+    var_t{std::string("a\0", 2)},
+    var_t{std::string("a\0b", 3)},
+    var_t{"ab"},
+    var_t{"abc"},
+    var_t{"b"},
+    var_t{"\x7f"},
+    var_t{"\x80"},
+    var_t{"\xff"},
+    var_t{"\xff\xff"},
+  };
+
+  TEST_TRUE(check_order(vals));
+}
+
+// Recursive wrappers are pierced, and nested variants are encoded in place.
+// (Nested variants are ordered by the operator < from variant_relational_ops.)
+UNIT_TEST(sort_key_nested) {
+  using inner_t = variant<int, std::string>;
+  using var_t = variant<inner_t, recursive_wrapper<std::string>, double>;
+
+  using inner_tag = emplace_tag<inner_t>;
+  using string_tag = emplace_tag<std::string>;
+
+  std::vector<var_t> vals{
+    var_t{inner_tag{}, -1},  var_t{inner_tag{}, 1},     var_t{inner_tag{}, ""},
+    var_t{inner_tag{}, "a"}, var_t{string_tag{}, ""},   var_t{string_tag{}, "a"},
+    var_t{-1.0},             var_t{1.0},
+  };
+
+  TEST_TRUE(check_order(vals));
+
+  std::vector<unsigned char> bytes;
+  encode_sort_key(var_t{inner_tag{}, 1}, bytes);
+  TEST_EQ(6, bytes.size());
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Variant sort key tests:" << std::endl;
+  return test_registrar::run_tests();
+}
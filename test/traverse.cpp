@@ -0,0 +1,165 @@
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_traverse.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace strict_variant {
+
+// An expression tree
+struct binop;
+struct call;
+using expr_t = variant<int, recursive_wrapper<binop>, recursive_wrapper<call>>;
+
+struct binop {
+  char op;
+  expr_t lhs;
+  expr_t rhs;
+};
+
+struct call {
+  std::string name;
+  std::vector<expr_t> args;
+};
+
+struct expr_children {
+  template <typename Push>
+  void operator()(const binop & b, Push & push) const {
+    push(b.lhs);
+    push(b.rhs);
+  }
+
+  template <typename Push>
+  void operator()(const call & c, Push & push) const {
+    for (const expr_t & e : c.args) {
+      push(e);
+    }
+  }
+
+  template <typename Push>
+  void operator()(int, Push &) const {}
+};
+
+struct name_visitor {
+  std::string & out;
+
+  void operator()(int i) const { out += std::to_string(i) + " "; }
+  void operator()(const binop & b) const { out += std::string(1, b.op) + " "; }
+  void operator()(const call & c) const { out += c.name + " "; }
+};
+
+struct eval_visitor {
+  int operator()(int i, const child_results<int> &) const { return i; }
+  int operator()(const binop & b, const child_results<int> & r) const {
+    return b.op == '-' ? r[0] - r[1] : r[0] * r[1];
+  }
+  // Returns the maximum, or zero
+  int operator()(const call &, const child_results<int> & r) const {
+    int result = 0;
+    for (int x : r) {
+      if (x > result) { result = x; }
+    }
+    return result;
+  }
+};
+
+// max(1 - 2, 3 * 4, max()) * 5
+expr_t
+make_expr() {
+  std::vector<expr_t> args;
+  args.emplace_back(binop{'-', expr_t{1}, expr_t{2}});
+  args.emplace_back(binop{'*', expr_t{3}, expr_t{4}});
+  args.emplace_back(call{"max", {}});
+  return expr_t{binop{'*', expr_t{call{"max", std::move(args)}}, expr_t{5}}};
+}
+
+UNIT_TEST(traverse_order) {
+  const expr_t e = make_expr();
+  std::string pre;
+  visit_preorder(e, expr_children{}, name_visitor{pre});
+  TEST_EQ("* max - 1 2 * 3 4 max 5 ", pre);
+
+  std::string post;
+  visit_postorder(e, expr_children{}, name_visitor{post});
+  TEST_EQ("1 2 - 3 4 * max max 5 * ", post);
+
+  std::string leaf;
+  visit_postorder(expr_t{7}, expr_children{}, name_visitor{leaf});
+  TEST_EQ("7 ", leaf);
+}
+
+UNIT_TEST(traverse_fold) {
+  TEST_EQ(60, fold_tree<int>(make_expr(), expr_children{}, eval_visitor{}));
+  TEST_EQ(7, fold_tree<int>(expr_t{7}, expr_children{}, eval_visitor{}));
+}
+
+// A list, 10^6 long, which would overflow the stack if visited recursively
+struct cons;
+using list_t = variant<int, recursive_wrapper<cons>>;
+
+struct cons {
+  int head;
+  list_t tail;
+};
+
+struct list_children {
+  template <typename Push>
+  void operator()(const cons & c, Push & push) const {
+    push(c.tail);
+  }
+
+  template <typename Push>
+  void operator()(int, Push &) const {}
+};
+
+struct list_sum {
+  long operator()(int i, const child_results<long> &) const { return i; }
+  long operator()(const cons & c, const child_results<long> & r) const { return c.head + r[0]; }
+};
+
+struct list_count {
+  long & count;
+
+  template <typename T>
+  void operator()(const T &) const {
+    ++count;
+  }
+};
+
+UNIT_TEST(traverse_deep) {
+  constexpr int length = 1000000;
+  // Moving a variant moves the value in a recursive_wrapper, which would
+  // recurse, so the list is built from the head, and taken apart by swaps
+  list_t list{0};
+  list_t * tail = &list;
+  for (int i = 1; i <= length; ++i) {
+    tail->emplace<cons>(cons{i, list_t{0}});
+    tail = &get<cons>(tail)->tail;
+  }
+
+  long count = 0;
+  visit_preorder(list, list_children{}, list_count{count});
+  TEST_EQ(length + 1, count);
+  visit_postorder(list, list_children{}, list_count{count});
+  TEST_EQ(2 * (length + 1), count);
+  TEST_EQ(long{length} * (length + 1) / 2, fold_tree<long>(list, list_children{}, list_sum{}));
+
+  // Destroying the list recursively would overflow the stack too
+  while (cons * c = get<cons>(&list)) {
+    list_t rest{0};
+    rest.swap(c->tail);
+    list.swap(rest);
+  }
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Traverse tests:" << std::endl;
+  return test_registrar::run_tests();
+}
@@ -443,6 +443,32 @@ UNIT_TEST(get_index) {
   TEST_EQ(1234.0, *a.get<2>());
 }
 
+// Test unchecked get
+UNIT_TEST(get_unchecked) {
+  typedef variant<int, float, recursive_wrapper<std::string>> Var_t;
+
+  Var_t a{5};
+  TEST_EQ(5, a.get_unchecked<int>());
+  TEST_EQ(5, a.get_unchecked<0>());
+  TEST_EQ(5, get_unchecked<int>(a));
+
+  a.get_unchecked<0>() = 7;
+  TEST_EQ(7, *a.get<int>());
+
+  a = 1234.0f;
+  TEST_EQ(1234.0f, get_unchecked<1>(a));
+
+  const Var_t & c = a;
+  TEST_EQ(1234.0f, c.get_unchecked<float>());
+
+  a = "asdf";
+  TEST_EQ("asdf", a.get_unchecked<std::string>());
+  TEST_EQ("asdf", get_unchecked<2>(c));
+
+  std::string s{get_unchecked<std::string>(std::move(a))};
+  TEST_EQ("asdf", s);
+}
+
 // Test Emplace function
 
 UNIT_TEST(emplace) {
@@ -516,6 +542,32 @@ UNIT_TEST(equality) {
   TEST_NE(b, Var_t2{"true"});
 }
 
+// Test equality using memcmp
+
+static_assert(is_bitwise_comparable<int>::value, "failed a unit test");
+static_assert(!is_bitwise_comparable<float>::value, "failed a unit test");
+static_assert(!is_bitwise_comparable<std::string>::value, "failed a unit test");
+static_assert(variant<int, unsigned int>::bitwise_equality, "failed a unit test");
+static_assert(!variant<int, float>::bitwise_equality, "failed a unit test");
+static_assert(!variant<int, char>::bitwise_equality, "failed a unit test");
+static_assert(is_bitwise_comparable<variant<int, unsigned int>>::value, "failed a unit test");
+static_assert(!is_bitwise_comparable<variant<long long, unsigned long long>>::value,
+              "failed a unit test");
+
+UNIT_TEST(bitwise_equality) {
+  typedef variant<int, unsigned int> Var_t;
+
+  Var_t a{5};
+  TEST_EQ(a, Var_t{5});
+  TEST_NE(a, Var_t{5u});
+  TEST_NE(a, Var_t{6});
+
+  a = 6u;
+  TEST_EQ(a, Var_t{6u});
+  TEST_NE(a, Var_t{6});
+  TEST_NE(a, Var_t{5u});
+}
+
 // Test recrusive wrapper, promotion, etc.
 struct dummy;
 struct crummy;
@@ -1033,6 +1085,7 @@ UNIT_TEST(copy_assign_recursive_wrapper) {
   struct D {
     D() noexcept {}
     D(const D &) noexcept {};
+    D & operator=(const D &) = default;
     // D & operator =(const D &) = delete;
   };
 
@@ -1047,6 +1100,7 @@ UNIT_TEST(variant_assignment) {
   struct D {
     D() noexcept {}
     D(const D &) noexcept {};
+    D & operator=(const D &) = default;
     // D & operator =(const D &) = delete;
   };
 
@@ -1159,6 +1213,29 @@ UNIT_TEST(variant_swap) {
       TEST_EQ(i % 2, 1 - vec[i].which());
     }
   }
+
+  // Member swap
+  {
+    using var_t = variant<int, recursive_wrapper<std::string>>;
+
+    var_t x{5};
+    var_t y{"foo"};
+    x.swap(y);
+    TEST_EQ(x.which(), 1);
+    TEST_EQ(y.which(), 0);
+    TEST_EQ("foo", *get<std::string>(&x));
+    TEST_EQ(5, *get<int>(&y));
+
+    var_t z{"bar"};
+    x.swap(z);
+    TEST_EQ("bar", *get<std::string>(&x));
+    TEST_EQ("foo", *get<std::string>(&z));
+
+    var_t w{7};
+    y.swap(w);
+    TEST_EQ(7, *get<int>(&y));
+    TEST_EQ(5, *get<int>(&w));
+  }
 }
 
 } // end namespace strict_variant
@@ -0,0 +1,227 @@
+#include <strict_variant/recursive_wrapper.hpp>
+#include <strict_variant/variant.hpp>
+#include <strict_variant/variant_serialize.hpp>
+#include <strict_variant/variant_view.hpp>
+
+#include "test_harness/test_harness.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace strict_variant {
+
+// Converts views back to strings, to check what the visitor was passed
+struct describe_visitor {
+  std::string operator()(int32_t i) const { return "int " + std::to_string(i); }
+  std::string operator()(double d) const { return "double " + std::to_string(d); }
+  std::string operator()(const string_ref & s) const { return "string " + s.str(); }
+
+  std::string operator()(const vector_ref<int32_t> & v) const {
+    std::string result = "ints";
+    for (int32_t i : v) {
+      result += " " + std::to_string(i);
+    }
+    return result;
+  }
+
+  std::string operator()(const vector_ref<std::string> & v) const {
+    std::string result = "strings";
+    for (string_ref s : v) {
+      result += " " + s.str();
+    }
+    return result;
+  }
+
+  template <typename... Ts>
+  std::string operator()(const variant_view<Ts...> & v) const {
+    return "(" + apply_visitor(*this, v) + ")";
+  }
+};
+
+template <typename V>
+std::string
+serialize_all(const std::vector<V> & vals) {
+  std::string buffer;
+  for (const V & v : vals) {
+    serialize(v, buffer);
+  }
+  return buffer;
+}
+
+UNIT_TEST(variant_view_basic) {
+  using var_t = variant<int32_t, double, std::string, std::vector<int32_t>, std::vector<std::string>>;
+
+  std::vector<var_t> vals{var_t{int32_t{5}},
+                          var_t{1.5},
+                          var_t{std::string("asdf")},
+                          var_t{std::string{}},
+                          var_t{std::vector<int32_t>{1, 2, 3}},
+                          var_t{std::vector<std::string>{"a", "", "bc"}}};
+  const std::string buffer = serialize_all(vals);
+
+  variant_array_view<var_t> view;
+  TEST_TRUE(view.assign(buffer.data(), buffer.size()));
+  TEST_EQ(vals.size(), view.size());
+
+  for (std::size_t i = 0; i < vals.size(); ++i) {
+    TEST_EQ(vals[i].which(), view[i].which());
+  }
+
+  describe_visitor d;
+  TEST_EQ("int 5", apply_visitor(d, view[0]));
+  TEST_EQ("double " + std::to_string(1.5), view[1].visit(d));
+  TEST_EQ("string asdf", apply_visitor(d, view[2]));
+  TEST_EQ("string ", apply_visitor(d, view[3]));
+  TEST_EQ("ints 1 2 3", apply_visitor(d, view[4]));
+  TEST_EQ("strings a  bc", apply_visitor(d, view[5]));
+}
+
+struct sum_visitor {
+  int32_t operator()(int32_t i) const { return i; }
+  int32_t operator()(const vector_ref<int32_t> & v) const {
+    int32_t result = 0;
+    for (std::size_t i = 0; i < v.size(); ++i) {
+      result += v[i];
+    }
+    return result;
+  }
+};
+
+UNIT_TEST(variant_view_random_access) {
+  using var_t = variant<int32_t, std::vector<int32_t>>;
+
+  std::vector<var_t> vals;
+  for (int32_t i = 0; i < 100; ++i) {
+    if (i % 3) {
+      vals.emplace_back(i);
+    } else {
+      vals.emplace_back(std::vector<int32_t>(static_cast<std::size_t>(i), 2));
+    }
+  }
+  const std::string buffer = serialize_all(vals);
+
+  variant_array_view<var_t> view;
+  TEST_TRUE(view.assign(buffer.data(), buffer.size()));
+  TEST_EQ(100, view.size());
+
+  for (int32_t i = 99; i >= 0; --i) {
+    TEST_EQ((i % 3 ? i : 2 * i), apply_visitor(sum_visitor{}, view[static_cast<std::size_t>(i)]));
+  }
+}
+
+UNIT_TEST(variant_view_bad_input) {
+  using var_t = variant<int32_t, std::string>;
+
+  const std::string buffer = serialize_all(std::vector<var_t>{var_t{5}, var_t{"asdf"}});
+
+  variant_array_view<var_t> view;
+  for (std::size_t n = 1; n < buffer.size(); ++n) {
+    if (n == 5) { continue; } // A complete first value
+    TEST_FALSE(view.assign(buffer.data(), n));
+    TEST_TRUE(view.empty());
+  }
+  TEST_TRUE(view.assign(buffer.data(), 5));
+  TEST_EQ(1, view.size());
+
+  // Bad tag
+  const unsigned char bad[] = {2, 0, 0, 0, 0};
+  TEST_FALSE(view.assign(bad, sizeof(bad)));
+}
+
+UNIT_TEST(variant_view_bad_bool) {
+  using var_t = variant<bool, std::vector<bool>>;
+
+  variant_array_view<var_t> view;
+  const unsigned char good[] = {0, 1, 1, 3, 1, 0, 1};
+  TEST_TRUE(view.assign(good, sizeof(good)));
+  TEST_EQ(2, view.size());
+
+  // Bools which are neither false nor true, alone and in a vector
+  const unsigned char bad[] = {0, 2};
+  TEST_FALSE(view.assign(bad, sizeof(bad)));
+  const unsigned char bad_vector[] = {1, 3, 1, 0, 2};
+  TEST_FALSE(view.assign(bad_vector, sizeof(bad_vector)));
+}
+
+// A recursive type: a tree of ints
+struct node;
+using tree_t = variant<int32_t, recursive_wrapper<node>>;
+
+struct node {
+  std::vector<tree_t> children;
+};
+
+template <>
+struct serialize_traits<node> {
+  template <typename Sink>
+  static void write(const node & n, Sink & sink) {
+    serialize_traits<std::vector<tree_t>>::write(n.children, sink);
+  }
+};
+
+template <>
+struct view_traits<node> : view_traits<std::vector<tree_t>> {};
+
+struct tree_sum {
+  int32_t operator()(int32_t i) const { return i; }
+  int32_t operator()(const vector_ref<tree_t> & children) const {
+    int32_t result = 0;
+    for (const variant_view<int32_t, recursive_wrapper<node>> & c : children) {
+      result += apply_visitor(*this, c);
+    }
+    return result;
+  }
+};
+
+UNIT_TEST(variant_view_recursive) {
+  tree_t inner{node{{tree_t{2}, tree_t{3}}}};
+  tree_t root{node{{tree_t{1}, inner, tree_t{node{}}, tree_t{4}}}};
+
+  const std::string buffer = serialize_all(std::vector<tree_t>{root, inner, tree_t{7}});
+
+  variant_array_view<tree_t> view;
+  TEST_TRUE(view.assign(buffer.data(), buffer.size()));
+  TEST_EQ(3, view.size());
+  TEST_EQ(10, apply_visitor(tree_sum{}, view[0]));
+  TEST_EQ(5, apply_visitor(tree_sum{}, view[1]));
+  TEST_EQ(7, apply_visitor(tree_sum{}, view[2]));
+}
+
+// A chain of `depth` nodes, each with one child, ending in a leaf
+std::string
+deep_chain(std::size_t depth) {
+  std::string buffer;
+  for (std::size_t i = 0; i < depth; ++i) {
+    buffer += '\1';
+    buffer += '\1';
+  }
+  serialize(tree_t{7}, buffer);
+  return buffer;
+}
+
+UNIT_TEST(variant_view_depth_limit) {
+  variant_array_view<tree_t> view;
+
+  // Each node is a variant and a vector, so 63 nodes fit in the limit of 128
+  const std::string ok = deep_chain(63);
+  TEST_TRUE(view.assign(ok.data(), ok.size()));
+  TEST_EQ(7, apply_visitor(tree_sum{}, view[0]));
+
+  const std::string deep = deep_chain(64);
+  TEST_FALSE(view.assign(deep.data(), deep.size()));
+
+  // Far too deep to check recursively
+  const std::string too_deep = deep_chain(2000000);
+  TEST_FALSE(view.assign(too_deep.data(), too_deep.size()));
+  byte_source src{too_deep.data(), too_deep.size()};
+  TEST_FALSE(view_traits<tree_t>::skip(src));
+}
+
+} // end namespace strict_variant
+
+int
+main() {
+  std::cout << "Variant view tests:" << std::endl;
+  return test_registrar::run_tests();
+}